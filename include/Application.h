@@ -1,113 +1,240 @@
 #ifndef __APPLICATION_H__
 #define __APPLICATION_H__
 
+#include <future>
+#include <string>
 #include <vector>
 
+#include "AutoTuner.h"
+#include "BrushStamps.h"
+#include "Checkpoint.h"
+#include "DisplayView.h"
+#include "FieldReadback.h"
+#include "FieldRecorder.h"
+#include "FrameGovernor.h"
+#include "GpuProfiler.h"
+#include "GpuSolver.h"
+#include "GrayScottSolver.h"
+#include "LodView.h"
+#include "Presets.h"
 #include "Profiler.h"
 #include "Shader.h"
+#include "SimulationThread.h"
+#include "StreamingTexture.h"
 #include "types.h"
 
-struct Preset {
-  std::string name;
-  f32 F, k;
-};
-
 class Application {
  private:
   // profiling
   Profiler& m_prof;
+  GpuProfiler& m_gpuProf;
 
   // opengl variables
   u32 VAO, VBO, EBO;
-  u32 FBO;                  // GPU computation
-  u32 m_concentrationTex;   // CPU method
-  u32 m_srcTex, m_destTex;  // GPU method
+  // CPU method. declared before m_simulation: its mapped buffer must outlive
+  // the simulation thread writing into it
+  StreamingTexture m_cpuTexture;
+  u32 m_cpuStorageGeneration{0};
+  // also outlives the simulation thread, which captures frames into it
+  FieldRecorder m_recorder;
 
   // screen parameters
   i32 m_windowWidth, m_windowHeight;
   i32 m_resolution, m_gridWidth, m_gridHeight;
+  // m_domainSize x m_domainSize cells, or 0 for as many cells of m_resolution
+  // pixels as fit the window
+  i32 m_domainSize{0};
+  i32 m_maxTextureSize{0};
+
+  // pan / zoom over the domain
+  Viewport m_view;
+  bool m_panning{false};
+  f64 m_cursorX{0}, m_cursorY{0};  // window pixels, y up
+  ViewRect m_requestedView;        // last one handed to the simulation thread
+  ViewRect m_cpuView;              // what m_cpuTexture holds
+  LodView m_lodView;               // GPU method, zoomed out
 
   // simulation parameters
   i32 m_stepsPerFrame{8};
+  i32 m_cpuThreads{ThreadPool::hardwareThreads()};
+  i32 m_cpuBlockDepth{1};
+  i32 m_cpuKernel{(i32)detectKernelIsa()};
+  i32 m_storagePrecision{(i32)StoragePrecision::F32};
+  bool m_activityMask{false};
+  i32 m_integrator{(i32)Integrator::Explicit};
+  f32 m_timeStep{1.0f};
+  f32 m_activityThreshold{1e-4f};
   f32 F{0.037f}, k{0.06f};
   const f32 Du = 0.16f, Dv = 0.08f;
 
   // ui controls
   float m_brushRadius;
+  i32 m_brushShape{(i32)BrushShape::Disc};
+  bool m_brushErase{false};
   bool m_isRunningOnGPU{true};
   i32 m_currentPreset;
 
+  // cursor samples of the stroke in progress, handed to the active backend
+  // once per frame
+  BrushQueue m_brush;
   bool m_isDraggingMouse{false};
-  i32 m_mousePosX, m_mousePosY;
+  f32 m_mousePosX{0}, m_mousePosY{0};  // grid cells
+
+  // core gray-scott model
+  SimulationThread m_simulation;  // CPU method, steps on its own thread
+  GpuSolver m_gpuSolver;          // GPU method
+  i32 m_gpuWorkGroup{1};          // index into WORK_GROUP_SIZES
+  i32 m_gpuFusedSteps{1};
+
+  // frame-time governor: sets m_stepsPerFrame from measured costs while on
+  bool m_governed{false};
+  FrameGovernor m_governor;
+  i32 m_governedBackend{-1};  // governor is reset when this changes
+  i32 m_governorSamples{0};   // GPU simulation timings already fed to it
+  std::string m_governorStatus;
+
+  // auto-tuning: a cached configuration per CPU, GL renderer and grid
+  TuningOptions m_tuningOptions;
+  bool m_retunePending{false};
+  std::string m_tuningStatus;
 
-  // core gray-scott model vars
-  std::vector<f32> u_conc;
-  std::vector<f32> v_conc;
+  // checkpoints
+  char m_checkpointPath[256]{"rd_checkpoint.rdc"};
+  std::string m_checkpointStatus;
+  std::future<std::string> m_checkpointResult;  // pending CPU save / load
+
+  // field recording
+  char m_recordingPath[256]{"rd_recording.rdr"};
+  RecorderOptions m_recordOptions;
+  FieldReadback m_readback;  // GPU frames on their way to m_recorder
+  std::string m_recordingStatus;
 
   // shaders
   bool m_defaultBuffersInitializated{false};
-  bool m_cpuCompTexturesInitialized{false};
-  bool m_gpuCompTexturesInitialized{false};
   Shader m_mainShader;
-  Shader m_gpuComputeShader;
 
  public:
-  Application(i32 width, i32 height, i32 res, Profiler& _profiler)
+  Application(i32 width, i32 height, i32 res, Profiler& _profiler, GpuProfiler& _gpuProfiler)
       : m_prof(_profiler),
+        m_gpuProf(_gpuProfiler),
         m_windowWidth{width},
         m_windowHeight{height},
         m_resolution{res},
         m_brushRadius{std::min(1.0f, 10.0f / res)},
-        m_mainShader(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH),
-        m_gpuComputeShader(VERTEX_SHADER_PATH, SIM_SHADER_PATH) {
+        m_simulation(width / res, height / res, GrayScottParams{F, k, Du, Dv}),
+        m_gpuSolver(width / res, height / res, GrayScottParams{F, k, Du, Dv}),
+        m_mainShader(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH) {
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxTextureSize);
+
     recalculateGrid();
+    fitView();
     resetConcentrations();
+
+    m_simulation.post([threads = m_cpuThreads](GrayScottSolver& s) { s.setThreadCount(threads); });
+    m_simulation.setProfiler(&m_prof);
+    m_simulation.setRunning(!m_isRunningOnGPU);
+
+    GovernorOptions governor;
+    governor.maxSteps = MAX_GOVERNED_STEPS;
+    m_governor.setOptions(governor);
+
+    if (!loadTuning()) retune();
   }
 
-  void computeConcentrationsCPU(f32 delta_t);
+  // hands this frame's parameters and brush stamps to the CPU simulation thread
+  void updateSimulationCPU();
   void render(bool drawUI);
 
   void resetConcentrations() {
     m_prof.restart();
 
+    // frames of another size cannot go into the same recording
+    if (m_recorder.recording() &&
+        (m_recorder.width() != m_gridWidth || m_recorder.height() != m_gridHeight))
+      stopRecording();
+
     // CPU computation
-    u_conc.assign(m_gridWidth * m_gridHeight, 1.0f);
-    v_conc.assign(m_gridWidth * m_gridHeight, 0.0f);
+    m_simulation.post([w = m_gridWidth, h = m_gridHeight](GrayScottSolver& s) {
+      if (s.width() != w || s.height() != h)
+        s.resize(w, h);
+      else
+        s.reset();
+    });
 
     // GPU computation
-    if (m_gpuCompTexturesInitialized) {
-      std::vector<float> data(m_gridWidth * m_gridHeight * 2);
-      for (int i = 0; i < m_gridWidth * m_gridHeight; ++i) {
-        data[2 * i] = 0.0f;      // initialize u with 1s
-        data[2 * i + 1] = 1.0f;  // initialize v with 0s
-      }
-
-      glBindTexture(GL_TEXTURE_2D, m_srcTex);
-      glTexSubImage2D(
-          GL_TEXTURE_2D, 0, 0, 0, m_gridWidth, m_gridHeight, GL_RG, GL_FLOAT, data.data()
-      );
-    }
+    if (m_gpuSolver.width() != m_gridWidth || m_gpuSolver.height() != m_gridHeight)
+      m_gpuSolver.resize(m_gridWidth, m_gridHeight);
+    else
+      m_gpuSolver.reset();
+
+    m_governor.reset(m_stepsPerFrame);  // costs change with the grid
+
+    // before any snapshot of the new grid, which would otherwise be all of it
+    m_requestedView =
+        visibleRect(m_view, m_windowWidth, m_windowHeight, m_gridWidth, m_gridHeight);
+    m_simulation.setView(m_requestedView);
   }
 
   void recalculateGrid() {
-    m_gridWidth = m_windowWidth / m_resolution;
-    m_gridHeight = m_windowHeight / m_resolution;
+    if (m_domainSize > 0) {
+      m_gridWidth = m_gridHeight = m_domainSize;
+    } else {
+      m_gridWidth = m_windowWidth / m_resolution;
+      m_gridHeight = m_windowHeight / m_resolution;
+    }
+  }
+
+  // the whole domain in the window: m_resolution pixels per cell when it
+  // follows the window, else centered and as large as fits
+  void fitView() {
+    if (m_domainSize == 0) {
+      m_view = Viewport{0, 0, 1.0 / m_resolution};
+      return;
+    }
+    m_view.cellsPerPixel = std::max(
+        (f64)m_gridWidth / std::max(m_windowWidth, 1),
+        (f64)m_gridHeight / std::max(m_windowHeight, 1)
+    );
+    m_view.x = (m_gridWidth - m_windowWidth * m_view.cellsPerPixel) / 2;
+    m_view.y = (m_gridHeight - m_windowHeight * m_view.cellsPerPixel) / 2;
+  }
+
+  // restarts on the grid the window, cell size and domain call for
+  void resizeGrid() {
+    recalculateGrid();
+    fitView();
+    resetConcentrations();
   }
 
+  // scroll: zooms by ZOOM_STEP per notch, keeping the cell under the cursor in place
+  void zoom(f64 notches);
+
+  // applies the cached tuning for this machine and grid; false if there is none
+  bool loadTuning();
+  // measures every backend variant on the current grid (a few seconds), applies
+  // the fastest and caches it
+  void retune();
+
+  // grid changes keep the backend and settings in use; the tuning cache is only
+  // applied at startup and by Re-tune. a fixed domain keeps running, only the
+  // view changes
   void setWindowSize(i32 w, i32 h) {
     m_windowWidth = w;
     m_windowHeight = h;
-    recalculateGrid();
-    resetConcentrations();
+    if (m_domainSize > 0) return;
+
+    resizeGrid();
   }
 
   void setResolution(i32 res) {
     m_resolution = res;
-    recalculateGrid();
+    resizeGrid();
+  }
 
-    initBuffersCPUComp();
-    initBuffersGPUComp();
-    resetConcentrations();
+  // 0 follows the window again
+  void setDomainSize(i32 size) {
+    m_domainSize = size;
+    resizeGrid();
   }
 
   void setParams(f32 _f, f32 _k) {
@@ -119,35 +246,80 @@ class Application {
   i32 getStepsPerFrame() { return m_stepsPerFrame; }
 
   bool isRunningOnGPU() { return m_isRunningOnGPU; }
-  void toggleGPUComputation() { m_isRunningOnGPU = !m_isRunningOnGPU; }
+  void toggleGPUComputation() {
+    m_isRunningOnGPU = !m_isRunningOnGPU;
+    m_simulation.setRunning(!m_isRunningOnGPU);
+  }
+
+  // saves / restores the state of the backend in use. the CPU side runs on the
+  // simulation thread, between two batches
+  void saveCheckpoint();
+  void loadCheckpoint();
 
+  // records V (and optionally U) every few steps from whichever backend runs
+  void startRecording();
+  void stopRecording();
+
+  // queues a brush sample at the cursor, unless ImGui has the mouse
   void handleMouseAction();
   bool isDraggingMouse() { return m_isDraggingMouse; }
-  void setDraggingMouse(bool dragging) { m_isDraggingMouse = dragging; }
+  void setDraggingMouse(bool dragging) {
+    m_isDraggingMouse = dragging;
+    if (dragging)
+      handleMouseAction();
+    else
+      m_brush.endStroke();
+  }
   void setMousePos(f64 x, f64 y) {
-    m_mousePosX = x / m_resolution;
-    m_mousePosY = (m_windowHeight - y) / m_resolution;
+    const f64 px = x, py = m_windowHeight - y;
+    if (m_panning) {
+      m_view.x -= (px - m_cursorX) * m_view.cellsPerPixel;
+      m_view.y -= (py - m_cursorY) * m_view.cellsPerPixel;
+    }
+    m_cursorX = px;
+    m_cursorY = py;
+
+    m_mousePosX = (f32)(m_view.x + px * m_view.cellsPerPixel);
+    m_mousePosY = (f32)(m_view.y + py * m_view.cellsPerPixel);
   }
 
+  // while held (right mouse button), cursor motion drags the view
+  void setPanning(bool panning);
+
  private:
   // gpu buffers initialization
   void initDefaultBuffers();
-  void initBuffersCPUComp();
-  void initBuffersGPUComp();
+  void resizeCPUTexture();
 
   void renderCPUComp();
   void renderGPUComp();
   void renderUI();
 
+  void applyTunedConfig(const TunedConfig& config);
+
+  // feeds this frame's costs to the governor and takes its step count (and,
+  // if allowed, its request for a coarser grid)
+  void governStepsPerFrame();
+
   void updateConcentrationTexture();
 
+  // grid.frag's view uniforms; `rect` is what the bound texture holds
+  void setDisplayUniforms(const ViewRect& rect, i32 vChannel);
+
   static constexpr char VERTEX_SHADER_PATH[] = "shaders/passthrough.vert";
   static constexpr char FRAGMENT_SHADER_PATH[] = "shaders/grid.frag";
-  static constexpr char SIM_SHADER_PATH[] = "shaders/simulation.frag";
 
-  const Preset PRESETS[6] = {Preset{"Mazes", 0.037f, 0.060f},  Preset{"Worms", 0.078f, 0.061f},
-                             Preset{"Flower", 0.055f, 0.062f}, Preset{"Waves", 0.014f, 0.045f},
-                             Preset{"Pulses", 0.025f, 0.060f}, Preset{"Holes", 0.039f, 0.058f}};
+  static constexpr i32 MAX_RESOLUTION = 20;  // cell size in pixels
+
+  // fixed domain sizes offered next to following the window (0)
+  static constexpr i32 DOMAIN_SIZES[] = {0, 1024, 2048, 4096, 8192, 16384};
+  static constexpr f64 ZOOM_STEP = 1.25;
+  static constexpr f64 MIN_CELLS_PER_PIXEL = 1.0 / 64;
+
+  // above the slider's 32: a fast GPU can fit far more steps in a frame
+  static constexpr i32 MAX_GOVERNED_STEPS = 256;
+
+  static constexpr i32 WORK_GROUP_SIZES[][2] = {{8, 8}, {16, 16}, {32, 8}, {32, 32}};
 };
 
 #endif  // __APPLICATION_H__
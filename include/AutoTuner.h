@@ -0,0 +1,90 @@
+#ifndef __AUTO_TUNER_H__
+#define __AUTO_TUNER_H__
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "StencilKernels.h"
+#include "StoragePrecision.h"
+#include "types.h"
+
+// the solver configuration the tuner settles on for one machine and grid.
+// GPU settings are plain ints (GpuBackend, work-group size) so the library
+// stays free of GL; GpuTuner and the app translate them
+struct TunedConfig {
+  bool gpu{false};
+  i32 stepsPerFrame{8};
+
+  i32 cpuThreads{1};
+  KernelIsa cpuKernel{KernelIsa::Scalar};
+  i32 cpuBlockDepth{1};
+
+  i32 gpuBackend{0};
+  i32 gpuWorkGroupX{16}, gpuWorkGroupY{16};
+  i32 gpuFusedSteps{1};
+
+  StoragePrecision precision{StoragePrecision::F32};  // of whichever backend runs
+  f64 stepsPerSecond{0};                              // measured for this config
+};
+
+// e.g. "cpu AVX2, 8 threads, block 4, fp32" or "gpu compute 16x16, fused 2, fp16"
+std::string tunedConfigName(const TunedConfig& config);
+
+// one measured variant
+struct TuningCandidate {
+  std::string name;
+  TunedConfig config;
+};
+
+struct TuningOptions {
+  i32 stepsPerFrame{8};             // frame length the candidates are timed at
+  f64 secondsPerCandidate{0.06};    // after one warmup frame
+  bool allowReducedPrecision{false};  // fp16/bf16 change results, so only on request
+  i32 warmupSteps{4000};            // see tuningState
+  f64 warmupSeconds{0.5};
+};
+
+// a tuning result is only reused on the same CPU, GL renderer and grid
+struct TuningKey {
+  std::string cpu, glRenderer;
+  i32 width{0}, height{0};
+};
+
+// "model name" from /proc/cpuinfo, "unknown" elsewhere
+std::string cpuModelName();
+
+// steps per second of `frame`, which advances stepsPerFrame steps and returns
+// once they are done (GPU callers finish the queue inside it). the best of
+// three rounds over `seconds` in total
+f64 measureStepRate(const std::function<void()>& frame, i32 stepsPerFrame, f64 seconds);
+
+// the state every candidate starts from: a seeded width x height grid advanced
+// warmupSteps (or for warmupSeconds, whichever ends first). right after seeding
+// subnormal v spreads ahead of the squares and slows fp32 several times over
+// for the first few thousand steps, which would rank the candidates on a
+// transient. tightly packed f32 planes, [u | v]
+std::vector<f32> tuningState(i32 width, i32 height, const TuningOptions& options);
+
+// times GrayScottSolver from `state` (see tuningState) over thread counts,
+// kernel ISAs, temporal block depths and (if allowed) storage precisions
+std::vector<TuningCandidate> tuneCpu(
+    i32 width, i32 height, const std::vector<f32>& state, const TuningOptions& options
+);
+
+// fastest candidate, with stepsPerFrame set so it keeps up TUNING_TARGET_FPS
+TunedConfig pickTunedConfig(const std::vector<TuningCandidate>& candidates);
+inline constexpr f64 TUNING_TARGET_FPS = 60.0;
+
+// per-host cache: a text file of one line per key, so machines sharing a home
+// directory keep separate entries. loading parses a few short lines; saving
+// replaces the entry for `key` and renames the new file into place
+bool loadTunedConfig(const char* path, const TuningKey& key, TunedConfig& config);
+bool saveTunedConfig(
+    const char* path, const TuningKey& key, const TunedConfig& config, std::string* error = nullptr
+);
+
+// where the cache lives: $XDG_CACHE_HOME or ~/.cache, else the working directory
+std::string defaultTuningCachePath();
+
+#endif  // __AUTO_TUNER_H__
@@ -0,0 +1,61 @@
+#ifndef __BRUSH_STAMPS_H__
+#define __BRUSH_STAMPS_H__
+
+#include <vector>
+
+#include "types.h"
+
+enum class BrushShape : i32 { Disc = 0, Square, Count };
+
+const char* brushShapeName(BrushShape shape);
+
+// one cursor sample while the brush is down, in grid cells
+struct BrushEvent {
+  f32 x{0}, y{0};
+  f32 radius{1};
+  BrushShape shape{BrushShape::Disc};
+  f32 u{0}, v{1};  // value written under the brush: (0, 1) seeds, (1, 0) erases
+};
+
+// the brush shape swept from (x0, y0) to (x1, y1); a dot when both ends meet
+struct BrushStamp {
+  f32 x0, y0, x1, y1;
+  f32 radius;
+  BrushShape shape;
+  f32 u, v;
+};
+
+// cells [x0, x1) of row y, set to (u, v)
+struct BrushSpan {
+  i32 y, x0, x1;
+  f32 u, v;
+};
+
+// collects brush events between frames and hands them over as stamps. every
+// sample is joined to the one before it in the stroke, so a fast stroke draws a
+// continuous line however far apart the cursor samples are; a cursor held still
+// stamps a dot once per frame. samples less than half a cell from the previous
+// one are dropped, so a slow drag does not pile up stamps
+class BrushQueue {
+ private:
+  std::vector<BrushStamp> m_stamps;  // since the last takeFrame()
+  bool m_strokeOpen{false};
+  BrushEvent m_last;  // last sample of the open stroke
+
+ public:
+  void push(const BrushEvent& event);
+  void endStroke();  // the next push starts a new stroke
+  bool strokeOpen() const { return m_strokeOpen; }
+
+  // this frame's stamps, oldest first; clears the queue
+  std::vector<BrushStamp> takeFrame();
+};
+
+// the cells `stamps` cover on a width x height grid (clipped at the edges, like
+// the rest of the input), as spans. consecutive stamps of the same value are
+// merged so every cell is written once; spans are listed in stamp order, so
+// applying them in order lets a later value win. both solvers apply the same
+// spans, which makes a stroke identical on the CPU and the GPU
+std::vector<BrushSpan> rasterizeStamps(const std::vector<BrushStamp>& stamps, i32 width, i32 height);
+
+#endif  // __BRUSH_STAMPS_H__
@@ -0,0 +1,83 @@
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <memory>
+#include <string>
+
+#include "GrayScottSolver.h"
+#include "StoragePrecision.h"
+#include "types.h"
+
+// binary snapshot of a simulation, little-endian:
+//   CheckpointHeader (64 bytes)
+//   U plane: width * height cells in `precision`, row-major, no padding
+//   V plane: same
+// the planes follow the header directly, so a mapped file can be handed to a
+// solver or a texture upload as is.
+struct CheckpointHeader {
+  char magic[8];  // CHECKPOINT_MAGIC
+  u32 version;    // CHECKPOINT_VERSION
+  u32 headerSize;
+  i32 width, height;
+  f32 F, k, Du, Dv, dt;
+  i32 precision;  // StoragePrecision
+  u64 step;
+  u8 reserved[8];
+};
+static_assert(sizeof(CheckpointHeader) == 64);
+
+inline constexpr char CHECKPOINT_MAGIC[8] = {'R', 'D', 'C', 'K', 'P', 'T', '\0', '\0'};
+inline constexpr u32 CHECKPOINT_VERSION = 1;
+
+// the state a checkpoint is written from, planes `stride` cells apart
+struct CheckpointState {
+  GrayScottParams params;
+  u64 step{0};
+  i32 width{0}, height{0}, stride{0};
+  StoragePrecision precision{StoragePrecision::F32};  // of the file; u/v are f32
+  const f32* u{nullptr};
+  const f32* v{nullptr};
+};
+
+// read-only mapping of a checkpoint file. u() and v() point into the mapping,
+// so restoring costs a single pass from the page cache into the destination.
+class Checkpoint {
+ private:
+  void* m_data{nullptr};
+  usize m_size{0};
+
+ public:
+  // null (and a reason in `error`) if the file is missing, truncated or not a
+  // checkpoint of a version this build reads
+  static std::unique_ptr<Checkpoint> open(const char* path, std::string* error = nullptr);
+  ~Checkpoint();
+
+  Checkpoint(const Checkpoint&) = delete;
+  Checkpoint& operator=(const Checkpoint&) = delete;
+
+  const CheckpointHeader& header() const { return *(const CheckpointHeader*)m_data; }
+  i32 width() const { return header().width; }
+  i32 height() const { return header().height; }
+  u64 step() const { return header().step; }
+  StoragePrecision precision() const { return (StoragePrecision)header().precision; }
+  GrayScottParams params() const;
+
+  const void* u() const { return (const u8*)m_data + header().headerSize; }
+  const void* v() const { return (const u8*)u() + planeBytes(); }
+  usize planeBytes() const { return (usize)width() * height() * storageElementSize(precision()); }
+
+  // resizes the solver to the checkpoint and restores state, step and parameters.
+  // the solver keeps its storage precision, converting on the way in if needed
+  void restore(GrayScottSolver& solver) const;
+
+ private:
+  Checkpoint(void* data, usize size) : m_data(data), m_size(size) {}
+};
+
+// written through a mapping of the new file, then renamed over `path`, so a
+// failed save never leaves a truncated checkpoint behind.
+// a solver is saved in its own storage precision
+bool saveCheckpoint(const char* path, GrayScottSolver& solver, std::string* error = nullptr);
+bool saveCheckpoint(const char* path, const CheckpointState& state, std::string* error = nullptr);
+
+#endif  // __CHECKPOINT_H__
@@ -0,0 +1,44 @@
+#ifndef __DISPLAY_VIEW_H__
+#define __DISPLAY_VIEW_H__
+
+#include "types.h"
+
+// pan / zoom: the cell at the window's bottom-left pixel and how many cells one
+// pixel spans (below 1 when zoomed in)
+struct Viewport {
+  f64 x{0}, y{0};
+  f64 cellsPerPixel{1};
+};
+
+// the cells a window shows, at a level of detail: each texel of the view
+// covers 2^level x 2^level cells. x0 and y0 are multiples of 2^level
+struct ViewRect {
+  i32 x0{0}, y0{0}, width{0}, height{0};  // cells, clipped to the grid
+  i32 level{0};
+
+  i32 texelsX() const { return (width + (1 << level) - 1) >> level; }
+  i32 texelsY() const { return (height + (1 << level) - 1) >> level; }
+
+  bool operator==(const ViewRect&) const = default;
+};
+
+// the coarsest level at which a texel still spans at most one pixel, so the
+// display never minifies (level 0 once a cell covers a pixel or more)
+i32 viewLevel(f64 cellsPerPixel);
+
+// what `view` shows of a gridWidth x gridHeight domain in a window of the
+// given size. a rect never has more texels per axis than the window has
+// pixels plus two, however large the domain
+ViewRect visibleRect(
+    const Viewport& view, i32 windowWidth, i32 windowHeight, i32 gridWidth, i32 gridHeight
+);
+
+// V over `rect`, one value per texel, rows tightly packed (rect.texelsX() per
+// row). levels 0 and 1 average every cell of a texel; coarser levels average a
+// 2x2 grid of cells spread over it, so the cost follows the texel count, not
+// the number of cells in view. shaders/lod.comp does the same on the GPU
+void reduceView(
+    const f32* v, i32 stride, i32 gridWidth, i32 gridHeight, const ViewRect& rect, f32* out
+);
+
+#endif  // __DISPLAY_VIEW_H__
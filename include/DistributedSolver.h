@@ -0,0 +1,104 @@
+#ifndef __DISTRIBUTED_SOLVER_H__
+#define __DISTRIBUTED_SOLVER_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GrayScottSolver.h"
+#include "HaloTransport.h"
+#include "types.h"
+
+// how the processes of a distributed run talk to each other
+enum class TransportKind : i32 {
+  SharedMemory = 0,  // one POSIX shm segment, processes on one node
+  Socket,            // TCP, processes anywhere
+  Count
+};
+
+const char* transportName(TransportKind kind);
+
+// rows [y0, y0 + rows) of the grid, owned by one worker
+struct Subdomain {
+  i32 y0, rows;
+};
+
+// the grid is cut into horizontal strips of (nearly) equal height, so a worker
+// trades exactly two halo rows per step, with the ranks above and below it
+Subdomain subdomain(i32 height, i32 workers, i32 rank);
+
+// every channel a run of `workers` workers on a width x height grid uses. the
+// workers are ranks 0..workers-1; the coordinator is rank `workers`
+std::vector<HaloChannel> distributedChannels(i32 width, i32 height, i32 workers);
+
+// per step() call, summed over the steps and taken from the slowest worker
+struct DistributedStepStats {
+  f64 computeSeconds{0};  // rows computed
+  f64 waitSeconds{0};     // blocked on a neighbour's halo after the interior was done
+};
+
+// coordinator of a Gray-Scott run split across worker processes.
+// every worker owns a strip of the toroidal grid with one ghost row above and
+// below. a step posts the strip's edge rows to both neighbours, computes the
+// interior rows (which need no remote data) while the halos travel, then takes
+// the neighbours' rows into its ghost rows and finishes its two edge rows.
+// results match GrayScottSolver bit for bit with the same kernel instruction set.
+// the coordinator holds no grid; it scatters an initial state, drives steps, and
+// gathers the full state back for display or a checkpoint.
+class DistributedSolver {
+ private:
+  i32 m_width, m_height, m_workers;
+  GrayScottParams m_params;
+  u64 m_step{0};
+  TransportKind m_kind;
+
+  std::unique_ptr<HaloTransport> m_transport;
+  std::vector<i32> m_children;  // pids of locally forked workers
+  std::string m_segment;        // shm segment to remove on shutdown
+  DistributedStepStats m_stats;
+
+ public:
+  // forks `workers` local worker processes and connects to them. with sockets,
+  // `endpoints` may instead list "host:port" for ranks 0..workers (the last is
+  // the coordinator); the workers are then started separately, each through
+  // runDistributedWorker(). null (and a reason in `error`) if anything failed
+  static std::unique_ptr<DistributedSolver> launch(
+      i32 width, i32 height, i32 workers, const GrayScottParams& params, TransportKind kind,
+      const std::vector<std::string>& endpoints = {}, std::string* error = nullptr
+  );
+  ~DistributedSolver();  // stops the workers and waits for local ones to exit
+
+  DistributedSolver(const DistributedSolver&) = delete;
+  DistributedSolver& operator=(const DistributedSolver&) = delete;
+
+  // full planes, cell (x, y) at u[y * stride + x]
+  bool scatter(const f32* u, const f32* v, i32 stride);
+  bool gather(f32* u, f32* v, i32 stride);
+
+  // returns once every worker has finished n steps
+  bool step(i32 n = 1);
+
+  bool setParams(const GrayScottParams& params);
+  const GrayScottParams& params() const { return m_params; }
+
+  i32 width() const { return m_width; }
+  i32 height() const { return m_height; }
+  i32 workerCount() const { return m_workers; }
+  u64 stepCount() const { return m_step; }
+  void setStepCount(u64 step) { m_step = step; }
+  TransportKind transportKind() const { return m_kind; }
+  const DistributedStepStats& lastStepStats() const { return m_stats; }
+
+ private:
+  DistributedSolver(
+      i32 width, i32 height, i32 workers, const GrayScottParams& params, TransportKind kind
+  );
+  bool command(i32 op, i32 arg);  // to every worker
+  bool childrenAlive();           // false once a local worker has exited
+};
+
+// body of a worker process: serves the coordinator's commands over `transport`
+// until told to stop. returns the process exit code
+int runDistributedWorker(HaloTransport& transport, i32 workers);
+
+#endif  // __DISTRIBUTED_SOLVER_H__
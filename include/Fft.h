@@ -0,0 +1,50 @@
+#ifndef __FFT_H__
+#define __FFT_H__
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+
+// complex discrete Fourier transform of one fixed length, in f64.
+// powers of two run an iterative radix-2 transform over precomputed twiddles;
+// any other length goes through Bluestein's algorithm, which rewrites it as a
+// circular convolution of power-of-two length >= 2n - 1, so every grid size is
+// handled in O(n log n).
+// a plan is immutable once built: several threads may transform with it at
+// once, each with its own scratch.
+class Fft {
+ public:
+  using Complex = std::complex<f64>;
+
+ private:
+  i32 m_size{0};
+
+  // radix-2 plan (of m_size, or of the convolution length for Bluestein)
+  i32 m_length{0};
+  std::vector<i32> m_bitReverse;
+  // exp(-pi i k / half) for k < half, at offset half - 1 for each level
+  std::vector<Complex> m_twiddles, m_inverseTwiddles;
+
+  // Bluestein: chirp exp(-pi i k^2 / n) and the transformed conjugate chirp
+  bool m_bluestein{false};
+  std::vector<Complex> m_chirp, m_chirpSpectrum;
+
+ public:
+  explicit Fft(i32 n);
+
+  i32 size() const { return m_size; }
+
+  // complex values of scratch a transform needs (0 for powers of two)
+  usize scratchSize() const { return m_bluestein ? (usize)m_length : 0; }
+
+  // in place; inverse() includes the 1 / n scaling
+  void forward(Complex* data, Complex* scratch) const;
+  void inverse(Complex* data, Complex* scratch) const;
+
+ private:
+  void radix2(Complex* data, bool inverse) const;  // length m_length
+};
+
+#endif  // __FFT_H__
@@ -0,0 +1,46 @@
+#ifndef __FIELD_READBACK_H__
+#define __FIELD_READBACK_H__
+
+#include <glad/glad.h>
+
+#include "FieldRecorder.h"
+#include "types.h"
+
+// feeds GPU state to a FieldRecorder without stalling the render loop.
+// capture() queues a copy of the state texture into one of SLOTS pixel-pack
+// buffers and fences it; poll() hands copies whose fence has signalled to the
+// recorder, oldest first, a frame or more later. with every buffer still in
+// flight a capture is dropped, like a frame the recorder has no room for.
+class FieldReadback {
+ public:
+  static constexpr i32 SLOTS = 4;
+
+ private:
+  struct Slot {
+    u32 buffer{0};
+    usize bytes{0};
+    GLsync fence{nullptr};
+    u64 step{0};
+    i32 width{0}, height{0};
+  };
+
+  Slot m_slots[SLOTS];
+  i32 m_head{0};   // oldest copy in flight
+  i32 m_count{0};  // copies in flight
+
+ public:
+  FieldReadback() = default;
+  ~FieldReadback();
+
+  FieldReadback(const FieldReadback&) = delete;
+  FieldReadback& operator=(const FieldReadback&) = delete;
+
+  // texture holds (r, g) = (u, v), as GpuSolver::texture()
+  void capture(u32 texture, i32 width, i32 height, u64 step, FieldRecorder& recorder);
+  void poll(FieldRecorder& recorder);
+
+  // forgets the copies in flight
+  void clear();
+};
+
+#endif  // __FIELD_READBACK_H__
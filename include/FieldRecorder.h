@@ -0,0 +1,173 @@
+#ifndef __FIELD_RECORDER_H__
+#define __FIELD_RECORDER_H__
+
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "types.h"
+
+// recording file, little-endian: a RecordingHeader, then one RecordedFrameHeader
+// plus `packedBytes` of payload per frame.
+// a frame's payload holds V (then U if recorded) quantized to `bits` over
+// [0, 1]. delta frames store each sample minus the one before it at the same
+// cell, zigzag-mapped so small changes of either sign become small bytes.
+// key frames store the samples themselves. 16-bit samples are split into a
+// plane of low bytes and one of high bytes. the result is run-length coded
+// (PackBits), which is where the mostly-zero deltas of a slowly changing field
+// collapse.
+struct RecordingHeader {
+  char magic[8];  // RECORDING_MAGIC
+  u32 version;    // RECORDING_VERSION
+  u32 headerSize;
+  i32 width, height;  // full-resolution frame size
+  i32 bits;           // 8 or 16 per sample
+  i32 fields;         // 1: V, 2: V then U
+  i32 interval;       // steps between two frames
+  u32 reserved;
+};
+static_assert(sizeof(RecordingHeader) == 40);
+
+struct RecordedFrameHeader {
+  u32 magic;  // RECORDED_FRAME_MAGIC
+  u32 flags;  // FRAME_KEY | FRAME_DOWNSAMPLED
+  u64 step;
+  i32 width, height;  // as stored; half the full size when downsampled
+  u32 rawBytes;       // quantized samples
+  u32 packedBytes;    // payload on disk
+};
+static_assert(sizeof(RecordedFrameHeader) == 32);
+
+inline constexpr char RECORDING_MAGIC[8] = {'R', 'D', 'R', 'E', 'C', '\0', '\0', '\0'};
+inline constexpr u32 RECORDING_VERSION = 1;
+inline constexpr u32 RECORDED_FRAME_MAGIC = 0x52464452;  // "RDFR"
+inline constexpr u32 FRAME_KEY = 1;
+inline constexpr u32 FRAME_DOWNSAMPLED = 2;
+
+// what happens to a frame that arrives while the writer is behind
+enum class RecorderOverflow : i32 {
+  Drop = 0,    // only when the queue is full
+  Downsample,  // store 2x2-averaged frames once the queue is half full, drop when full
+  Count
+};
+
+struct RecorderOptions {
+  i32 interval{16};  // steps between two frames
+  bool recordU{false};
+  i32 bits{8};           // 8 or 16
+  i32 queueFrames{8};    // frames buffered for the writer
+  i32 keyInterval{64};   // frames between two key frames
+  RecorderOverflow overflow{RecorderOverflow::Downsample};
+};
+
+struct RecorderStats {
+  u64 written{0};      // frames on disk
+  u64 downsampled{0};  // of those, stored at half resolution
+  u64 dropped{0};      // frames never recorded
+  u64 rawBytes{0};     // quantized size of the written frames
+  u64 fileBytes{0};
+};
+
+// streams the field to disk without holding up the simulation.
+// submit() quantizes a frame into one of a fixed pool of buffers and returns;
+// a writer thread delta-encodes, compresses and writes it. with no free
+// buffer the frame is dropped (or, past half the queue, stored downsampled),
+// so a slow disk costs frames, never steps.
+// frames come from one producer thread at a time; stop() may only be called
+// once no producer submits anymore.
+class FieldRecorder {
+ private:
+  struct Frame {
+    u64 step{0};
+    i32 width{0}, height{0};
+    bool downsampled{false};
+    std::vector<u8> samples;  // quantized V [+ U]
+  };
+
+  RecorderOptions m_options;
+  i32 m_width{0}, m_height{0};
+  std::FILE* m_file{nullptr};
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<std::unique_ptr<Frame>> m_frames;  // the pool, owns every frame
+  std::vector<Frame*> m_free;
+  std::vector<Frame*> m_queue;  // FIFO, front at index 0
+  bool m_stop{false};
+  RecorderStats m_stats;
+
+  std::thread m_writer;
+
+ public:
+  FieldRecorder() = default;
+  ~FieldRecorder() { stop(); }
+
+  FieldRecorder(const FieldRecorder&) = delete;
+  FieldRecorder& operator=(const FieldRecorder&) = delete;
+
+  // starts a new recording of width x height frames, replacing `path`
+  bool start(
+      const char* path, i32 width, i32 height, const RecorderOptions& options,
+      std::string* error = nullptr
+  );
+  // writes the queued frames and closes the file
+  void stop();
+  bool recording() const { return m_file != nullptr; }
+
+  // v (and u when recording U) hold width x height cells, rows rowStride and
+  // cells cellStride floats apart. false if the frame was dropped
+  bool submit(
+      u64 step, i32 width, i32 height, const f32* v, const f32* u, i32 rowStride,
+      i32 cellStride = 1
+  );
+  // counts a frame the producer had to give up on before submitting it
+  void noteDropped();
+
+  const RecorderOptions& options() const { return m_options; }
+  i32 width() const { return m_width; }
+  i32 height() const { return m_height; }
+  RecorderStats stats() const;
+
+ private:
+  void run();
+};
+
+// one decoded frame, in [0, 1]
+struct RecordedFrame {
+  u64 step{0};
+  i32 width{0}, height{0};
+  bool key{false}, downsampled{false};
+  std::vector<f32> v, u;  // u is empty unless U was recorded
+};
+
+// plays a recording back frame by frame
+class FieldReader {
+ private:
+  std::FILE* m_file{nullptr};
+  RecordingHeader m_header{};
+  std::vector<u8> m_packed, m_raw;
+  std::vector<u16> m_previous;  // samples of the last frame, for delta frames
+  i32 m_previousWidth{0}, m_previousHeight{0};
+
+ public:
+  // null (and a reason in `error`) if the file is missing or not a recording
+  static std::unique_ptr<FieldReader> open(const char* path, std::string* error = nullptr);
+  ~FieldReader();
+
+  FieldReader(const FieldReader&) = delete;
+  FieldReader& operator=(const FieldReader&) = delete;
+
+  const RecordingHeader& header() const { return m_header; }
+
+  // decodes the next frame; false at the end of the file or on a corrupt frame
+  bool next(RecordedFrame& frame);
+
+ private:
+  FieldReader(std::FILE* file, const RecordingHeader& header) : m_file(file), m_header(header) {}
+};
+
+#endif  // __FIELD_RECORDER_H__
@@ -0,0 +1,61 @@
+#ifndef __FRAME_GOVERNOR_H__
+#define __FRAME_GOVERNOR_H__
+
+#include "types.h"
+
+struct GovernorOptions {
+  f64 budgetMs{1000.0 / 60};
+  // dead band, as shares of the budget: a frame predicted over lowerAbove lowers
+  // the step count, one that would still fit under raiseBelow with a step more
+  // raises it. either way the new count aims at the middle of the band
+  f64 raiseBelow{0.8}, lowerAbove{1.0};
+  i32 raiseFrames{30};  // consecutive samples a raise must hold for
+  i32 lowerFrames{4};   // the same for a lower; overruns show, so these act sooner
+  i32 coarsenFrames{60};  // samples over budget at minSteps before asking for a coarser grid
+  // samples that still reflect the previous step count after a change (e.g.
+  // GPU timer queries read back frames later); they are skipped
+  i32 latency{1};
+  i32 minSteps{1}, maxSteps{32};
+  bool allowCoarsening{false};
+};
+
+// picks steps per frame so a frame fits a time budget. each frame the caller
+// reports what one step cost and what the rest of the frame cost; both are
+// smoothed, and the step count only moves once the prediction has stayed
+// outside the dead band for a run of frames, so noise does not make it hunt
+class FrameGovernor {
+ private:
+  GovernorOptions m_options;
+  i32 m_steps{8};
+  f64 m_stepMs{0}, m_otherMs{0};  // smoothed; 0 until the first sample
+  i32 m_skip{0};
+  i32 m_overFrames{0}, m_underFrames{0}, m_stuckFrames{0};
+  bool m_coarsen{false};
+
+ public:
+  explicit FrameGovernor(const GovernorOptions& options = {}) : m_options(options) {}
+
+  void setOptions(const GovernorOptions& options);
+  const GovernorOptions& options() const { return m_options; }
+
+  // starts over from `steps`, forgetting the measurements (e.g. after the grid
+  // or the backend changed)
+  void reset(i32 steps);
+
+  // one frame's measurements: milliseconds per simulation step and for
+  // everything else in the frame. returns the step count for the next frame
+  i32 update(f64 stepMs, f64 otherMs);
+
+  i32 steps() const { return m_steps; }
+  // frame time predicted at the current step count, 0 before any sample
+  f64 predictedMs() const { return m_stepMs > 0 ? m_otherMs + m_steps * m_stepMs : 0; }
+
+  // set once even minSteps has overrun the budget for coarsenFrames samples
+  // (with allowCoarsening); cleared by reset()
+  bool wantsCoarserGrid() const { return m_coarsen; }
+
+ private:
+  i32 stepsFitting(f64 share) const;  // most steps predicted within share * budget
+};
+
+#endif  // __FRAME_GOVERNOR_H__
@@ -0,0 +1,72 @@
+#ifndef __GPU_PROFILER_H__
+#define __GPU_PROFILER_H__
+
+#include "Profiler.h"
+#include "types.h"
+
+// times the GPU work submitted in the rest of the enclosing block
+#define GPU_PROFILE_SCOPE(gpuProfiler, name)                                                \
+  static const ScopeId PROFILE_CONCAT(_gpuProfileId, __LINE__) = Profiler::intern(name);    \
+  GpuProfiler::Scope PROFILE_CONCAT(_gpuProfileScope, __LINE__)(                            \
+      gpuProfiler, PROFILE_CONCAT(_gpuProfileId, __LINE__)                                  \
+  )
+
+// GPU-side scopes from GL timestamp queries (GL 3.3). a scope writes one
+// timestamp when it opens and one when it closes, so scopes can nest (unlike
+// GL_TIME_ELAPSED). queries come from a pool of FRAMES_IN_FLIGHT frames and a
+// frame is only read back when its slot comes around again, by which time the
+// GPU has finished it; the CPU never waits on a query.
+// results are shifted onto the Profiler clock and recorded on its "GPU" track,
+// so they show up in the scope table and in exported traces. render thread only.
+class GpuProfiler {
+ public:
+  static constexpr i32 FRAMES_IN_FLIGHT = 4;
+  static constexpr i32 MAX_SCOPES = 32;  // per frame, including the frame itself
+
+  class Scope {
+   private:
+    GpuProfiler& m_p;
+    i32 m_index;
+
+   public:
+    Scope(GpuProfiler& p, ScopeId id) : m_p(p), m_index(p.begin(id)) {}
+    ~Scope() { m_p.end(m_index); }
+  };
+
+ private:
+  struct Frame {
+    u32 queries[2 * MAX_SCOPES]{};  // begin / end timestamp per scope
+    ScopeId ids[MAX_SCOPES]{};
+    i32 count{0};
+    i64 offsetNs{0};  // profiler time - GPU time, sampled when the frame began
+    bool pending{false};
+  };
+
+  Profiler& m_profiler;
+  Profiler::ThreadBuffer& m_track;
+
+  Frame m_frames[FRAMES_IN_FLIGHT];
+  i32 m_current{0};
+  i32 m_frameScope{-1};
+  u64 m_lost{0};  // frames whose results were not ready in time, or scopes over MAX_SCOPES
+
+ public:
+  explicit GpuProfiler(Profiler& profiler);
+  ~GpuProfiler();
+
+  GpuProfiler(const GpuProfiler&) = delete;
+  GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+  // collects the frame issued FRAMES_IN_FLIGHT frames ago, then opens "GPU frame"
+  void beginFrame();
+  void endFrame();
+
+  u64 lostScopes() const { return m_lost; }
+
+ private:
+  i32 begin(ScopeId id);
+  void end(i32 index);
+  void collect(Frame& frame);
+};
+
+#endif  // __GPU_PROFILER_H__
@@ -0,0 +1,165 @@
+#ifndef __GPU_SOLVER_H__
+#define __GPU_SOLVER_H__
+
+#include <memory>
+
+#include <glad/glad.h>
+
+#include "BrushStamps.h"
+#include "GrayScottSolver.h"
+#include "Shader.h"
+#include "StoragePrecision.h"
+#include "types.h"
+
+enum class GpuBackend : i32 { Fragment = 0, Compute, Count };
+
+// Gray-Scott on the GPU. state lives in two RG32F (or RG16F) textures, (r, g) = (u, v),
+// that are ping-ponged every step by either a full-screen fragment pass into an
+// FBO or a compute shader working on shared-memory tiles.
+// parameters go through a uniform buffer written once per step(n) call, and
+// each texture has a pre-built FBO, so a step only costs a bind and a
+// draw/dispatch. the compute path can also fuse several steps per dispatch.
+// brush stamps are written into the current texture between steps, so the
+// shaders carry no input logic.
+// with the activity mask the compute path tracks work-group tiles at rest like
+// GrayScottSolver does: a small pass lists the tiles to compute (and those to
+// copy once as they go quiet) and the simulation is dispatched indirectly over
+// that list. the fragment path always updates every cell.
+// needs a current GL 4.5+ context; has no GLFW/ImGui dependency.
+class GpuSolver {
+ private:
+  i32 m_width{0}, m_height{0};
+  GrayScottParams m_params;
+  GpuBackend m_backend{GpuBackend::Fragment};
+  StoragePrecision m_precision{StoragePrecision::F32};
+
+  u32 VAO, VBO, EBO;
+  u32 UBO;
+  u32 m_textures[2]{};
+  u32 m_fbos[2]{};  // m_fbos[i] renders into m_textures[i]
+  i32 m_current{0};  // index of the texture holding the current state
+  u64 m_step{0};
+
+  Shader m_fragmentShader;
+  std::unique_ptr<Shader> m_computeShader;      // STEPS = m_fusedSteps
+  std::unique_ptr<Shader> m_computeTailShader;  // STEPS = 1, for the remainder
+  i32 m_workGroupX{16}, m_workGroupY{16};
+  i32 m_fusedSteps{1};
+
+  // activity mask, see simulation.comp / activity.comp
+  bool m_activityEnabled{false};
+  f32 m_activityThreshold{1e-4f};
+  bool m_activityValid{false};
+  i32 m_tilesX{0}, m_tilesY{0};
+  u32 m_tileList{0}, m_tileRest{0}, m_tileComputed{0};
+  std::unique_ptr<Shader> m_activityShader;
+
+  // computed-tile counts copied back a few frames late, so reading never stalls
+  static constexpr i32 FRACTION_SLOTS = 4;
+  u32 m_fractionBuffers[FRACTION_SLOTS]{};  // one u32 each
+  GLsync m_fractionFences[FRACTION_SLOTS]{};
+  i32 m_fractionSlot{0};
+  f64 m_activeTileFraction{1.0};
+
+ public:
+  GpuSolver(i32 width, i32 height, const GrayScottParams& params = {});
+  ~GpuSolver();
+
+  GpuSolver(const GpuSolver&) = delete;
+  GpuSolver& operator=(const GpuSolver&) = delete;
+
+  void resize(i32 width, i32 height);
+  void reset();  // u = 1, v = 0 everywhere
+
+  // uploads a width x height state, rows `stride` floats apart (e.g. GrayScottState)
+  void setState(const f32* u, const f32* v, i32 stride);
+
+  // uploads tightly packed planes in `precision` (e.g. a mapped checkpoint),
+  // interleaved in a single pass; fp16 planes go up as half floats unconverted
+  void setState(StoragePrecision precision, const void* u, const void* v);
+
+  // reads the current state back into f32 planes, rows `stride` floats apart
+  void getState(f32* u, f32* v, i32 stride);
+
+  // leaves the default framebuffer bound; the caller restores its viewport
+  void step(i32 n = 1);
+
+  // texture holding the current state
+  u32 texture() const { return m_textures[m_current]; }
+
+  // parameters
+  const GrayScottParams& params() const { return m_params; }
+  void setParams(f32 F, f32 k) {
+    m_params.F = F;
+    m_params.k = k;
+  }
+  void setDiffusion(f32 Du, f32 Dv) {
+    m_params.Du = Du;
+    m_params.Dv = Dv;
+  }
+  void setTimeStep(f32 dt) { m_params.dt = dt; }
+
+  // writes the cells the stamps cover (see rasterizeStamps) into the current
+  // state, one texture clear per span, and wakes their tiles in the activity mask
+  void applyStamps(const std::vector<BrushStamp>& stamps);
+
+  void setBackend(GpuBackend backend) {
+    if (backend != m_backend) m_activityValid = false;  // the fragment path keeps no flags
+    m_backend = backend;
+  }
+  GpuBackend backend() const { return m_backend; }
+
+  // compute backend only; both recompile the shaders when they change
+  void setWorkGroupSize(i32 x, i32 y);
+  i32 workGroupX() const { return m_workGroupX; }
+  i32 workGroupY() const { return m_workGroupY; }
+
+  // steps advanced per dispatch, using a halo of the same width
+  void setFusedSteps(i32 steps);
+  i32 fusedSteps() const { return m_fusedSteps; }
+
+  // compute backend only. threshold bounds how far a skipped cell may be from
+  // u = 1, v = 0; recompiles the compute shaders when toggled
+  void setActivityMask(bool enabled, f32 threshold = 1e-4f);
+  bool activityMask() const { return m_activityEnabled; }
+  // share of tiles computed by a recent dispatch (1 when not sparse)
+  f64 activeTileFraction() const;
+
+  // F16 stores RG16F textures; shaders still compute in fp32. GL has no bf16
+  // texture format, so BF16 falls back to F16. the current state is preserved.
+  void setStoragePrecision(StoragePrecision precision);
+  StoragePrecision storagePrecision() const { return m_precision; }
+
+  i32 width() const { return m_width; }
+  i32 height() const { return m_height; }
+
+  // steps since the last reset / resize
+  u64 stepCount() const { return m_step; }
+  void setStepCount(u64 step) { m_step = step; }
+
+  static const char* backendName(GpuBackend backend);
+
+ private:
+  u32 textureFormat() const;
+  void initTextures();
+  void destroyTextures();
+
+  void compileComputeShaders();
+  void uploadParams();
+
+  bool sparse() const { return m_activityEnabled && m_backend == GpuBackend::Compute; }
+  void resetActivity();  // (re)allocates the tile buffers, every tile active
+  void destroyActivity();
+  void readActiveTileFraction();
+
+  void stepFragment(i32 n);
+  void stepCompute(i32 n);
+  void dispatch(const Shader& program);  // one step (or fused block) of program
+
+  static constexpr char VERTEX_SHADER_PATH[] = "shaders/passthrough.vert";
+  static constexpr char SIM_SHADER_PATH[] = "shaders/simulation.frag";
+  static constexpr char SIM_COMPUTE_SHADER_PATH[] = "shaders/simulation.comp";
+  static constexpr char ACTIVITY_SHADER_PATH[] = "shaders/activity.comp";
+};
+
+#endif  // __GPU_SOLVER_H__
@@ -0,0 +1,55 @@
+#ifndef __GPU_SWEEP_H__
+#define __GPU_SWEEP_H__
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GrayScottSolver.h"
+#include "Shader.h"
+#include "SweepSolver.h"
+#include "types.h"
+
+// SweepSolver on the GPU: every (F, k) point is one layer of an RG32F texture
+// array, (r, g) = (u, v), and a single dispatch advances all layers by a step.
+// F and k come from a storage buffer indexed by layer, so the whole sweep runs
+// without any per-run state changes. needs a current GL 4.5+ context.
+class GpuSweep {
+ private:
+  i32 m_size, m_layers;
+  GrayScottParams m_shared;
+  u64 m_step{0};
+
+  u32 m_textures[2]{};
+  i32 m_current{0};
+  u32 m_points{0};  // SSBO of (F, k) per layer
+  Shader m_shader;
+
+ public:
+  // at most maxLayers() points
+  GpuSweep(i32 size, const std::vector<SweepPoint>& points, const GrayScottParams& shared = {});
+  ~GpuSweep();
+
+  GpuSweep(const GpuSweep&) = delete;
+  GpuSweep& operator=(const GpuSweep&) = delete;
+
+  // same initial field in every layer, as SweepSolver::seed
+  void seed(u32 seed);
+
+  void step(i32 n = 1);
+
+  // reads layer `run` back as row-major size x size planes
+  void copyRun(i32 run, f32* u, f32* v);
+
+  i32 size() const { return m_size; }
+  i32 runCount() const { return m_layers; }
+  u64 stepCount() const { return m_step; }
+
+  static i32 maxLayers();
+
+ private:
+  static constexpr char SWEEP_SHADER_PATH[] = "shaders/sweep.comp";
+  static constexpr i32 GROUP_SIZE = 16;  // local_size_x / _y of sweep.comp
+};
+
+#endif  // __GPU_SWEEP_H__
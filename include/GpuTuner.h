@@ -0,0 +1,22 @@
+#ifndef __GPU_TUNER_H__
+#define __GPU_TUNER_H__
+
+#include <string>
+#include <vector>
+
+#include "AutoTuner.h"
+#include "types.h"
+
+// GL_RENDERER of the current context, the GPU half of a TuningKey
+std::string glRendererName();
+
+// times a scratch GpuSolver from `state` (see tuningState): the fragment
+// path, then the compute path over work-group sizes and fused step counts,
+// and RG16F storage if reduced precision is allowed. each frame ends in
+// glFinish so the queue is drained inside the measurement. needs a current
+// GL 4.5+ context; leaves the default framebuffer bound
+std::vector<TuningCandidate> tuneGpu(
+    i32 width, i32 height, const std::vector<f32>& state, const TuningOptions& options
+);
+
+#endif  // __GPU_TUNER_H__
@@ -0,0 +1,246 @@
+#ifndef __GRAY_SCOTT_SOLVER_H__
+#define __GRAY_SCOTT_SOLVER_H__
+
+#include <memory>
+#include <vector>
+
+#include "BrushStamps.h"
+#include "Profiler.h"
+#include "SpectralStepper.h"
+#include "StencilKernels.h"
+#include "StoragePrecision.h"
+#include "ThreadPool.h"
+#include "types.h"
+
+struct GrayScottParams {
+  f32 F{0.037f}, k{0.06f};
+  f32 Du{0.16f}, Dv{0.08f};
+  f32 dt{1.0f};
+};
+
+// read-only view of the current simulation state. cell (x, y) lives at
+// u[y * stride + x]; stride >= width because rows carry ghost cells.
+struct GrayScottState {
+  const f32* u;
+  const f32* v;
+  i32 width, height, stride;
+  u64 step;
+};
+
+// headless explicit-Euler Gray-Scott solver on a toroidal grid.
+// U/V are double-buffered in a single allocation; a step writes into the back
+// buffers and swaps pointers, so stepping never touches the allocator.
+// each plane is padded with one ghost row/column on every side, refreshed from
+// the opposite edge after each step, so the stencil never wraps indices and
+// rows are walked contiguously by a SIMD kernel picked at runtime.
+// with more than one thread the grid is split into row bands over a persistent
+// pool, and the workers only meet at a barrier between consecutive steps.
+// with temporal blocking enabled, each tile is loaded with a halo as wide as the
+// block depth into per-thread scratch and advanced that many steps in cache
+// (the valid region shrinks by one cell per step, a trapezoid in time), so the
+// full grid is streamed through memory once per block instead of once per step.
+// with reduced storage precision the planes hold packed fp16/bf16 values that
+// are widened to f32 a few rows at a time; every step is computed in f32 and
+// rounded back, halving the memory traffic and footprint of the state.
+// with the activity mask enabled the grid is tracked in ACTIVITY_TILE-sized
+// tiles, and a step only computes tiles that are not at rest (every cell within
+// the threshold of the trivial state u = 1, v = 0) or border one that is not;
+// the others keep their values. at threshold 0 this is exact, since a resting
+// neighbourhood maps to itself bit for bit.
+// the integrator can be switched to a spectral one (see SpectralStepper), which
+// treats diffusion implicitly and stays stable at much larger time steps; it
+// steps the f32 planes as a whole, so blocking and the mask do not apply to it.
+class GrayScottSolver {
+ private:
+  i32 m_width{0}, m_height{0};
+  i32 m_stride{0};  // cells per padded row
+  GrayScottParams m_params;
+  u64 m_step{0};
+
+  StoragePrecision m_precision{StoragePrecision::F32};
+
+  // f32 storage: [u | v | next u | next v], each (height + 2) * stride.
+  // with packed storage it only holds an f32 view of [u | v] (see state())
+  std::vector<f32> m_storage;
+  f32 *m_u{nullptr}, *m_v{nullptr};
+  f32 *m_nextU{nullptr}, *m_nextV{nullptr};
+
+  // packed storage: [u | v | next u | next v]
+  std::vector<u16> m_packedStorage;
+  u16 *m_packedU{nullptr}, *m_packedV{nullptr};
+  u16 *m_packedNextU{nullptr}, *m_packedNextV{nullptr};
+  bool m_viewValid{false};  // f32 view matches the packed state
+  bool m_viewDirty{false};  // f32 view was handed out for writing
+
+  // kernel
+  KernelIsa m_isa{detectKernelIsa()};
+  RowKernel m_kernel{selectRowKernel(m_isa)};
+
+  // parallel backend
+  std::unique_ptr<ThreadPool> m_pool;
+  std::vector<std::vector<f32>> m_scratch;  // one per worker
+
+  // temporal blocking (depth <= 1 disables it)
+  i32 m_blockDepth{1};
+  i32 m_tileWidth{256}, m_tileHeight{128};
+
+  // activity mask: per tile, whether it was at rest after it was last computed
+  // and whether the last step computed it (else both buffers hold its values)
+  bool m_activityEnabled{false};
+  f32 m_activityThreshold{1e-4f};
+  bool m_activityValid{false};  // false after outside writes: everything is active
+  i32 m_activityTilesX{0}, m_activityTilesY{0};
+  std::vector<u8> m_tileRest, m_tileComputed;
+  std::vector<i32> m_activeTiles;  // tiles of the next step; ~index for copy-only
+  usize m_activeTileSteps{0};     // computed tiles over the last step() call
+  f64 m_activeTileFraction{1.0};
+
+  Integrator m_integrator{Integrator::Explicit};
+  std::unique_ptr<SpectralStepper> m_spectral;  // built on first use, per grid size
+
+  // optional; workers record "Solver rows" / "Solver tiles" scopes into it
+  Profiler* m_profiler{nullptr};
+
+ public:
+  GrayScottSolver(i32 width, i32 height, const GrayScottParams& params = {});
+
+  void resize(i32 width, i32 height);
+  void reset();  // u = 1, v = 0 everywhere
+
+  void step(i32 n = 1);
+
+  // with packed storage this decodes the state into an f32 view first
+  GrayScottState state();
+
+  // mutable access to the current state (for seeding / restoring), laid out
+  // like state(). ghost cells (and packed storage) are refreshed at the start
+  // of the next step.
+  f32* u();
+  f32* v();
+
+  // writes the cells the stamps cover (see rasterizeStamps) into the current
+  // state, between steps, so the stepping loops carry no input logic
+  void applyStamps(const std::vector<BrushStamp>& stamps);
+
+  // tightly packed (stride = width) planes in `precision`, e.g. a checkpoint.
+  // both copy straight between them and the solver's own storage, converting
+  // row by row when the precisions differ, so no intermediate state is built
+  void exportState(StoragePrecision precision, void* u, void* v);
+  void importState(StoragePrecision precision, const void* u, const void* v);
+  void setStepCount(u64 step) { m_step = step; }
+
+  // parameters
+  const GrayScottParams& params() const { return m_params; }
+  void setParams(f32 F, f32 k) {
+    m_params.F = F;
+    m_params.k = k;
+  }
+  void setDiffusion(f32 Du, f32 Dv) {
+    m_params.Du = Du;
+    m_params.Dv = Dv;
+  }
+  void setTimeStep(f32 dt) { m_params.dt = dt; }
+
+  void setProfiler(Profiler* profiler) {
+    m_profiler = profiler;
+    nameWorkers();
+  }
+
+  void setThreadCount(i32 threads);
+  i32 threadCount() const { return m_pool ? m_pool->threadCount() : 1; }
+
+  // clamped to what the CPU supports
+  void setKernelIsa(KernelIsa isa) {
+    m_isa = std::min(isa, detectKernelIsa());
+    m_kernel = selectRowKernel(m_isa);
+  }
+  KernelIsa kernelIsa() const { return m_isa; }
+
+  // advances `depth` steps per tile before moving on; results are bit-identical
+  // to stepping one step at a time
+  void setTemporalBlocking(i32 depth, i32 tileWidth = 256, i32 tileHeight = 128) {
+    m_blockDepth = std::max(depth, 1);
+    m_tileWidth = std::max(tileWidth, 1);
+    m_tileHeight = std::max(tileHeight, 1);
+  }
+  i32 temporalBlockDepth() const { return m_blockDepth; }
+
+  // skips tiles at rest (see above); takes precedence over temporal blocking.
+  // threshold bounds how far a skipped cell may be from u = 1, v = 0
+  void setActivityMask(bool enabled, f32 threshold = 1e-4f);
+  bool activityMask() const { return m_activityEnabled; }
+  f32 activityThreshold() const { return m_activityThreshold; }
+  // share of tiles computed by the last step() call (1 without the mask)
+  f64 activeTileFraction() const { return m_activityEnabled ? m_activeTileFraction : 1.0; }
+
+  // explicit Euler is the reference; the spectral integrators allow a dt well
+  // beyond explicitStableTimeStep()
+  void setIntegrator(Integrator integrator) { m_integrator = integrator; }
+  Integrator integrator() const { return m_integrator; }
+
+  // converts the current state to the new storage format
+  void setStoragePrecision(StoragePrecision precision);
+  StoragePrecision storagePrecision() const { return m_precision; }
+
+  static constexpr i32 ACTIVITY_TILE = 32;  // cells per side of an activity tile
+
+  i32 width() const { return m_width; }
+  i32 height() const { return m_height; }
+  i32 stride() const { return m_stride; }
+  u64 stepCount() const { return m_step; }
+
+ private:
+  bool packed() const { return m_precision != StoragePrecision::F32; }
+  void nameWorkers();  // labels the pool threads in profiler traces
+  usize planeSize() const { return (usize)m_stride * (m_height + 2); }
+
+  template <typename T>
+  T* interior(T* plane) const {
+    return plane + m_stride + 1;
+  }
+
+  void allocate();
+  void syncView();    // decodes packed storage into the f32 view
+  void commitView();  // encodes a written f32 view back into packed storage
+  void reserveScratch(usize size);  // per-worker scratch of at least `size` floats
+
+  // runs n steps as row bands, one band per worker
+  template <typename T>
+  void stepBands(i32 n, T*& u, T*& v, T*& nextU, T*& nextV);
+  template <typename T>
+  void stepBlocked(i32 n, T*& u, T*& v, T*& nextU, T*& nextV);
+  template <typename T>
+  void stepSparse(i32 n, T*& u, T*& v, T*& nextU, T*& nextV);
+  void stepSpectral(i32 n);  // on the f32 planes (the view with packed storage)
+
+  // activity mask
+  void resetActivity();     // sizes the mask, marks every tile active
+  void buildActiveTiles();  // m_activeTiles from the rest flags
+  void markActive(i32 x, i32 y);  // cell (x, y) was written from outside
+
+  // computes one activity tile and returns whether it ended at rest
+  bool stepTile(const f32* srcU, const f32* srcV, f32* dstU, f32* dstV, i32 tile) const;
+  bool stepTile(
+      const u16* srcU, const u16* srcV, u16* dstU, u16* dstV, i32 tile, f32* scratch
+  ) const;
+  template <typename T>
+  void copyTile(const T* srcU, const T* srcV, T* dstU, T* dstV, i32 tile) const;
+  void tileBounds(i32 tile, i32& x0, i32& y0, i32& tw, i32& th) const;
+  bool atRest(const f32* u, const f32* v, i32 n) const;
+
+  // computes rows [y0, y1) of (dstU, dstV) from (srcU, srcV) and refreshes the
+  // ghost cells that mirror those rows
+  void stepRows(const f32* srcU, const f32* srcV, f32* dstU, f32* dstV, i32 y0, i32 y1) const;
+  void stepRows(
+      const u16* srcU, const u16* srcV, u16* dstU, u16* dstV, i32 y0, i32 y1, f32* scratch
+  ) const;
+
+  // advances tile [x0, x0 + tw) x [y0, y0 + th) by `depth` steps from src into dst
+  template <typename T>
+  void advanceTile(
+      const T* srcU, const T* srcV, T* dstU, T* dstV, i32 x0, i32 y0, i32 tw, i32 th, i32 depth,
+      f32* scratch
+  ) const;
+};
+
+#endif  // __GRAY_SCOTT_SOLVER_H__
@@ -0,0 +1,130 @@
+#ifndef __HALO_TRANSPORT_H__
+#define __HALO_TRANSPORT_H__
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "types.h"
+
+// an ordered stream of messages from one process of a distributed run to
+// another. `tag` tells apart streams between the same pair (e.g. the halo going
+// up from the one going down, which matters when both neighbours are the same
+// process); capacity bounds the size of one message.
+struct HaloChannel {
+  i32 from, to, tag;
+  usize capacity;
+};
+
+// point-to-point messaging between the processes (ranks) of a distributed run.
+// send() returns as soon as the data is buffered, so a worker can post its
+// halos, compute everything that does not depend on them, and only then
+// receive(). messages on one (from, to, tag) channel arrive in order.
+// both return false once the transport broke (a peer went away, a message of
+// the wrong size arrived, or the liveness check failed while waiting).
+class HaloTransport {
+ protected:
+  std::function<bool()> m_alive;
+
+ public:
+  virtual ~HaloTransport() = default;
+
+  virtual i32 rank() const = 0;
+  virtual bool send(i32 to, i32 tag, const void* data, usize bytes) = 0;
+  virtual bool receive(i32 from, i32 tag, void* data, usize bytes) = 0;
+
+  // polled every 50 ms while blocked; returning false gives up the
+  // wait (e.g. the coordinator noticing a worker process died)
+  void setLivenessCheck(std::function<bool()> alive) { m_alive = std::move(alive); }
+};
+
+// POSIX shared memory: one segment holds a two-slot mailbox per channel, each
+// with a written and a consumed counter, so a message is one memcpy in and one
+// out. a waiter spins briefly, then sleeps on a futex in the mailbox until the
+// other side moves its counter, waking every 50 ms to check liveness.
+class ShmTransport final : public HaloTransport {
+ private:
+  struct Mailbox;
+
+  void* m_data{nullptr};
+  usize m_size{0};
+  i32 m_rank;
+  std::map<std::tuple<i32, i32, i32>, Mailbox*> m_channels;  // (from, to, tag)
+
+ public:
+  // creates (replacing) the segment `name` with a mailbox per channel. call it
+  // before starting the processes, and removeSegment() once all are done
+  static bool createSegment(
+      const char* name, const std::vector<HaloChannel>& channels, std::string* error = nullptr
+  );
+  static void removeSegment(const char* name);
+
+  // maps an existing segment as `rank`
+  static std::unique_ptr<ShmTransport> attach(
+      const char* name, i32 rank, std::string* error = nullptr
+  );
+  ~ShmTransport() override;
+
+  ShmTransport(const ShmTransport&) = delete;
+  ShmTransport& operator=(const ShmTransport&) = delete;
+
+  i32 rank() const override { return m_rank; }
+  bool send(i32 to, i32 tag, const void* data, usize bytes) override;
+  bool receive(i32 from, i32 tag, void* data, usize bytes) override;
+
+ private:
+  ShmTransport(void* data, usize size, i32 rank);
+  Mailbox* mailbox(i32 from, i32 to, i32 tag) const;
+};
+
+// TCP stand-in for runs across nodes: one connection per pair of peers, each
+// message framed with its tag and size. sends are queued and flushed whenever
+// the transport waits, so two neighbours sending to each other never block on
+// full socket buffers.
+class SocketTransport final : public HaloTransport {
+ private:
+  struct Peer {
+    int fd{-1};
+    std::vector<u8> outbox;  // framed bytes not yet written
+    usize outboxSent{0};
+    std::vector<u8> inbox;  // bytes read, not yet a complete frame
+  };
+
+  i32 m_rank;
+  std::map<i32, Peer> m_peers;
+  std::map<std::pair<i32, i32>, std::deque<std::vector<u8>>> m_pending;  // (from, tag)
+  bool m_broken{false};
+
+ public:
+  // endpoints[r] is "host:port" of rank r; connects to every rank in `peers`.
+  // lower ranks listen, higher ranks connect (retrying while they start up).
+  // `listener`, if given, is a socket already listening on endpoints[rank]
+  // (see listenLocal()); it is taken over and closed
+  static std::unique_ptr<SocketTransport> connect(
+      i32 rank, const std::vector<std::string>& endpoints, const std::vector<i32>& peers,
+      std::string* error = nullptr, int listener = -1
+  );
+
+  // a socket listening on a loopback port the kernel picks, so concurrent local
+  // runs never collide; `endpoint` receives its "127.0.0.1:port". -1 on failure
+  static int listenLocal(i32 backlog, std::string& endpoint, std::string* error = nullptr);
+  ~SocketTransport() override;
+
+  SocketTransport(const SocketTransport&) = delete;
+  SocketTransport& operator=(const SocketTransport&) = delete;
+
+  i32 rank() const override { return m_rank; }
+  bool send(i32 to, i32 tag, const void* data, usize bytes) override;
+  bool receive(i32 from, i32 tag, void* data, usize bytes) override;
+
+ private:
+  explicit SocketTransport(i32 rank) : m_rank(rank) {}
+  bool flush(Peer& peer);             // writes what the socket takes right now
+  bool readAvailable(i32 from, Peer& peer);  // moves complete frames to m_pending
+};
+
+#endif  // __HALO_TRANSPORT_H__
@@ -0,0 +1,38 @@
+#ifndef __LOD_VIEW_H__
+#define __LOD_VIEW_H__
+
+#include "DisplayView.h"
+#include "Shader.h"
+#include "types.h"
+
+// the GPU side of a zoomed-out display: V of the visible rect of a GpuSolver
+// state texture, reduced to the rect's level into an R32F texture (see
+// shaders/lod.comp). one pass per frame over the view's texels, which are
+// bounded by the window size, so the display cost does not grow with the
+// domain. level-0 views sample the state texture directly and need none of
+// this. needs a current GL 4.5+ context
+class LodView {
+ private:
+  u32 m_texture{0};
+  i32 m_capacityX{0}, m_capacityY{0};
+  Shader m_shader;
+
+ public:
+  LodView();
+  ~LodView();
+
+  LodView(const LodView&) = delete;
+  LodView& operator=(const LodView&) = delete;
+
+  // rect.level >= 1, rect within the gridWidth x gridHeight state
+  void update(u32 stateTexture, i32 gridWidth, i32 gridHeight, const ViewRect& rect);
+
+  // texels (0, 0) to (rect.texelsX(), rect.texelsY()) of the last update
+  u32 texture() const { return m_texture; }
+
+ private:
+  static constexpr char LOD_SHADER_PATH[] = "shaders/lod.comp";
+  static constexpr i32 GROUP_SIZE = 16;  // local_size_x / _y of lod.comp
+};
+
+#endif  // __LOD_VIEW_H__
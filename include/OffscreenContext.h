@@ -0,0 +1,40 @@
+#ifndef __OFFSCREEN_CONTEXT_H__
+#define __OFFSCREEN_CONTEXT_H__
+
+#include <string>
+
+#include <EGL/egl.h>
+
+// windowless GL 4.5+ core context over EGL, for servers and CI without a
+// display: the surfaceless Mesa platform when available (llvmpipe, render
+// nodes), else a 1x1 pbuffer on the default display. GpuSolver and GpuSweep
+// only need a current context, so they run unchanged inside one; rendering
+// goes to FBOs. no GLFW/ImGui involved.
+class OffscreenContext {
+ private:
+  EGLDisplay m_display{EGL_NO_DISPLAY};
+  EGLContext m_context{EGL_NO_CONTEXT};
+  EGLSurface m_surface{EGL_NO_SURFACE};
+  std::string m_renderer;
+
+ public:
+  OffscreenContext() = default;
+  ~OffscreenContext();
+
+  OffscreenContext(const OffscreenContext&) = delete;
+  OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+  // creates the context, makes it current on this thread and loads GL through
+  // glad. false (and a reason in `error`) if no driver offers GL 4.5 core
+  bool create(std::string* error = nullptr);
+
+  bool valid() const { return m_context != EGL_NO_CONTEXT; }
+  // GL_RENDERER, e.g. "llvmpipe (LLVM 15.0.7, 256 bits)"
+  const std::string& renderer() const { return m_renderer; }
+
+ private:
+  bool init(std::string* error);
+  void destroy();
+};
+
+#endif  // __OFFSCREEN_CONTEXT_H__
@@ -0,0 +1,123 @@
+#ifndef __OUT_OF_CORE_SOLVER_H__
+#define __OUT_OF_CORE_SOLVER_H__
+
+#include <memory>
+#include <string>
+
+#include "GrayScottSolver.h"
+#include "StencilKernels.h"
+#include "ThreadPool.h"
+#include "types.h"
+
+struct OutOfCoreOptions {
+  i32 bandRows{256};  // rows per tile
+  i32 readAhead{2};   // tiles of the source planes asked for ahead of the one being computed
+  // finished tiles whose writeback may still be in flight before a tile is
+  // waited on and dropped
+  i32 writeBehind{2};
+};
+
+// per step() call, summed over the steps
+struct OutOfCoreStats {
+  u64 bytesPrefetched{0};      // source planes handed to readahead
+  u64 bytesWritten{0};         // destination planes handed to writeback
+  usize peakResidentBytes{0};  // most bytes of the mapping not dropped at once
+  f64 computeSeconds{0};
+  f64 evictSeconds{0};  // waiting for writeback before dropping tiles
+};
+
+// explicit-Euler Gray-Scott solver whose state lives in a memory-mapped file
+// instead of memory, for grids larger than RAM. the file holds the four padded
+// planes of GrayScottSolver, [u | v | next u | next v], with the same paddedStride() and
+// ghost cells, and a step streams through them in tiles of bandRows full rows
+// (contiguous in the file): the source tiles ahead are prefetched with
+// madvise(MADV_WILLNEED), finished destination tiles are handed to writeback
+// right away, and tiles behind the window are waited on and dropped from the
+// page cache. the destination planes are hole-punched before a step, so writing
+// them does not read their old contents back in. only readAhead + writeBehind
+// tiles per plane, plus a halo row on either side, stay resident, so the grid
+// size is bounded by the disk. each step reads and writes every plane once;
+// results match GrayScottSolver bit for bit with the same kernel instruction set.
+class OutOfCoreSolver {
+ private:
+  i32 m_width, m_height;
+  i32 m_stride;  // cells per padded row
+  GrayScottParams m_params;
+  u64 m_step{0};
+  OutOfCoreOptions m_options;
+
+  int m_fd{-1};
+  u8* m_map{nullptr};
+  usize m_mapSize{0};
+  usize m_planeBytes{0};  // (height + 2) * stride cells, rounded up to a page
+  f32 *m_u{nullptr}, *m_v{nullptr};
+  f32 *m_nextU{nullptr}, *m_nextV{nullptr};
+  bool m_ghostsValid{true};  // false after writes through u() / v()
+
+  KernelIsa m_isa{detectKernelIsa()};
+  RowKernel m_kernel{selectRowKernel(m_isa)};
+  std::unique_ptr<ThreadPool> m_pool;
+
+  OutOfCoreStats m_stats;
+
+ public:
+  // creates the backing file at `path` (replacing any file there) and unlinks
+  // it once mapped, so it is freed with the solver. the state starts at
+  // u = 1, v = 0. null (and a reason in `error`) if the file cannot be
+  // created, sized or mapped
+  static std::unique_ptr<OutOfCoreSolver> create(
+      const char* path, i32 width, i32 height, const GrayScottParams& params = {},
+      const OutOfCoreOptions& options = {}, std::string* error = nullptr
+  );
+  ~OutOfCoreSolver();
+
+  OutOfCoreSolver(const OutOfCoreSolver&) = delete;
+  OutOfCoreSolver& operator=(const OutOfCoreSolver&) = delete;
+
+  void reset();  // u = 1, v = 0 everywhere, streamed like a step
+  void step(i32 n = 1);
+
+  // the current state, laid out like GrayScottSolver::state(). it points into
+  // the mapping, so reading it pages the cells in from the file
+  GrayScottState state() const;
+
+  // mutable access for seeding / restoring, laid out like state(). ghost
+  // cells are refreshed during the next step
+  f32* u();
+  f32* v();
+
+  const GrayScottParams& params() const { return m_params; }
+  void setParams(f32 F, f32 k) {
+    m_params.F = F;
+    m_params.k = k;
+  }
+  void setStepCount(u64 step) { m_step = step; }
+
+  const OutOfCoreOptions& options() const { return m_options; }
+  void setOptions(const OutOfCoreOptions& options);
+
+  // workers split each tile's rows; I/O advice is issued by the calling thread
+  void setThreadCount(i32 threads);
+  i32 threadCount() const { return m_pool ? m_pool->threadCount() : 1; }
+
+  // clamped to what the CPU supports
+  void setKernelIsa(KernelIsa isa) {
+    m_isa = std::min(isa, detectKernelIsa());
+    m_kernel = selectRowKernel(m_isa);
+  }
+  KernelIsa kernelIsa() const { return m_isa; }
+
+  i32 width() const { return m_width; }
+  i32 height() const { return m_height; }
+  i32 stride() const { return m_stride; }
+  u64 stepCount() const { return m_step; }
+  usize fileBytes() const { return m_mapSize; }
+  const OutOfCoreStats& lastStepStats() const { return m_stats; }
+
+ private:
+  OutOfCoreSolver(i32 width, i32 height, const GrayScottParams& params);
+  void stepOnce();
+  void computeRows(i32 y0, i32 y1);  // rows [y0, y1) of next from the current planes
+};
+
+#endif  // __OUT_OF_CORE_SOLVER_H__
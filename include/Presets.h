@@ -0,0 +1,19 @@
+#ifndef __PRESETS_H__
+#define __PRESETS_H__
+
+#include <string>
+
+#include "types.h"
+
+struct Preset {
+  std::string name;
+  f32 F, k;
+};
+
+inline const Preset PRESETS[6] = {
+    Preset{"Mazes", 0.037f, 0.060f}, Preset{"Worms", 0.078f, 0.061f},
+    Preset{"Flower", 0.055f, 0.062f}, Preset{"Waves", 0.014f, 0.045f},
+    Preset{"Pulses", 0.025f, 0.060f}, Preset{"Holes", 0.039f, 0.058f},
+};
+
+#endif
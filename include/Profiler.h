@@ -1,14 +1,46 @@
-
 #ifndef __PROFILER_H__
 #define __PROFILER_H__
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+// index of an interned scope name, see PROFILE_SCOPE
+using ScopeId = u32;
 
+// times the rest of the enclosing block. the name is interned once per call
+// site (function-local static), so entering a scope costs a clock read and
+// leaving it one more plus a push into the calling thread's ring buffer.
+// profiler may be a Profiler& or a Profiler* (null disables the scope)
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(profiler, name)                                                       \
+  static const ScopeId PROFILE_CONCAT(_profileId, __LINE__) = Profiler::intern(name);       \
+  Profiler::Scope PROFILE_CONCAT(_profileScope, __LINE__)(                                  \
+      profiler, PROFILE_CONCAT(_profileId, __LINE__)                                        \
+  )
+
+// scope profiler usable from any thread.
+// each thread appends finished scopes to its own single-producer ring, so no
+// locks or allocations happen on the instrumented path. the render thread
+// drains every ring in endFrame() into per-scope stats (last, average and
+// p50/p95/p99 over the last SAMPLES occurrences) and, while recording, into a
+// trace that writeTrace() saves as Chrome / Perfetto trace-event JSON.
+// GPU work is timed by GpuProfiler, which feeds a separate "GPU" track.
 struct Profiler {
-  using clock = std::chrono::high_resolution_clock;
-  static constexpr int HISTORY = 240;  // past 4s at 60 fps
+  using clock = std::chrono::steady_clock;
+  static constexpr int HISTORY = 240;            // past 4s at 60 fps
+  static constexpr u32 RING_SIZE = 1 << 14;      // events per thread between two drains
+  static constexpr int SAMPLES = 256;            // window the percentiles are taken over
+  static constexpr usize MAX_TRACE_EVENTS = 1 << 22;
 
   // frame stats
   float frametime_history[HISTORY] = {};
@@ -19,14 +51,89 @@ struct Profiler {
   int frame_count = 0;
   double avg_fps = 0.0;
 
-  // per-frame begin/end
-  clock::time_point frame_start{};
+  // simulation throughput, reported apart from the render rate since the CPU
+  // solver steps on its own thread. set by the application every frame
+  double sim_steps_per_sec = 0.0;
+  double sim_batch_ms = 0.0;  // CPU thread only: time per published batch
+  double sim_active_tiles = 1.0;  // fraction of tiles stepped, below 1 with the activity mask
+  int sim_steps_per_frame = 0;
+  double sim_budget_ms = 0.0;  // frame budget the step count is governed to, 0 when fixed
+
+  // scopes
+  struct Stat {
+    double last_ms = 0, avg_ms = 0;
+    double p50_ms = 0, p95_ms = 0, p99_ms = 0;
+    int count = 0;
+
+    float samples[SAMPLES] = {};
+    int sample_idx = 0;
+    bool dirty = false;  // percentiles are stale
+  };
 
-  void beginFrame() { frame_start = clock::now(); }
+  std::vector<Stat> scopes_stats;  // indexed by ScopeId; count == 0 if never seen
+
+  struct Event {
+    ScopeId id;
+    i64 begin_ns, end_ns;  // since the profiler was created
+  };
+
+  struct TraceEvent {
+    Event event;
+    u32 thread;
+  };
+
+  // one per thread that ever recorded a scope; only that thread pushes
+  struct ThreadBuffer {
+    Event events[RING_SIZE];
+    std::atomic<u32> head{0}, tail{0};
+    std::atomic<u64> dropped{0};  // events lost to a full ring
+    std::string name;             // guarded by m_threadsMutex
+  };
+
+  struct Scope {
+    Profiler* p;
+    ScopeId id;
+    i64 t0;
+
+    Scope(Profiler& _p, ScopeId _id) : p(&_p), id(_id), t0(_p.now()) {}
+    Scope(Profiler* _p, ScopeId _id) : p(_p), id(_id), t0(_p ? _p->now() : 0) {}
+
+    ~Scope() {
+      if (p) p->record(id, t0, p->now());
+    }
+  };
+
+ private:
+  clock::time_point m_origin{clock::now()};
+  i64 m_frameStart = 0;
+  u64 m_instance{nextInstance()};
+
+  std::mutex m_threadsMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_threads;
+
+  bool m_tracing = false;
+  std::vector<TraceEvent> m_trace;
+
+ public:
+  Profiler() = default;
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  i64 now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_origin).count();
+  }
+
+  // per-frame begin/end, render thread only
+  void beginFrame() { m_frameStart = now(); }
 
   void endFrame() {
-    auto end = clock::now();
-    frametime = std::chrono::duration<double, std::milli>(end - frame_start).count();
+    static const ScopeId FRAME = intern("Frame");
+
+    i64 end = now();
+    record(FRAME, m_frameStart, end);
+    drain();
+
+    frametime = (end - m_frameStart) / 1e6;
     frametime_history[history_idx] = (float)frametime;
     history_idx = (history_idx + 1) % HISTORY;
 
@@ -36,7 +143,7 @@ struct Profiler {
   }
 
   void restart() {
-    frame_start = clock::now();
+    m_frameStart = now();
 
     std::fill_n(frametime_history, HISTORY, 0.0f);
 
@@ -47,34 +154,198 @@ struct Profiler {
 
     history_idx = 0;
 
+    sim_steps_per_sec = 0.0;
+    sim_batch_ms = 0.0;
+    sim_active_tiles = 1.0;
+    sim_steps_per_frame = 0;
+    sim_budget_ms = 0.0;
+
     scopes_stats.clear();
   }
 
-  // scopes
-  struct Stat {
-    double last_ms = 0, avg_ms = 0;
-    int count = 0;
-  };
+  // stats of one scope as of the last endFrame(), null if it never ran
+  const Stat* stat(ScopeId id) const {
+    return id < scopes_stats.size() && scopes_stats[id].count > 0 ? &scopes_stats[id] : nullptr;
+  }
 
-  std::unordered_map<std::string, Stat> scopes_stats;
+  void record(ScopeId id, i64 begin, i64 end) { record(threadBuffer(), id, begin, end); }
 
-  struct Scope {
-    Profiler& p;
-    const char* name;
-    clock::time_point t0;
+  // events timed elsewhere (e.g. GPU queries) go to their own named track; a
+  // track must be fed by one thread at a time
+  ThreadBuffer& createTrack(const char* name) {
+    std::lock_guard lock(m_threadsMutex);
+    m_threads.push_back(std::make_unique<ThreadBuffer>());
+    m_threads.back()->name = name;
+    return *m_threads.back();
+  }
 
-    Scope(Profiler& _p, const char* n) : p(_p), name(n), t0(clock::now()) {}
+  void record(ThreadBuffer& b, ScopeId id, i64 begin, i64 end) {
+    u32 head = b.head.load(std::memory_order_relaxed);
+    if (head - b.tail.load(std::memory_order_acquire) >= RING_SIZE) {
+      b.dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
 
-    ~Scope() {
-      auto dt = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
-      auto& s = p.scopes_stats[name];
+    b.events[head % RING_SIZE] = Event{id, begin, end};
+    b.head.store(head + 1, std::memory_order_release);
+  }
 
-      s.last_ms = dt;
-      s.count++;
-      s.avg_ms = (s.avg_ms * (s.count - 1) + dt) / s.count;
+  // names the calling thread in traces
+  void setThreadName(const char* name) {
+    ThreadBuffer& b = threadBuffer();
+    std::lock_guard lock(m_threadsMutex);
+    b.name = name;
+  }
+
+  u64 droppedEvents() {
+    std::lock_guard lock(m_threadsMutex);
+    u64 dropped = 0;
+    for (auto& b : m_threads) dropped += b->dropped.load(std::memory_order_relaxed);
+    return dropped;
+  }
+
+  // trace recording, render thread only
+  void startTrace() {
+    m_trace.clear();
+    m_tracing = true;
+  }
+  bool isTracing() const { return m_tracing; }
+  usize traceEventCount() const { return m_trace.size(); }
+
+  // stops recording and writes the trace; load it in chrome://tracing or ui.perfetto.dev
+  bool writeTrace(const char* path) {
+    m_tracing = false;
+
+    std::FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+
+    std::fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    {
+      std::lock_guard lock(m_threadsMutex);
+      for (usize t = 0; t < m_threads.size(); ++t) {
+        std::string name =
+            m_threads[t]->name.empty() ? "Thread " + std::to_string(t) : m_threads[t]->name;
+        std::fprintf(
+            f,
+            "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %zu, "
+            "\"args\": {\"name\": \"%s\"}},\n",
+            t, name.c_str()
+        );
+      }
     }
+
+    for (usize i = 0; i < m_trace.size(); ++i) {
+      const TraceEvent& e = m_trace[i];
+      std::fprintf(
+          f,
+          "{\"name\": \"%s\", \"cat\": \"rd\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+          "\"ts\": %.3f, \"dur\": %.3f}%s\n",
+          scopeName(e.event.id), e.thread, e.event.begin_ns / 1e3,
+          (e.event.end_ns - e.event.begin_ns) / 1e3, i + 1 < m_trace.size() ? "," : ""
+      );
+    }
+
+    std::fprintf(f, "]}\n");
+    return std::fclose(f) == 0;
+  }
+
+  // scope names, shared by all profilers
+  static ScopeId intern(const char* name) {
+    Names& n = names();
+    std::lock_guard lock(n.mutex);
+
+    for (usize i = 0; i < n.list.size(); ++i)
+      if (n.list[i] == name) return (ScopeId)i;
+
+    n.list.emplace_back(name);
+    return (ScopeId)(n.list.size() - 1);
+  }
+
+  static const char* scopeName(ScopeId id) {
+    Names& n = names();
+    std::lock_guard lock(n.mutex);
+    return n.list[id].c_str();  // deque: references stay valid
+  }
+
+ private:
+  struct Names {
+    std::mutex mutex;
+    std::deque<std::string> list;
   };
+
+  static Names& names() {
+    static Names n;
+    return n;
+  }
+
+  static u64 nextInstance() {
+    static std::atomic<u64> counter{0};
+    return ++counter;
+  }
+
+  ThreadBuffer& threadBuffer() {
+    // cached per thread; the instance id guards against a new profiler at the same address
+    thread_local u64 owner = 0;
+    thread_local ThreadBuffer* buffer = nullptr;
+
+    if (owner != m_instance) {
+      std::lock_guard lock(m_threadsMutex);
+      m_threads.push_back(std::make_unique<ThreadBuffer>());
+      buffer = m_threads.back().get();
+      owner = m_instance;
+    }
+    return *buffer;
+  }
+
+  void drain() {
+    std::lock_guard lock(m_threadsMutex);
+
+    for (usize t = 0; t < m_threads.size(); ++t) {
+      ThreadBuffer& b = *m_threads[t];
+      u32 tail = b.tail.load(std::memory_order_relaxed);
+      u32 head = b.head.load(std::memory_order_acquire);
+
+      for (; tail != head; ++tail) {
+        const Event& e = b.events[tail % RING_SIZE];
+        addSample(e);
+        if (m_tracing && m_trace.size() < MAX_TRACE_EVENTS) m_trace.push_back({e, (u32)t});
+      }
+
+      b.tail.store(tail, std::memory_order_release);
+    }
+
+    for (Stat& s : scopes_stats) {
+      if (s.dirty) updatePercentiles(s);
+    }
+  }
+
+  void addSample(const Event& e) {
+    if (e.id >= scopes_stats.size()) scopes_stats.resize(e.id + 1);
+
+    Stat& s = scopes_stats[e.id];
+    double dt = (e.end_ns - e.begin_ns) / 1e6;
+
+    s.last_ms = dt;
+    s.count++;
+    s.avg_ms = (s.avg_ms * (s.count - 1) + dt) / s.count;
+
+    s.samples[s.sample_idx] = (float)dt;
+    s.sample_idx = (s.sample_idx + 1) % SAMPLES;
+    s.dirty = true;
+  }
+
+  static void updatePercentiles(Stat& s) {
+    int n = std::min(s.count, SAMPLES);
+    float sorted[SAMPLES];
+    std::copy_n(s.samples, n, sorted);
+    std::sort(sorted, sorted + n);
+
+    auto at = [&](double q) { return (double)sorted[std::min(n - 1, (int)(q * n))]; };
+    s.p50_ms = at(0.50);
+    s.p95_ms = at(0.95);
+    s.p99_ms = at(0.99);
+    s.dirty = false;
+  }
 };
 
 #endif
-
@@ -5,6 +5,9 @@
 
 #include "Profiler.h"
 
+// where the 'T' key and the overlay button save Chrome trace-event JSON
+inline constexpr char TRACE_PATH[] = "rd_trace.json";
+
 inline void DrawProfilerImGui(Profiler& prof) {
   ImGuiIO& io = ImGui::GetIO();
   const float PAD = 10.0f;
@@ -19,21 +22,60 @@ inline void DrawProfilerImGui(Profiler& prof) {
     float frametime = (float)prof.frametime;
     float fps = frametime > 0 ? 1000.0f / frametime : 0.0f;
 
-    ImGui::Text("FPS: %.1f  (avg %.1f)", fps, (float)prof.avg_fps);
+    // simulation throughput is the headline; render FPS says little on its own
+    // once the step count follows a frame budget
+    ImGui::SetWindowFontScale(1.6f);
+    ImGui::Text("%.0f steps/s", prof.sim_steps_per_sec);
+    ImGui::SetWindowFontScale(1.0f);
+    if (prof.sim_budget_ms > 0)
+      ImGui::Text(
+          "%d steps/frame, governed to %.1f ms", prof.sim_steps_per_frame, prof.sim_budget_ms
+      );
+    else
+      ImGui::Text("%d steps/frame", prof.sim_steps_per_frame);
+
+    ImGui::Text("Render FPS: %.1f  (avg %.1f)", fps, (float)prof.avg_fps);
     ImGui::Text("Frametime: %.2f ms", frametime);
+    if (prof.sim_batch_ms > 0) ImGui::Text("Sim batch: %.2f ms", prof.sim_batch_ms);
+    if (prof.sim_active_tiles < 1.0)
+      ImGui::Text("Active tiles: %.1f%%", prof.sim_active_tiles * 100.0);
     ImGui::PlotLines(
         "Frametime (ms)", prof.frametime_history, Profiler::HISTORY, prof.history_idx, nullptr,
         0.0f, 50.0f, ImVec2(260, 60)
     );
 
     if (ImGui::CollapsingHeader("Sections", ImGuiTreeNodeFlags_DefaultOpen)) {
-      for (auto& kv : prof.scopes_stats) {
-        const auto& name = kv.first;
-        const auto& s = kv.second;
-        ImGui::Text(
-            "%s last: %6.2f ms  avg: %6.2f  (n=%d)", name.c_str(), s.last_ms, s.avg_ms, s.count
-        );
+      if (ImGui::BeginTable("scopes", 6, ImGuiTableFlags_SizingFixedFit)) {
+        for (const char* header : {"Scope (ms)", "last", "p50", "p95", "p99", "n"})
+          ImGui::TableSetupColumn(header);
+        ImGui::TableHeadersRow();
+
+        for (ScopeId id = 0; id < prof.scopes_stats.size(); ++id) {
+          const auto& s = prof.scopes_stats[id];
+          if (s.count == 0) continue;
+
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(Profiler::scopeName(id));
+          for (double ms : {s.last_ms, s.p50_ms, s.p95_ms, s.p99_ms}) {
+            ImGui::TableNextColumn();
+            ImGui::Text("%6.2f", ms);
+          }
+          ImGui::TableNextColumn();
+          ImGui::Text("%d", s.count);
+        }
+        ImGui::EndTable();
       }
+
+      if (u64 dropped = prof.droppedEvents())
+        ImGui::Text("Dropped events: %llu", (unsigned long long)dropped);
+    }
+
+    if (!prof.isTracing()) {
+      if (ImGui::Button("Record trace (T)")) prof.startTrace();
+    } else {
+      ImGui::Text("Recording trace: %zu events", prof.traceEventCount());
+      if (ImGui::Button("Save trace (T)")) prof.writeTrace(TRACE_PATH);
     }
   }
   ImGui::End();
@@ -0,0 +1,15 @@
+#ifndef __QUAD_H__
+#define __QUAD_H__
+
+#include "types.h"
+
+// full-screen quad in NDC (two triangles), used by the display and simulation passes
+constexpr f32 QUAD_VERTICES[] = {
+    -1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, -1.0f, 0.0f, -1.0f, -1.0f, 0.0f,
+};
+
+constexpr u32 QUAD_INDICES[] = {
+    0, 1, 3, 1, 2, 3,
+};
+
+#endif
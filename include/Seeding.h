@@ -0,0 +1,17 @@
+#ifndef __SEEDING_H__
+#define __SEEDING_H__
+
+#include "GrayScottSolver.h"
+#include "types.h"
+
+// deterministic initial condition for headless runs: `count` squares of side
+// `size` with (u, v) = (0.5, 0.25) plus a little noise, placed from `seed`.
+// the same seed gives the same field on every platform.
+void seedSquares(GrayScottSolver& solver, u32 seed, i32 count = 12, i32 size = 10);
+
+// same field written to plain row-major planes (stride = width)
+void seedSquares(
+    f32* u, f32* v, i32 width, i32 height, i32 stride, u32 seed, i32 count = 12, i32 size = 10
+);
+
+#endif
@@ -10,6 +10,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "types.h"
+
 class Shader {
  private:
   GLuint m_id;
@@ -59,11 +61,43 @@ class Shader {
     glDeleteShader(fragmentId);
   }
 
+  // compute program; `defines` is inserted right after the #version line
+  static Shader compute(const char *computePath, const std::string &defines = "") {
+    std::ifstream computeFile{computePath};
+
+    if (!computeFile) std::cerr << "ERROR::SHADER::COMPUTE::FILE_NOT_READ" << std::endl;
+
+    std::stringstream computeStream;
+    computeStream << computeFile.rdbuf();
+
+    std::string computeCode{computeStream.str()};
+    usize versionEnd = computeCode.find('\n');
+    computeCode.insert(versionEnd == std::string::npos ? 0 : versionEnd + 1, defines);
+
+    const char *computeShader{computeCode.c_str()};
+
+    GLuint computeId{glCreateShader(GL_COMPUTE_SHADER)};
+    glShaderSource(computeId, 1, &computeShader, NULL);
+    glCompileShader(computeId);
+
+    Shader program{glCreateProgram()};
+    program.checkShaderCompileErrors(computeId, "COMPUTE");
+
+    glAttachShader(program.m_id, computeId);
+    glLinkProgram(program.m_id);
+    program.checkShaderCompileErrors(program.m_id, "PROGRAM");
+
+    glDeleteShader(computeId);
+
+    return program;
+  }
+
   Shader(const Shader &s) : m_id{s.m_id} {}
 
   Shader(const Shader &&s) : m_id{std::move(s.m_id)} {}
 
   void use() const { glUseProgram(m_id); }
+  GLuint id() const { return m_id; }
 
   void setBool(const std::string &name, bool value) const {
     glUniform1i(glGetUniformLocation(m_id, name.c_str()), (int)value);
@@ -77,6 +111,10 @@ class Shader {
     glUniform1f(glGetUniformLocation(m_id, name.c_str()), value);
   }
 
+  void setIVec2(const std::string &name, int x, int y) const {
+    glUniform2i(glGetUniformLocation(m_id, name.c_str()), x, y);
+  }
+
   void setVec2(const std::string &name, const glm::vec2 &value) const {
     glUniform2fv(glGetUniformLocation(m_id, name.c_str()), 1, &value[0]);
   }
@@ -111,6 +149,8 @@ class Shader {
   }
 
  private:
+  explicit Shader(GLuint id) : m_id{id} {}
+
   void checkShaderCompileErrors(GLuint shader, std::string_view type) {
     GLint success;
     GLchar infoLog[1024];
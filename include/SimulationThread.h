@@ -0,0 +1,136 @@
+#ifndef __SIMULATION_THREAD_H__
+#define __SIMULATION_THREAD_H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DisplayView.h"
+#include "FieldRecorder.h"
+#include "GrayScottSolver.h"
+#include "TripleBuffer.h"
+#include "types.h"
+
+// runs a GrayScottSolver on its own thread, decoupled from the render loop.
+// the solver steps continuously in batches and publishes V after every batch
+// through a triple buffer, so the renderer picks up the latest complete state
+// without ever blocking on the simulation. only the part of V the window shows
+// is published, reduced to its level of detail (see setView).
+// the solver is only touched by the simulation thread: settings and discrete
+// input (brush stamps, resets) are queued with post(); per-frame controls (F/k)
+// are latched with setControls() and apply from the next batch on.
+class SimulationThread {
+ public:
+  using Command = std::function<void(GrayScottSolver&)>;
+
+  struct Controls {
+    GrayScottParams params;
+  };
+
+  // V over `view`, one value per texel, tightly packed (stride == width). v
+  // points either into storage or, when external storage is attached and
+  // large enough, into its slot
+  struct Snapshot {
+    std::vector<f32> storage;
+    const f32* v{nullptr};
+    i32 width{0}, height{0};  // texels: view.texelsX() x view.texelsY()
+    ViewRect view;
+    u64 step{0};
+    bool external{false};
+    u32 storageGeneration{0};  // setSnapshotStorage() call v was written under
+  };
+
+  static constexpr i32 SNAPSHOT_SLOTS = 3;
+
+ private:
+  GrayScottSolver m_solver;
+  TripleBuffer<Snapshot> m_snapshots;
+
+  std::mutex m_storageMutex;  // held while a snapshot is written
+  f32* m_externalSlots[SNAPSHOT_SLOTS]{};
+  usize m_externalCapacity{0};
+  u32 m_storageGeneration{0};
+
+  std::mutex m_recorderMutex;  // held while a frame is captured
+  FieldRecorder* m_recorder{nullptr};
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<Command> m_commands;
+  Controls m_controls;
+  bool m_controlsChanged{false};
+  bool m_running{false};
+  bool m_stop{false};
+
+  Profiler* m_profiler{nullptr};  // simulation thread only
+  ViewRect m_view;                // simulation thread only
+  bool m_viewSet{false};
+
+  std::atomic<i32> m_stepsPerBatch{8};
+  std::atomic<f64> m_stepsPerSecond{0};
+  std::atomic<f64> m_batchMs{0};
+  std::atomic<f64> m_activeTileFraction{1};
+
+  std::thread m_thread;  // last, starts once everything above is initialized
+
+ public:
+  SimulationThread(i32 width, i32 height, const GrayScottParams& params = {});
+  ~SimulationThread();
+
+  SimulationThread(const SimulationThread&) = delete;
+  SimulationThread& operator=(const SimulationThread&) = delete;
+
+  // runs command on the simulation thread before the next batch, then republishes
+  void post(Command command);
+  void setControls(const Controls& controls);
+
+  // records batch / publish scopes and the solver workers' scopes
+  void setProfiler(Profiler* profiler);
+
+  // the cells and level of detail snapshots cover (see visibleRect); the whole
+  // grid at level 0 until set. clipped to the grid when published
+  void setView(const ViewRect& view);
+
+  // steps advanced between two published snapshots
+  void setStepsPerBatch(i32 steps) { m_stepsPerBatch.store(std::max(steps, 1)); }
+
+  // a paused thread sleeps, but still executes posted commands
+  void setRunning(bool running);
+
+  // reader side. acquire() swaps in the newest snapshot and returns true if
+  // snapshot() changed; the slot it replaces may be rewritten right away, so
+  // anything still reading it (e.g. a GPU upload) must be finished first
+  bool hasNewSnapshot() const { return m_snapshots.pending(); }
+  bool acquire() { return m_snapshots.acquire(); }
+  const Snapshot& snapshot() const { return m_snapshots.front(); }
+  i32 snapshotSlot() const { return (i32)m_snapshots.frontIndex(); }
+
+  // writes snapshot slot i into slots[i] (slotCapacity floats each, e.g. a
+  // mapped pixel buffer) instead of owned memory; nullptr detaches. waits for
+  // an in-flight write, so the old memory can be released once this returns.
+  // returns the generation snapshots written into the new storage carry
+  u32 setSnapshotStorage(f32* const* slots, usize slotCapacity);
+
+  // captures a frame into the recorder every recorder->options().interval
+  // steps; batches are cut short so they end on those steps. nullptr detaches,
+  // waiting for an in-flight capture, so the recorder can be stopped after
+  void setRecorder(FieldRecorder* recorder);
+
+  // throughput of the simulation thread alone, 0 while paused
+  f64 stepsPerSecond() const { return m_stepsPerSecond.load(std::memory_order_relaxed); }
+  f64 batchMs() const { return m_batchMs.load(std::memory_order_relaxed); }
+  // share of tiles the last batch stepped (see GrayScottSolver::setActivityMask)
+  f64 activeTileFraction() const { return m_activeTileFraction.load(std::memory_order_relaxed); }
+
+ private:
+  void run();
+  void publish();
+  i32 stepsUntilCapture(i32 steps);  // clamps a batch to the next capture step
+  void capture();
+};
+
+#endif  // __SIMULATION_THREAD_H__
@@ -0,0 +1,81 @@
+#ifndef __SPECTRAL_STEPPER_H__
+#define __SPECTRAL_STEPPER_H__
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "Fft.h"
+#include "ThreadPool.h"
+#include "types.h"
+
+struct GrayScottParams;
+
+// how GrayScottSolver advances a step
+enum class Integrator : i32 {
+  Explicit = 0,  // forward Euler on the 5-point stencil (the reference)
+  Imex,          // implicit diffusion, explicit reaction (semi-implicit Euler)
+  Etd,           // exact diffusion, reaction held constant over the step (ETD1)
+  Count
+};
+
+const char* integratorName(Integrator integrator);
+
+// largest time step forward Euler keeps the 5-point diffusion term stable at
+inline f32 explicitStableTimeStep(f32 Du, f32 Dv) { return 0.25f / std::max({Du, Dv, 1e-6f}); }
+
+// the non-explicit integrators. diffusion is diagonal in Fourier space on the
+// periodic grid, with the eigenvalues of the same 5-point Laplacian the
+// explicit kernels use, so at small dt all three agree. the reaction terms are
+// evaluated in real space once per step.
+// U and V are transformed together as the complex field u + i v: both are
+// real, so their spectra can be told apart by symmetry, and a step costs one
+// forward and one inverse 2D FFT (ETD1: two forward).
+class SpectralStepper {
+ public:
+  using Complex = Fft::Complex;
+
+  // called once per output row, by the worker that wrote it
+  using RowFn = std::function<void(f32* u, f32* v, i32 y)>;
+
+ private:
+  i32 m_width, m_height;
+  Integrator m_integrator;
+  Fft m_rowFft, m_columnFft;
+
+  // eigenvalues of the 5-point Laplacian along x and along y
+  std::vector<f64> m_eigenX, m_eigenY;
+
+  // per mode: the new packed spectrum is p0 Z + q0 conj(Z(-k)) (+ p1 R + q1 conj(R(-k))
+  // for ETD1), built for the time step and diffusion rates below
+  std::vector<f64> m_p0, m_q0, m_p1, m_q1;
+  f32 m_dt{-1}, m_Du{-1}, m_Dv{-1};
+
+  std::vector<Complex> m_field, m_reaction, m_next;
+  std::vector<std::vector<Complex>> m_scratch;  // per worker: column batch + FFT scratch
+
+  static constexpr i32 COLUMN_BATCH = 4;  // columns gathered per pass (one cache line)
+
+ public:
+  SpectralStepper(i32 width, i32 height, Integrator integrator);
+
+  i32 width() const { return m_width; }
+  i32 height() const { return m_height; }
+  Integrator integrator() const { return m_integrator; }
+
+  // one step of the interior planes u / v (rows `stride` floats apart), in place.
+  // values are clamped at 0 like the explicit kernels do
+  void step(
+      f32* u, f32* v, i32 stride, const GrayScottParams& params, ThreadPool* pool,
+      const RowFn& finishRow
+  );
+
+ private:
+  void buildMultipliers(const GrayScottParams& params);
+
+  // 2D transforms of rows [y0, y1) / columns [x0, x1) of a width x height field
+  void transformRows(Complex* field, i32 y0, i32 y1, bool inverse, Complex* scratch) const;
+  void transformColumns(Complex* field, i32 x0, i32 x1, bool inverse, Complex* scratch) const;
+};
+
+#endif  // __SPECTRAL_STEPPER_H__
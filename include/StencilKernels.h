@@ -0,0 +1,36 @@
+#ifndef __STENCIL_KERNELS_H__
+#define __STENCIL_KERNELS_H__
+
+#include "types.h"
+
+struct GrayScottParams;
+
+// instruction sets the row kernel can be compiled for, in increasing order
+enum class KernelIsa : i32 { Scalar = 0, SSE, AVX2, AVX512, Count };
+
+// one row of the padded grid. pointers address interior x = 0, so [-1] and
+// [width] are the ghost cells holding the toroidal neighbours.
+struct StencilRow {
+  const f32 *u, *uUp, *uDown;
+  const f32 *v, *vUp, *vDown;
+  f32 *dstU, *dstV;
+};
+
+// cells per row of a padded plane: the interior plus a ghost cell on either side,
+// rounded up to a cache line. every solver sharing the kernels lays rows out this way
+inline constexpr i32 ROW_ALIGN = 16;
+constexpr i32 paddedStride(i32 width) {
+  return (width + 2 + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN;
+}
+
+using RowKernel = void (*)(const StencilRow& row, i32 width, const GrayScottParams& p);
+
+// best instruction set supported by this CPU (queried once through CPUID)
+KernelIsa detectKernelIsa();
+
+// kernel for `isa`, clamped to what the CPU supports
+RowKernel selectRowKernel(KernelIsa isa);
+
+const char* kernelIsaName(KernelIsa isa);
+
+#endif  // __STENCIL_KERNELS_H__
@@ -0,0 +1,26 @@
+#ifndef __STORAGE_PRECISION_H__
+#define __STORAGE_PRECISION_H__
+
+#include "types.h"
+
+// how U/V are stored between steps. compute is always done in f32.
+enum class StoragePrecision : i32 { F32 = 0, F16, BF16, Count };
+
+// f16 <-> f32 and bf16 <-> f32 rows, rounding to nearest even. uses F16C / AVX2
+// when the CPU has them; every path produces the same bits.
+void decodeRow(StoragePrecision p, const u16* src, f32* dst, i32 n);
+void encodeRow(StoragePrecision p, const f32* src, u16* dst, i32 n);
+
+// rounds a f32 row to what storing it in precision `p` would give back
+void quantizeRow(StoragePrecision p, f32* row, i32 n);
+
+u16 encodeValue(StoragePrecision p, f32 value);
+f32 decodeValue(StoragePrecision p, u16 value);
+
+const char* storagePrecisionName(StoragePrecision p);
+
+inline usize storageElementSize(StoragePrecision p) {
+  return p == StoragePrecision::F32 ? sizeof(f32) : sizeof(u16);
+}
+
+#endif  // __STORAGE_PRECISION_H__
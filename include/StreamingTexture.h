@@ -0,0 +1,55 @@
+#ifndef __STREAMING_TEXTURE_H__
+#define __STREAMING_TEXTURE_H__
+
+#include <glad/glad.h>
+
+#include "types.h"
+
+// R32F texture streamed from the CPU solver. with GL 4.4 (buffer storage) it owns
+// one pixel buffer split into SLOTS regions that stay persistently mapped, so
+// the simulation thread writes snapshots straight into memory the driver
+// uploads from: upload() only queues an asynchronous PBO -> texture transfer
+// and fences the slot, and waitForSlot() keeps a slot from being rewritten
+// while that transfer may still be reading it.
+// without buffer storage, slot() is null and uploadFromMemory() is used instead.
+class StreamingTexture {
+ public:
+  static constexpr i32 SLOTS = 3;
+
+ private:
+  i32 m_width{0}, m_height{0};
+  u32 m_texture{0};
+
+  u32 m_pbo{0};
+  f32* m_slots[SLOTS]{};
+  usize m_slotCapacity{0};  // floats per slot
+  GLsync m_fences[SLOTS]{};
+
+ public:
+  StreamingTexture() = default;
+  ~StreamingTexture() { destroy(); }
+
+  StreamingTexture(const StreamingTexture&) = delete;
+  StreamingTexture& operator=(const StreamingTexture&) = delete;
+
+  // (re)allocates texture and buffer; previous slot pointers become invalid
+  void resize(i32 width, i32 height);
+
+  // fill texels (0, 0) to (width, height) from a slot or from memory, rows
+  // tightly packed; the rest of the texture keeps what it had
+  void upload(i32 slot, i32 width, i32 height);
+  void uploadFromMemory(const f32* data, i32 width, i32 height);
+  void waitForSlot(i32 slot);
+
+  f32* const* slots() const { return m_pbo ? m_slots : nullptr; }
+  usize slotCapacity() const { return m_slotCapacity; }
+
+  u32 texture() const { return m_texture; }
+  i32 width() const { return m_width; }
+  i32 height() const { return m_height; }
+
+ private:
+  void destroy();
+};
+
+#endif  // __STREAMING_TEXTURE_H__
@@ -0,0 +1,98 @@
+#ifndef __SWEEP_SOLVER_H__
+#define __SWEEP_SOLVER_H__
+
+#include <memory>
+#include <vector>
+
+#include "GrayScottSolver.h"
+#include "ThreadPool.h"
+#include "types.h"
+
+// one simulation of a parameter sweep
+struct SweepPoint {
+  f32 F, k;
+};
+
+// `fCount` x `kCount` points spanning [fMin, fMax] x [kMin, kMax], F varying fastest
+std::vector<SweepPoint> sweepGrid(f32 fMin, f32 fMax, i32 fCount, f32 kMin, f32 kMax, i32 kCount);
+
+// what a run settled into, judged from its V field
+enum class SweepOutcome : i32 {
+  Decayed = 0,  // V died out everywhere
+  Uniform,      // V nonzero but without spatial structure
+  Steady,       // patterned and no longer changing
+  Dynamic,      // patterned and still moving
+  Unstable,     // values blew up (NaN / inf)
+  Count
+};
+
+const char* sweepOutcomeName(SweepOutcome outcome);
+
+struct SweepMetrics {
+  f32 meanV{0};
+  f32 coverage{0};  // share of cells with V > 0.2
+  f32 contrast{0};  // standard deviation of V
+  f32 drift{0};     // RMS change of V per step between the two snapshots
+  SweepOutcome outcome{SweepOutcome::Decayed};
+};
+
+// summarizes one run from its V plane (size x size, row-major) and the plane
+// `interval` steps earlier
+SweepMetrics measureSweepRun(const f32* v, const f32* earlierV, i32 size, i32 interval);
+
+// many small independent Gray-Scott runs on the CPU, one per (F, k) point, that
+// differ only in F and k. runs are packed LANES at a time into one grid whose
+// cells hold LANES interleaved values, so the stencil loads and arithmetic of a
+// cell serve a whole batch with full-width SIMD, and no lane waits on another.
+// each batch is independent, so workers advance whole batches with no barriers.
+// every lane computes exactly the scalar kernel's arithmetic, so a run matches a
+// GrayScottSolver of the same size and parameters bit for bit, except that
+// subnormal values are flushed to zero unless setFlushDenormals(false).
+class SweepSolver {
+ public:
+  static constexpr i32 LANES = 8;
+
+ private:
+  i32 m_size;
+  GrayScottParams m_shared;  // Du, Dv, dt; F and k come from the points
+  std::vector<SweepPoint> m_points;
+  i32 m_batches;
+  u64 m_step{0};
+  bool m_flushDenormals{true};
+
+  // per batch: [u | v | next u | next v], size * size * LANES each
+  std::vector<std::vector<f32>> m_storage;
+  std::vector<u8> m_flipped;  // per batch: the current state is in the "next" half
+
+  std::unique_ptr<ThreadPool> m_pool;
+
+ public:
+  SweepSolver(i32 size, std::vector<SweepPoint> points, const GrayScottParams& shared = {});
+
+  // every run starts from the same field: u = 1, v = 0 plus seedSquares(seed)
+  void seed(u32 seed);
+
+  void step(i32 n = 1);
+
+  void setThreadCount(i32 threads);
+  i32 threadCount() const { return m_pool ? m_pool->threadCount() : 1; }
+
+  // FTZ/DAZ while stepping (x86 only). results differ only where a value passed
+  // through the subnormal range, and then by less than 1e-36
+  void setFlushDenormals(bool flush) { m_flushDenormals = flush; }
+  bool flushDenormals() const { return m_flushDenormals; }
+
+  // copies run `run` out as row-major size x size planes
+  void copyRun(i32 run, f32* u, f32* v) const;
+
+  i32 size() const { return m_size; }
+  i32 runCount() const { return (i32)m_points.size(); }
+  const std::vector<SweepPoint>& points() const { return m_points; }
+  u64 stepCount() const { return m_step; }
+
+ private:
+  usize planeSize() const { return (usize)m_size * m_size * LANES; }
+  void stepBatch(i32 batch, i32 n);
+};
+
+#endif  // __SWEEP_SOLVER_H__
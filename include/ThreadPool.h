@@ -0,0 +1,63 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "types.h"
+
+// reusable barrier: spins briefly, then parks on the generation counter
+class Barrier {
+ private:
+  i32 m_threads;
+  std::atomic<i32> m_remaining;
+  std::atomic<u32> m_generation{0};
+
+  static constexpr i32 SPIN_ITERATIONS = 4096;
+
+ public:
+  explicit Barrier(i32 threads) : m_threads{threads}, m_remaining{threads} {}
+
+  void arriveAndWait();
+};
+
+// persistent worker pool. run() hands the same job to every worker (the calling
+// thread participates as worker 0) and returns once all of them have finished.
+class ThreadPool {
+ public:
+  using Job = std::function<void(i32 thread, i32 threadCount)>;
+
+ private:
+  i32 m_threadCount;
+  std::vector<std::thread> m_workers;
+  Barrier m_barrier;
+
+  const Job* m_job{nullptr};
+  std::atomic<u32> m_jobGeneration{0};
+  std::atomic<i32> m_pending{0};
+  std::atomic<bool> m_stop{false};
+
+ public:
+  explicit ThreadPool(i32 threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void run(const Job& job);
+
+  // synchronizes all workers of the currently running job
+  void barrier() { m_barrier.arriveAndWait(); }
+
+  i32 threadCount() const { return m_threadCount; }
+
+  static i32 hardwareThreads() { return std::max(1, (i32)std::thread::hardware_concurrency()); }
+
+ private:
+  void workerLoop(i32 thread);
+};
+
+#endif  // __THREAD_POOL_H__
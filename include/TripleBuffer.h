@@ -0,0 +1,44 @@
+#ifndef __TRIPLE_BUFFER_H__
+#define __TRIPLE_BUFFER_H__
+
+#include <atomic>
+
+#include "types.h"
+
+// single-producer / single-consumer triple buffer. the writer fills back() and
+// publish()es it; the reader calls acquire() to swap in the newest published
+// slot. neither side ever waits: the writer overwrites a snapshot the reader
+// has not picked up yet, and the reader keeps its slot until something newer
+// is published.
+template <typename T>
+class TripleBuffer {
+ private:
+  static constexpr u32 INDEX_MASK = 0x3;
+  static constexpr u32 FRESH = 0x4;  // middle slot holds an unread publish
+
+  T m_slots[3];
+  std::atomic<u32> m_middle{1};
+  u32 m_back{2};   // writer only
+  u32 m_front{0};  // reader only
+
+ public:
+  // writer side
+  T& back() { return m_slots[m_back]; }
+  void publish() {
+    m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  // reader side. pending() is true if acquire() would swap in a new slot;
+  // frontIndex() identifies the slot front() lives in (0..2)
+  bool pending() const { return m_middle.load(std::memory_order_relaxed) & FRESH; }
+  bool acquire() {
+    if (!pending()) return false;
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+    return true;
+  }
+  const T& front() const { return m_slots[m_front]; }
+  u32 frontIndex() const { return m_front; }
+  u32 backIndex() const { return m_back; }
+};
+
+#endif  // __TRIPLE_BUFFER_H__
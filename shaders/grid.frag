@@ -1,16 +1,46 @@
-#version 460 core
+#version 450 core
 
 out vec4 FragColor;
 
-uniform int resolution;  // size (px) of each square
+// pan / zoom (see Viewport): the cell under the bottom-left pixel and how many
+// cells a pixel spans
+uniform vec2 viewOrigin;
+uniform float cellsPerPixel;
+uniform ivec2 gridSize;  // domain, in cells; outside it is background
+
+// what is bound: texel (0, 0) holds cell texelOrigin, each texel covers
+// 2^level x 2^level cells, and texels [0, texelCount) are valid (see ViewRect)
 uniform sampler2D concentration;
+uniform ivec2 texelOrigin;
+uniform ivec2 texelCount;
+uniform int level;
+uniform int vChannel;  // 0: V only (CPU snapshot, LOD view), 1: GPU state, (r, g) = (u, v)
 
-void main() {
-  ivec2 gridSize = textureSize(concentration, 0);
-  ivec2 cell = ivec2(gl_FragCoord.xy / float(resolution));
-  cell = clamp(cell, ivec2(0), gridSize - ivec2(1));
+float fetch(ivec2 texel) {
+  return texelFetch(concentration, clamp(texel, ivec2(0), texelCount - ivec2(1)), 0)[vChannel];
+}
 
-  float conc = texelFetch(concentration, cell, 0).r;
+void main() {
+  vec2 cellPos = viewOrigin + gl_FragCoord.xy * cellsPerPixel;
+  if (any(lessThan(cellPos, vec2(0.0))) || any(greaterThanEqual(cellPos, vec2(gridSize)))) {
+    FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+    return;
+  }
+
+  float conc;
+  if (level == 0) {
+    // cells as crisp squares
+    conc = fetch(ivec2(floor(cellPos)) - texelOrigin);
+  } else {
+    // a texel spans at most a pixel here; bilinear between texel centers
+    vec2 t = (cellPos - vec2(texelOrigin)) / float(1 << level) - 0.5;
+    ivec2 i = ivec2(floor(t));
+    vec2 f = t - vec2(i);
+    conc = mix(
+        mix(fetch(i), fetch(i + ivec2(1, 0)), f.x), mix(fetch(i + ivec2(0, 1)), fetch(i + ivec2(1, 1)), f.x),
+        f.y
+    );
+  }
 
   float t = smoothstep(0.02, 0.6, conc);
   float glow = pow(t, 0.75);
@@ -1,31 +1,39 @@
-#version 460 core
+#version 450 core
 
+// (r, g) = (u, v)
 layout(location = 0) out vec2 outUV;
 
 uniform sampler2D concentrationTex;
-uniform float F, k, Du, Dv;
+uniform bool halfStorage;  // the target is RG16F
 
-uniform bool isDraggingMouse;
-uniform vec2 mousePos;
-uniform float brushRadius;
+// updated once per frame by GpuSolver
+layout(std140, binding = 0) uniform SimParams {
+  float F, k, Du, Dv;
+  float dt, activityThreshold;
+};
 
 ivec2 wrap(ivec2 p, ivec2 sz) {
   return ivec2((p.x + sz.x) % sz.x, (p.y + sz.y) % sz.y);
 }
 
-float V(ivec2 p) { return texelFetch(concentrationTex, p, 0).r; }
+// 16-bit float render targets and images may truncate on the way in (GL leaves
+// the rounding to the driver, and llvmpipe truncates), which biases every step.
+// rounding to the nearest half first, ties to even like the CPU encoder, makes
+// the conversion exact
+float roundToHalf(float x) {
+  if (abs(x) < 6.103515625e-05) return roundEven(x * 16777216.0) / 16777216.0;  // subnormal
+  uint b = floatBitsToUint(x);
+  return uintBitsToFloat((b + 0x0FFFu + ((b >> 13) & 1u)) & ~0x1FFFu);
+}
+
+float U(ivec2 p) { return texelFetch(concentrationTex, p, 0).r; }
 
-float U(ivec2 p) { return texelFetch(concentrationTex, p, 0).g; }
+float V(ivec2 p) { return texelFetch(concentrationTex, p, 0).g; }
 
 void main() {
   ivec2 p = ivec2(gl_FragCoord.xy);
   ivec2 sz = textureSize(concentrationTex, 0);
 
-  if (isDraggingMouse && distance(p, mousePos) <= brushRadius) {
-    outUV = vec2(1.0, 0.0);
-    return;
-  }
-
   float u = U(p);
   float v = V(p);
 
@@ -41,6 +49,6 @@ void main() {
   float du = -(u * v * v) + F * (1 - u) + Du * u_lapl;
   float dv = (u * v * v) - (F + k) * v + Dv * v_lapl;
 
-  outUV = vec2(max(v + dv, 0.0), max(u + du, 0.0));
+  outUV = vec2(max(u + du * dt, 0.0), max(v + dv * dt, 0.0));
+  if (halfStorage) outUV = vec2(roundToHalf(outUV.r), roundToHalf(outUV.g));
 }
-
@@ -1,100 +1,288 @@
 #include "Application.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <imgui.h>
+#include <memory>
+#include <string>
 
 #include <glad/glad.h>
-#include <glm/geometric.hpp>
 #include <glm/glm.hpp>
 
+#include "GpuTuner.h"
 #include "Profiler.h"
+#include "Quad.h"
 #include "types.h"
 
-constexpr f32 VERTICES[] = {
-    -1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, -1.0f, 0.0f, -1.0f, -1.0f, 0.0f,
-};
-
-constexpr u32 INDICES[] = {
-    0, 1, 3, 1, 2, 3,
-};
-
 void Application::render(bool drawUI) {
+  // requested by last frame's UI, run before anything of this frame is drawn
+  if (m_retunePending) {
+    m_retunePending = false;
+    retune();
+  }
+
   {
-    Profiler::Scope _s(m_prof, "GUI");
+    PROFILE_SCOPE(m_prof, "GUI");
     if (drawUI) renderUI();
   }
 
   if (!m_defaultBuffersInitializated) initDefaultBuffers();
 
   if (m_isRunningOnGPU) {
-    if (!m_gpuCompTexturesInitialized) initBuffersGPUComp();
     renderGPUComp();
   } else {
-    if (!m_cpuCompTexturesInitialized) initBuffersCPUComp();
+    // room for any view of this grid in this window (see visibleRect)
+    if (m_cpuTexture.width() != std::min(m_gridWidth, m_windowWidth + 2) ||
+        m_cpuTexture.height() != std::min(m_gridHeight, m_windowHeight + 2))
+      resizeCPUTexture();
     renderCPUComp();
   }
+
+  governStepsPerFrame();
+}
+
+void Application::setDisplayUniforms(const ViewRect& rect, i32 vChannel) {
+  m_mainShader.use();
+  m_mainShader.setVec2("viewOrigin", (f32)m_view.x, (f32)m_view.y);
+  m_mainShader.setFloat("cellsPerPixel", (f32)m_view.cellsPerPixel);
+  m_mainShader.setIVec2("gridSize", m_gridWidth, m_gridHeight);
+  m_mainShader.setIVec2("texelOrigin", rect.x0, rect.y0);
+  m_mainShader.setIVec2("texelCount", rect.texelsX(), rect.texelsY());
+  m_mainShader.setInt("level", rect.level);
+  m_mainShader.setInt("vChannel", vChannel);
 }
 
 // pure CPU computation render call
 void Application::renderCPUComp() {
-  m_mainShader.use();
-  m_mainShader.setInt("resolution", m_resolution);
+  // the simulation thread only publishes what is in view, at its level
+  const ViewRect rect =
+      visibleRect(m_view, m_windowWidth, m_windowHeight, m_gridWidth, m_gridHeight);
+  if (rect != m_requestedView) {
+    m_requestedView = rect;
+    m_simulation.setView(rect);
+  }
 
-  {
-    Profiler::Scope _s(m_prof, "Texture upload");
+  // only upload when the simulation thread published something new
+  if (m_simulation.hasNewSnapshot()) {
+    PROFILE_SCOPE(m_prof, "Texture upload");
+
+    // acquiring hands the current slot back to the simulation thread, so the
+    // upload that reads it has to be done
+    m_cpuTexture.waitForSlot(m_simulation.snapshotSlot());
+    m_simulation.acquire();
+
+    GPU_PROFILE_SCOPE(m_gpuProf, "GPU texture upload");
     updateConcentrationTexture();
   }
 
+  GPU_PROFILE_SCOPE(m_gpuProf, "GPU display");
+  setDisplayUniforms(m_cpuView, 0);
   glBindVertexArray(VAO);
   glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, m_concentrationTex);
+  glBindTexture(GL_TEXTURE_2D, m_cpuTexture.texture());
   glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
   glBindVertexArray(0);
 }
 
 void Application::renderGPUComp() {
-  for (i32 i = 0; i < m_stepsPerFrame; ++i) {
-    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_destTex, 0);
+  {
+    static const ScopeId COMPUTE = Profiler::intern("Simulation (GPU compute)");
+    static const ScopeId FRAGMENT = Profiler::intern("Simulation (GPU fragment)");
+    Profiler::Scope _s(m_prof, m_gpuSolver.backend() == GpuBackend::Compute ? COMPUTE : FRAGMENT);
+
+    m_gpuSolver.setParams(F, k);
+    m_gpuSolver.setTimeStep(std::min(m_timeStep, explicitStableTimeStep(Du, Dv)));
+    m_gpuSolver.applyStamps(m_brush.takeFrame());
+
+    GPU_PROFILE_SCOPE(m_gpuProf, "GPU simulation");
+    if (!m_recorder.recording()) {
+      m_gpuSolver.step(m_stepsPerFrame);
+    } else {
+      // split the frame's steps so captures land on multiples of the interval
+      const u64 interval = m_recorder.options().interval;
+      for (i32 left = m_stepsPerFrame; left > 0;) {
+        const i32 n = (i32)std::min<u64>(left, interval - m_gpuSolver.stepCount() % interval);
+        m_gpuSolver.step(n);
+        left -= n;
+
+        if (m_gpuSolver.stepCount() % interval == 0)
+          m_readback.capture(
+              m_gpuSolver.texture(), m_gpuSolver.width(), m_gpuSolver.height(),
+              m_gpuSolver.stepCount(), m_recorder
+          );
+      }
+    }
+  }
 
-    glViewport(0, 0, m_gridWidth, m_gridHeight);
+  if (m_recorder.recording()) {
+    PROFILE_SCOPE(m_prof, "Record readback");
+    m_readback.poll(m_recorder);
+  }
 
-    m_gpuComputeShader.use();
+  // GPU steps are tied to the render loop
+  m_prof.sim_steps_per_sec = m_prof.frametime > 0 ? m_stepsPerFrame * 1000.0 / m_prof.frametime : 0;
+  m_prof.sim_batch_ms = 0;
+  m_prof.sim_active_tiles = m_gpuSolver.activeTileFraction();
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_srcTex);
+  glViewport(0, 0, m_windowWidth, m_windowHeight);
 
-    m_gpuComputeShader.setFloat("F", F);
-    m_gpuComputeShader.setFloat("k", k);
-    m_gpuComputeShader.setFloat("Du", Du);
-    m_gpuComputeShader.setFloat("Dv", Dv);
-    m_gpuComputeShader.setFloat("brushRadius", m_brushRadius);
-    m_gpuComputeShader.setBool("isDraggingMouse", false);
-    m_gpuComputeShader.setVec2("mousePos", m_mousePosX, m_mousePosY);
+  // zoomed in, the state texture is sampled as is; zoomed out, the visible
+  // part is first reduced to about one texel per pixel
+  const ViewRect rect =
+      visibleRect(m_view, m_windowWidth, m_windowHeight, m_gridWidth, m_gridHeight);
+  u32 texture = m_gpuSolver.texture();
+  if (rect.level > 0) {
+    GPU_PROFILE_SCOPE(m_gpuProf, "GPU LOD");
+    m_lodView.update(texture, m_gpuSolver.width(), m_gpuSolver.height(), rect);
+    texture = m_lodView.texture();
+  }
 
-    if (m_isDraggingMouse && !ImGui::GetIO().WantCaptureMouse) {
-      m_gpuComputeShader.setBool("isDraggingMouse", true);
-    }
+  GPU_PROFILE_SCOPE(m_gpuProf, "GPU display");
+  if (rect.level > 0)
+    setDisplayUniforms(rect, 0);
+  else
+    setDisplayUniforms(ViewRect{0, 0, m_gpuSolver.width(), m_gpuSolver.height(), 0}, 1);
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  glBindVertexArray(VAO);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  glBindVertexArray(0);
+}
 
-    std::swap(m_srcTex, m_destTex);
+void Application::governStepsPerFrame() {
+  m_prof.sim_steps_per_frame = m_stepsPerFrame;
+  m_prof.sim_budget_ms = m_governed ? m_governor.options().budgetMs : 0;
+  if (!m_governed) return;
+
+  const i32 backend = m_isRunningOnGPU ? 1 + (i32)m_gpuSolver.backend() : 0;
+  if (backend != m_governedBackend) {
+    m_governedBackend = backend;
+    GovernorOptions options = m_governor.options();
+    options.latency = m_isRunningOnGPU ? GpuProfiler::FRAMES_IN_FLIGHT : 1;
+    m_governor.setOptions(options);
+    m_governor.reset(m_stepsPerFrame);
   }
 
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  glViewport(0, 0, m_windowWidth, m_windowHeight);
+  f64 stepMs, otherMs = 0;
+  if (m_isRunningOnGPU) {
+    // GPU time, read back a few frames late; each timing is fed once, and the
+    // governor skips the ones taken before its last change
+    static const ScopeId SIMULATION = Profiler::intern("GPU simulation");
+    static const ScopeId FRAME = Profiler::intern("GPU frame");
+    const Profiler::Stat* simulation = m_prof.stat(SIMULATION);
+    const Profiler::Stat* frame = m_prof.stat(FRAME);
+    if (!simulation || !frame || simulation->count == m_governorSamples) return;
+    m_governorSamples = simulation->count;
+
+    stepMs = simulation->last_ms / m_stepsPerFrame;
+    otherMs = frame->last_ms - simulation->last_ms;
+  } else {
+    // the CPU solver runs beside the render loop, so the budget is its batch:
+    // one published snapshot per frame
+    const f64 rate = m_simulation.stepsPerSecond();
+    if (rate <= 0) return;
+    stepMs = 1000.0 / rate;
+  }
+  m_stepsPerFrame = m_governor.update(stepMs, otherMs);
+
+  // a fixed domain has no cell size to give up
+  if (m_governor.wantsCoarserGrid() && m_domainSize == 0 && m_resolution < MAX_RESOLUTION) {
+    m_governorStatus = "One step per frame overran the budget, cell size raised to " +
+                       std::to_string(m_resolution + 1) + " px";
+    // backend, precision and the step count chosen above all stay as they are
+    ++m_resolution;
+    resizeGrid();  // resets the governor
+  }
+}
 
-  m_mainShader.use();
-  m_mainShader.setInt("resolution", m_resolution);
+bool Application::loadTuning() {
+  const auto t0 = std::chrono::steady_clock::now();
+  const TuningKey key{cpuModelName(), glRendererName(), m_gridWidth, m_gridHeight};
 
-  glBindTexture(GL_TEXTURE_2D, m_srcTex);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  TunedConfig config;
+  if (!loadTunedConfig(defaultTuningCachePath().c_str(), key, config)) return false;
+  applyTunedConfig(config);
 
-  glBindVertexArray(VAO);
-  glActiveTexture(GL_TEXTURE0);
+  char status[256];
+  std::snprintf(
+      status, sizeof(status), "Cached: %s, %.0f steps/s (loaded in %.2f ms)",
+      tunedConfigName(config).c_str(), config.stepsPerSecond,
+      std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - t0).count()
+  );
+  m_tuningStatus = status;
+  return true;
+}
 
-  glBindVertexArray(0);
+void Application::retune() {
+  const auto t0 = std::chrono::steady_clock::now();
+
+  // the simulation thread would compete with the CPU candidates
+  m_simulation.setRunning(false);
+
+  const std::vector<f32> state = tuningState(m_gridWidth, m_gridHeight, m_tuningOptions);
+  std::vector<TuningCandidate> candidates =
+      tuneCpu(m_gridWidth, m_gridHeight, state, m_tuningOptions);
+  const std::vector<TuningCandidate> gpu =
+      tuneGpu(m_gridWidth, m_gridHeight, state, m_tuningOptions);
+  candidates.insert(candidates.end(), gpu.begin(), gpu.end());
+
+  const TunedConfig config = pickTunedConfig(candidates);
+  applyTunedConfig(config);  // restarts the simulation thread if the CPU won
+
+  char status[256];
+  std::snprintf(
+      status, sizeof(status), "Tuned: %s, %.0f steps/s (%zu candidates in %.1f s)",
+      tunedConfigName(config).c_str(), config.stepsPerSecond, candidates.size(),
+      std::chrono::duration<f64>(std::chrono::steady_clock::now() - t0).count()
+  );
+  m_tuningStatus = status;
+
+  const TuningKey key{cpuModelName(), glRendererName(), m_gridWidth, m_gridHeight};
+  std::string error;
+  if (!saveTunedConfig(defaultTuningCachePath().c_str(), key, config, &error))
+    m_tuningStatus += " - not cached: " + error;
+}
+
+// only the winning backend's knobs change; the other keeps what the user set
+void Application::applyTunedConfig(const TunedConfig& config) {
+  m_stepsPerFrame = std::clamp(config.stepsPerFrame, 1, 32);
+
+  // one setting for both, as in the UI
+  m_storagePrecision = (i32)config.precision;
+  m_gpuSolver.setStoragePrecision(config.precision);
+  m_simulation.post([precision = config.precision](GrayScottSolver& s) {
+    s.setStoragePrecision(precision);
+  });
+
+  if (config.gpu) {
+    m_gpuSolver.setBackend((GpuBackend)std::clamp(config.gpuBackend, 0, (i32)GpuBackend::Count - 1));
+    for (i32 i = 0; i < IM_ARRAYSIZE(WORK_GROUP_SIZES); ++i) {
+      if (WORK_GROUP_SIZES[i][0] == config.gpuWorkGroupX &&
+          WORK_GROUP_SIZES[i][1] == config.gpuWorkGroupY) {
+        m_gpuWorkGroup = i;
+        m_gpuSolver.setWorkGroupSize(config.gpuWorkGroupX, config.gpuWorkGroupY);
+      }
+    }
+    m_gpuFusedSteps = std::clamp(config.gpuFusedSteps, 1, 4);
+    m_gpuSolver.setFusedSteps(m_gpuFusedSteps);
+  } else {
+    // a cache written on another SKU with the same model string is still clamped
+    m_cpuThreads = std::clamp(config.cpuThreads, 1, ThreadPool::hardwareThreads());
+    m_cpuKernel = std::min((i32)config.cpuKernel, (i32)detectKernelIsa());
+    m_cpuBlockDepth = std::clamp(config.cpuBlockDepth, 1, 32);
+    m_simulation.post([threads = m_cpuThreads, isa = (KernelIsa)m_cpuKernel,
+                       depth = m_cpuBlockDepth](GrayScottSolver& s) {
+      s.setThreadCount(threads);
+      s.setKernelIsa(isa);
+      s.setTemporalBlocking(depth);
+    });
+  }
+
+  m_isRunningOnGPU = config.gpu;
+  m_simulation.setRunning(!m_isRunningOnGPU);
 }
 
 static void HelpMarker(const char* desc) {
@@ -117,6 +305,7 @@ ImGui::End();
 
   ImGui::Text("Press 'P' to show/hide the profiler");
   ImGui::Text("Press 'I' to show/hide this UI");
+  ImGui::Text("Scroll to zoom, drag with the right mouse button to pan, 'F' to fit the view");
   ImGui::Text(
       "Press 'G' to toggle GPU computation. Currently processing on: %s",
       m_isRunningOnGPU ? "GPU" : "CPU"
@@ -129,18 +318,199 @@ ImGui::End();
     ImGui::TextWrapped("Caution! Changing these settings may be very resource expensive.");
     ImGui::PopStyleColor();
 
-    if (ImGui::SliderInt("Grid cell size (px)", &m_resolution, 1, 20)) {
+    if (ImGui::Button("Re-tune")) m_retunePending = true;
+    ImGui::SameLine();
+    ImGui::Checkbox("Allow fp16/bf16", &m_tuningOptions.allowReducedPrecision);
+    ImGui::SameLine();
+    HelpMarker(
+        "Times every CPU and GPU variant below on the current grid (a few seconds) and switches "
+        "to the fastest, with enough steps per frame to keep up 60 fps. The result is cached "
+        "per CPU, GPU and grid size, and applied at startup and by Re-tune; resizing keeps the "
+        "current settings."
+    );
+    if (!m_tuningStatus.empty()) ImGui::TextWrapped("%s", m_tuningStatus.c_str());
+
+    const char* domainNames[] = {"Fit window", "1024 x 1024", "2048 x 2048",
+                                 "4096 x 4096", "8192 x 8192", "16384 x 16384"};
+    i32 domain = 0;
+    for (i32 i = 0; i < IM_ARRAYSIZE(DOMAIN_SIZES); ++i)
+      if (DOMAIN_SIZES[i] == m_domainSize) domain = i;
+    i32 domains = 1;  // as large as the GPU can hold
+    while (domains < IM_ARRAYSIZE(DOMAIN_SIZES) && DOMAIN_SIZES[domains] <= m_maxTextureSize)
+      ++domains;
+    if (ImGui::Combo("Domain", &domain, domainNames, domains)) setDomainSize(DOMAIN_SIZES[domain]);
+    ImGui::SameLine();
+    HelpMarker(
+        "A fixed domain does not depend on the window. Scroll to zoom, drag with the right "
+        "mouse button to pan, and press 'F' to see all of it. Both solvers keep 16 bytes per "
+        "cell, 4 GiB at 16384 x 16384."
+    );
+    ImGui::Text(
+        "View: %.3g cells per pixel, level %d", m_view.cellsPerPixel,
+        viewLevel(m_view.cellsPerPixel)
+    );
+
+    ImGui::BeginDisabled(m_domainSize > 0);
+    if (ImGui::SliderInt("Grid cell size (px)", &m_resolution, 1, MAX_RESOLUTION)) {
       setResolution(m_resolution);  // realloc grid & textures
     }
+    ImGui::EndDisabled();
     ImGui::SameLine();
     HelpMarker("Less = higher resolution (more computationally expensive)");
 
-    ImGui::SliderInt("Steps per frame", &m_stepsPerFrame, 1, 32);
+    if (ImGui::Checkbox("Auto steps per frame", &m_governed)) m_governor.reset(m_stepsPerFrame);
+    ImGui::SameLine();
+    HelpMarker(
+        "Raises or lowers steps per frame so a frame fits the budget: GPU frame time on the GPU, "
+        "the time between published snapshots on the CPU. Changes wait for the measurements to "
+        "settle, so the count does not flicker."
+    );
+    if (m_governed) {
+      GovernorOptions options = m_governor.options();
+      f32 budget = (f32)options.budgetMs;
+      bool changed = ImGui::SliderFloat("Frame budget (ms)", &budget, 4.0f, 50.0f, "%.1f");
+      changed |= ImGui::Checkbox("Coarsen grid if needed", &options.allowCoarsening);
+      ImGui::SameLine();
+      HelpMarker(
+          "When even one step per frame overruns the budget for a second, raises the cell size "
+          "by one pixel. This restarts the simulation."
+      );
+      if (changed) {
+        options.budgetMs = budget;
+        m_governor.setOptions(options);
+      }
+      if (!m_governorStatus.empty()) ImGui::TextWrapped("%s", m_governorStatus.c_str());
+    }
+
+    ImGui::BeginDisabled(m_governed);
+    ImGui::SliderInt("Steps per frame", &m_stepsPerFrame, 1, std::max(32, m_stepsPerFrame));
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    HelpMarker(
+        "More steps = more simulation updates per frame. The CPU solver runs on its own thread "
+        "as fast as it can and publishes a frame every this many steps."
+    );
+
+    if (ImGui::SliderInt("CPU threads", &m_cpuThreads, 1, ThreadPool::hardwareThreads())) {
+      m_simulation.post([threads = m_cpuThreads](GrayScottSolver& s) {
+        s.setThreadCount(threads);
+      });
+    }
+    ImGui::SameLine();
+    HelpMarker("Worker threads used by the CPU solver (row bands over a persistent pool).");
+
+    const char* isaNames[(i32)KernelIsa::Count];
+    for (i32 i = 0; i < (i32)KernelIsa::Count; ++i) isaNames[i] = kernelIsaName((KernelIsa)i);
+
+    if (ImGui::Combo("CPU kernel", &m_cpuKernel, isaNames, (i32)detectKernelIsa() + 1)) {
+      m_simulation.post([isa = (KernelIsa)m_cpuKernel](GrayScottSolver& s) {
+        s.setKernelIsa(isa);
+      });
+    }
     ImGui::SameLine();
-    HelpMarker("More steps = more simulation updates per frame.");
+    HelpMarker("SIMD instruction set of the CPU stencil (defaults to the best one detected).");
+
+    if (ImGui::SliderInt("Temporal block (steps)", &m_cpuBlockDepth, 1, 32)) {
+      m_simulation.post([depth = m_cpuBlockDepth](GrayScottSolver& s) {
+        s.setTemporalBlocking(depth);
+      });
+    }
+    ImGui::SameLine();
+    HelpMarker(
+        "Steps advanced per cache-sized tile before moving on (1 = off). Same results, less "
+        "memory traffic at high steps per frame."
+    );
+
+    const char* integratorNames[(i32)Integrator::Count];
+    for (i32 i = 0; i < (i32)Integrator::Count; ++i)
+      integratorNames[i] = integratorName((Integrator)i);
+
+    if (ImGui::Combo("CPU integrator", &m_integrator, integratorNames, (i32)Integrator::Count)) {
+      m_simulation.post([integrator = (Integrator)m_integrator](GrayScottSolver& s) {
+        s.setIntegrator(integrator);
+      });
+    }
+    ImGui::SameLine();
+    HelpMarker(
+        "Spectral integrators treat diffusion implicitly through FFTs: a step costs far more "
+        "than an explicit one, but stays stable at much larger time steps (see README)."
+    );
+
+    // the GPU solvers are explicit, so they stop at the diffusion limit
+    const bool spectral = !m_isRunningOnGPU && m_integrator != (i32)Integrator::Explicit;
+    const f32 maxTimeStep = spectral ? 16.0f : explicitStableTimeStep(Du, Dv);
+    ImGui::SliderFloat("Time step", &m_timeStep, 0.1f, maxTimeStep, "%.2f");
+    m_timeStep = std::min(m_timeStep, maxTimeStep);
+    ImGui::SameLine();
+    HelpMarker("Simulated time per step. Explicit Euler is only stable up to 1 / (4 max(Du, Dv)).");
+
+    const char* precisionNames[(i32)StoragePrecision::Count];
+    for (i32 i = 0; i < (i32)StoragePrecision::Count; ++i)
+      precisionNames[i] = storagePrecisionName((StoragePrecision)i);
+
+    if (ImGui::Combo(
+            "Storage precision", &m_storagePrecision, precisionNames, (i32)StoragePrecision::Count
+        )) {
+      auto precision = (StoragePrecision)m_storagePrecision;
+      m_simulation.post([precision](GrayScottSolver& s) { s.setStoragePrecision(precision); });
+      m_gpuSolver.setStoragePrecision(precision);
+    }
+    ImGui::SameLine();
+    HelpMarker(
+        "Format the U/V state is stored in; math stays fp32. Halves memory traffic at some "
+        "accuracy cost (see README). The GPU uses fp16 for bf16."
+    );
+
+    bool activityChanged = ImGui::Checkbox("Skip resting tiles", &m_activityMask);
+    ImGui::SameLine();
+    HelpMarker(
+        "Only steps tiles that are, or border, tiles still changing; the rest of a mostly empty "
+        "domain is left alone. Exact at threshold 0 (see README). GPU: compute backend only."
+    );
+    if (m_activityMask) {
+      activityChanged |= ImGui::SliderFloat(
+          "Rest threshold", &m_activityThreshold, 0.0f, 1e-2f, "%.0e", ImGuiSliderFlags_Logarithmic
+      );
+    }
+    if (activityChanged) {
+      m_simulation.post([on = m_activityMask, eps = m_activityThreshold](GrayScottSolver& s) {
+        s.setActivityMask(on, eps);
+      });
+      m_gpuSolver.setActivityMask(m_activityMask, m_activityThreshold);
+    }
 
     // mirror for G key
-    ImGui::Checkbox("Run on GPU", &m_isRunningOnGPU);
+    if (ImGui::Checkbox("Run on GPU", &m_isRunningOnGPU)) {
+      m_simulation.setRunning(!m_isRunningOnGPU);
+    }
+
+    i32 backend = (i32)m_gpuSolver.backend();
+    const char* backendNames[(i32)GpuBackend::Count];
+    for (i32 i = 0; i < (i32)GpuBackend::Count; ++i)
+      backendNames[i] = GpuSolver::backendName((GpuBackend)i);
+
+    if (ImGui::Combo("GPU backend", &backend, backendNames, (i32)GpuBackend::Count)) {
+      m_gpuSolver.setBackend((GpuBackend)backend);
+    }
+
+    if (m_gpuSolver.backend() == GpuBackend::Compute) {
+      const char* workGroupNames[] = {"8x8", "16x16", "32x8", "32x32"};
+      if (ImGui::Combo(
+              "Work-group size", &m_gpuWorkGroup, workGroupNames, IM_ARRAYSIZE(workGroupNames)
+          )) {
+        m_gpuSolver.setWorkGroupSize(
+            WORK_GROUP_SIZES[m_gpuWorkGroup][0], WORK_GROUP_SIZES[m_gpuWorkGroup][1]
+        );
+      }
+      ImGui::SameLine();
+      HelpMarker("Compute shader tile; each work group caches it plus a halo in shared memory.");
+
+      if (ImGui::SliderInt("Fused steps per dispatch", &m_gpuFusedSteps, 1, 4)) {
+        m_gpuSolver.setFusedSteps(m_gpuFusedSteps);
+      }
+      ImGui::SameLine();
+      HelpMarker("Steps advanced per dispatch in shared memory, using a halo just as wide.");
+    }
   }
 
   // --------- simulation controls ----------
@@ -164,69 +534,254 @@ ImGui::End();
     float maxRadius = std::max((float)m_resolution, 20.0f / std::max(1.0f, (float)m_resolution));
     ImGui::SliderFloat("Brush radius", &m_brushRadius, 1.0f, maxRadius);
 
+    const char* shapeNames[(i32)BrushShape::Count];
+    for (i32 i = 0; i < (i32)BrushShape::Count; ++i) shapeNames[i] = brushShapeName((BrushShape)i);
+    ImGui::Combo("Brush shape", &m_brushShape, shapeNames, (i32)BrushShape::Count);
+    ImGui::SameLine();
+    ImGui::Checkbox("Erase", &m_brushErase);
+    ImGui::SameLine();
+    HelpMarker("Erase paints the trivial state (u = 1, v = 0) instead of seeding v.");
+
     if (ImGui::Button("Reset simulation (R)")) resetConcentrations();
   }
 
+  // --------- recording ----------
+  if (ImGui::CollapsingHeader("Recording")) {
+    const bool recording = m_recorder.recording();
+
+    ImGui::BeginDisabled(recording);
+    ImGui::InputText("Output", m_recordingPath, sizeof(m_recordingPath));
+    ImGui::SliderInt("Every N steps", &m_recordOptions.interval, 1, 256);
+    ImGui::Checkbox("Record U", &m_recordOptions.recordU);
+    ImGui::SameLine();
+
+    bool sixteenBits = m_recordOptions.bits == 16;
+    if (ImGui::Checkbox("16-bit samples", &sixteenBits))
+      m_recordOptions.bits = sixteenBits ? 16 : 8;
+
+    const char* overflowNames[] = {"Drop frames", "Downsample, then drop"};
+    i32 overflow = (i32)m_recordOptions.overflow;
+    if (ImGui::Combo(
+            "When the disk is behind", &overflow, overflowNames, IM_ARRAYSIZE(overflowNames)
+        ))
+      m_recordOptions.overflow = (RecorderOverflow)overflow;
+    ImGui::EndDisabled();
+
+    if (ImGui::Button(recording ? "Stop recording" : "Start recording")) {
+      if (recording)
+        stopRecording();
+      else
+        startRecording();
+    }
+    ImGui::SameLine();
+    HelpMarker(
+        "Quantized, delta-encoded and run-length compressed on a writer thread. Frames the "
+        "writer has no room for are stored at half resolution or dropped; the simulation never "
+        "waits. GPU frames are read back asynchronously."
+    );
+
+    RecorderStats stats = m_recorder.stats();
+    if (stats.written || stats.dropped) {
+      ImGui::Text(
+          "%llu frames (%llu downsampled), %llu dropped", (unsigned long long)stats.written,
+          (unsigned long long)stats.downsampled, (unsigned long long)stats.dropped
+      );
+      ImGui::Text(
+          "%.1f MB on disk, %.2fx compression", stats.fileBytes / 1e6,
+          stats.fileBytes ? (f64)stats.rawBytes / stats.fileBytes : 0.0
+      );
+    }
+    if (!m_recordingStatus.empty()) ImGui::TextWrapped("%s", m_recordingStatus.c_str());
+  }
+
+  // --------- checkpoints ----------
+  if (ImGui::CollapsingHeader("Checkpoint")) {
+    ImGui::InputText("File", m_checkpointPath, sizeof(m_checkpointPath));
+
+    const bool pending = m_checkpointResult.valid();
+    if (pending &&
+        m_checkpointResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+      m_checkpointStatus = m_checkpointResult.get();
+
+    ImGui::BeginDisabled(pending);
+    if (ImGui::Button("Save")) saveCheckpoint();
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) loadCheckpoint();
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    HelpMarker(
+        "Binary snapshot of U/V, F/k and the step count, in the current storage precision. "
+        "Loading needs the grid size it was saved at."
+    );
+
+    if (!m_checkpointStatus.empty()) ImGui::TextWrapped("%s", m_checkpointStatus.c_str());
+  }
+
   ImGui::End();
 }
 
-void Application::computeConcentrationsCPU(f32 delta_t) {
-  std::vector<f32> new_u(u_conc.size());
-  std::vector<f32> new_v(v_conc.size());
+void Application::updateSimulationCPU() {
+  SimulationThread::Controls controls;
+  controls.params = GrayScottParams{F, k, Du, Dv, m_timeStep};
 
-  i32 w = m_gridWidth, h = m_gridHeight;
+  m_simulation.setControls(controls);
+  if (std::vector<BrushStamp> stamps = m_brush.takeFrame(); !stamps.empty()) {
+    m_simulation.post([stamps = std::move(stamps)](GrayScottSolver& s) { s.applyStamps(stamps); });
+  }
+  m_simulation.setStepsPerBatch(m_stepsPerFrame);
 
-  auto idx = [&](i32 x, i32 y) { return y * w + x; };
+  m_prof.sim_steps_per_sec = m_simulation.stepsPerSecond();
+  m_prof.sim_batch_ms = m_simulation.batchMs();
+  m_prof.sim_active_tiles = m_simulation.activeTileFraction();
+}
 
-  for (i32 i = 0; i < w; ++i) {
-    for (i32 j = 0; j < h; ++j) {
-      i32 cur_idx = idx(i, j);
-      f32 u = u_conc[cur_idx];
-      f32 v = v_conc[cur_idx];
+void Application::saveCheckpoint() {
+  std::string path = m_checkpointPath;
+
+  if (!m_isRunningOnGPU) {
+    auto result = std::make_shared<std::promise<std::string>>();
+    m_checkpointResult = result->get_future();
+    m_checkpointStatus = "Saving...";
+
+    m_simulation.post([path, result](GrayScottSolver& s) {
+      std::string error;
+      result->set_value(
+          ::saveCheckpoint(path.c_str(), s, &error)
+              ? "Saved step " + std::to_string(s.stepCount()) + " to " + path
+              : error
+      );
+    });
+    return;
+  }
 
-      if (m_isDraggingMouse && !ImGui::GetIO().WantCaptureMouse) {
-        if (glm::distance(glm::vec2(m_mousePosX, m_mousePosY), glm::vec2(i, j)) <= m_brushRadius) {
-          new_u[cur_idx] = 0.0f;
-          new_v[cur_idx] = 1.0f;
-          continue;
-        }
-      }
+  const i32 w = m_gpuSolver.width(), h = m_gpuSolver.height();
+  std::vector<f32> planes(2 * (usize)w * h);
+  m_gpuSolver.getState(planes.data(), planes.data() + (usize)w * h, w);
+
+  CheckpointState state;
+  state.params = m_gpuSolver.params();
+  state.step = m_gpuSolver.stepCount();
+  state.width = w;
+  state.height = h;
+  state.stride = w;
+  state.precision = m_gpuSolver.storagePrecision();
+  state.u = planes.data();
+  state.v = planes.data() + (usize)w * h;
+
+  std::string error;
+  m_checkpointStatus = ::saveCheckpoint(path.c_str(), state, &error)
+                           ? "Saved step " + std::to_string(state.step) + " to " + path
+                           : error;
+}
 
-      auto U = [&](i32 x, i32 y) { return u_conc[idx((x + w) % w, (y + h) % h)]; };
-      auto V = [&](i32 x, i32 y) { return v_conc[idx((x + w) % w, (y + h) % h)]; };
+void Application::loadCheckpoint() {
+  std::string error;
+  std::shared_ptr<Checkpoint> checkpoint = Checkpoint::open(m_checkpointPath, &error);
+  if (!checkpoint) {
+    m_checkpointStatus = error;
+    return;
+  }
 
-      f32 u_lapl = U(i - 1, j) + U(i + 1, j) + U(i, j - 1) + U(i, j + 1) - 4 * U(i, j);
-      f32 v_lapl = V(i - 1, j) + V(i + 1, j) + V(i, j - 1) + V(i, j + 1) - 4 * V(i, j);
+  if (checkpoint->width() != m_gridWidth || checkpoint->height() != m_gridHeight) {
+    m_checkpointStatus = "Checkpoint grid is " + std::to_string(checkpoint->width()) + "x" +
+                         std::to_string(checkpoint->height()) + ", current grid is " +
+                         std::to_string(m_gridWidth) + "x" + std::to_string(m_gridHeight);
+    return;
+  }
 
-      f32 du = -(u * v * v) + F * (1 - u) + Du * u_lapl;
-      f32 dv = (u * v * v) - (F + k) * v + Dv * v_lapl;
+  // Du / Dv are fixed in the UI
+  setParams(checkpoint->params().F, checkpoint->params().k);
+  const std::string loaded = "Loaded step " + std::to_string(checkpoint->step());
+
+  if (!m_isRunningOnGPU) {
+    auto result = std::make_shared<std::promise<std::string>>();
+    m_checkpointResult = result->get_future();
+    m_checkpointStatus = "Loading...";
+
+    // the mapping stays alive until the command ran
+    m_simulation.post([checkpoint, result, loaded](GrayScottSolver& s) {
+      checkpoint->restore(s);
+      result->set_value(loaded);
+    });
+    return;
+  }
 
-      new_u[cur_idx] = std::max(u + du * delta_t, 0.0f);
-      new_v[cur_idx] = std::max(v + dv * delta_t, 0.0f);
-    }
+  m_gpuSolver.setState(checkpoint->precision(), checkpoint->u(), checkpoint->v());
+  m_gpuSolver.setStepCount(checkpoint->step());
+  m_checkpointStatus = loaded;
+}
+
+void Application::startRecording() {
+  std::string error;
+  if (!m_recorder.start(m_recordingPath, m_gridWidth, m_gridHeight, m_recordOptions, &error)) {
+    m_recordingStatus = error;
+    return;
   }
 
-  u_conc = std::move(new_u);
-  v_conc = std::move(new_v);
+  m_recordingStatus = std::string("Recording to ") + m_recordingPath;
+  m_simulation.setRecorder(&m_recorder);
+}
+
+void Application::stopRecording() {
+  // once detached, nothing submits anymore
+  m_simulation.setRecorder(nullptr);
+  m_readback.poll(m_recorder);
+  m_readback.clear();
+  m_recorder.stop();
+
+  m_recordingStatus = std::string("Saved ") + m_recordingPath;
+}
+
+void Application::setPanning(bool panning) {
+  m_panning = panning && !ImGui::GetIO().WantCaptureMouse;
+}
+
+void Application::zoom(f64 notches) {
+  if (ImGui::GetIO().WantCaptureMouse) return;
+
+  // from a single cell across the window to the whole domain in a quarter of it
+  const f64 largest = 4 * std::max(
+                               (f64)m_gridWidth / std::max(m_windowWidth, 1),
+                               (f64)m_gridHeight / std::max(m_windowHeight, 1)
+                           );
+  const f64 cellsPerPixel = std::clamp(
+      m_view.cellsPerPixel * std::pow(ZOOM_STEP, -notches), MIN_CELLS_PER_PIXEL,
+      std::max(largest, 1.0)
+  );
+
+  m_view.x += m_cursorX * (m_view.cellsPerPixel - cellsPerPixel);
+  m_view.y += m_cursorY * (m_view.cellsPerPixel - cellsPerPixel);
+  m_view.cellsPerPixel = cellsPerPixel;
 }
 
 void Application::handleMouseAction() {
   // dont do anything if imgui is using the mouse
   if (ImGui::GetIO().WantCaptureMouse) return;
 
-  if (m_isRunningOnGPU) return;  // on gpu we handle clicks in the shader
-
-  if (m_mousePosX > 0 && m_mousePosX <= m_gridWidth && m_mousePosY > 0 &&
-      m_mousePosY <= m_gridHeight) {
-    v_conc[m_mousePosY * m_gridWidth + m_mousePosX] = 1.0f;
-  }
+  BrushEvent event;
+  event.x = m_mousePosX;
+  event.y = m_mousePosY;
+  event.radius = m_brushRadius;
+  event.shape = (BrushShape)m_brushShape;
+  event.u = m_brushErase ? 1.0f : 0.0f;
+  event.v = m_brushErase ? 0.0f : 1.0f;
+  m_brush.push(event);
 }
 
 void Application::updateConcentrationTexture() {
-  glBindTexture(GL_TEXTURE_2D, m_concentrationTex);
-  glTexSubImage2D(
-      GL_TEXTURE_2D, 0, 0, 0, m_gridWidth, m_gridHeight, GL_RED, GL_FLOAT, v_conc.data()
-  );
+  const SimulationThread::Snapshot& snapshot = m_simulation.snapshot();
+
+  // a snapshot taken before a pending resize or view change reached the
+  // simulation thread may not fit
+  if (snapshot.width > m_cpuTexture.width() || snapshot.height > m_cpuTexture.height()) return;
+
+  if (!snapshot.external)
+    m_cpuTexture.uploadFromMemory(snapshot.v, snapshot.width, snapshot.height);
+  else if (snapshot.storageGeneration == m_cpuStorageGeneration)  // already in the mapped buffer
+    m_cpuTexture.upload(m_simulation.snapshotSlot(), snapshot.width, snapshot.height);
+  else
+    return;
+  m_cpuView = snapshot.view;
 }
 
 void Application::initDefaultBuffers() {
@@ -235,11 +790,11 @@ void Application::initDefaultBuffers() {
 
   glGenBuffers(1, &VBO);
   glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(VERTICES), VERTICES, GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), QUAD_VERTICES, GL_STATIC_DRAW);
 
   glGenBuffers(1, &EBO);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(INDICES), INDICES, GL_STATIC_DRAW);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(QUAD_INDICES), QUAD_INDICES, GL_STATIC_DRAW);
 
   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
   glEnableVertexAttribArray(0);
@@ -249,59 +804,14 @@ void Application::initDefaultBuffers() {
   m_defaultBuffersInitializated = true;
 }
 
-void Application::initBuffersCPUComp() {
-  // concentration texture
-  glGenTextures(1, &m_concentrationTex);
-  glBindTexture(GL_TEXTURE_2D, m_concentrationTex);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_gridWidth, m_gridHeight, 0, GL_RED, GL_FLOAT, nullptr);
-
-  glBindTexture(GL_TEXTURE_2D, 0);
-
-  m_cpuCompTexturesInitialized = true;
-}
-
-void Application::initBuffersGPUComp() {
-  // create framebuffer
-  glGenFramebuffers(1, &FBO);
-  glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-
-  // src texture
-  glGenTextures(1, &m_srcTex);
-  glBindTexture(GL_TEXTURE_2D, m_srcTex);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-  std::vector<float> data(m_gridWidth * m_gridHeight * 2);
-  for (int i = 0; i < m_gridWidth * m_gridHeight; ++i) {
-    data[2 * i] = 0.0f;      // initialize u with 1s
-    data[2 * i + 1] = 1.0f;  // initialize v with 0s
-  }
-
-  glTexImage2D(
-      GL_TEXTURE_2D, 0, GL_RG32F, m_gridWidth, m_gridHeight, 0, GL_RG, GL_FLOAT, data.data()
+void Application::resizeCPUTexture() {
+  // detach first: the simulation thread may be writing into the old buffer
+  m_simulation.setSnapshotStorage(nullptr, 0);
+  m_cpuTexture.resize(
+      std::min(m_gridWidth, m_windowWidth + 2), std::min(m_gridHeight, m_windowHeight + 2)
   );
 
-  // dest texture
-  glGenTextures(1, &m_destTex);
-  glBindTexture(GL_TEXTURE_2D, m_destTex);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, m_gridWidth, m_gridHeight, 0, GL_RG, GL_FLOAT, nullptr);
-
-  // setup framebuffer
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_destTex, 0);
-
-  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-    std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-  m_gpuCompTexturesInitialized = true;
+  if (m_cpuTexture.slots())
+    m_cpuStorageGeneration =
+        m_simulation.setSnapshotStorage(m_cpuTexture.slots(), m_cpuTexture.slotCapacity());
 }
-
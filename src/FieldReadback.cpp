@@ -0,0 +1,73 @@
+#include "FieldReadback.h"
+
+FieldReadback::~FieldReadback() {
+  clear();
+  for (Slot& slot : m_slots) {
+    if (slot.buffer) glDeleteBuffers(1, &slot.buffer);
+  }
+}
+
+void FieldReadback::capture(u32 texture, i32 width, i32 height, u64 step, FieldRecorder& recorder) {
+  if (m_count == SLOTS) poll(recorder);
+  if (m_count == SLOTS) {
+    recorder.noteDropped();
+    return;
+  }
+
+  Slot& slot = m_slots[(m_head + m_count) % SLOTS];
+  const usize bytes = (usize)width * height * 2 * sizeof(f32);
+
+  if (!slot.buffer) glGenBuffers(1, &slot.buffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  if (slot.bytes != bytes) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    slot.bytes = bytes;
+  }
+
+  // with a PBO bound this only queues the copy; the pointer is an offset
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_FLOAT, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.step = step;
+  slot.width = width;
+  slot.height = height;
+  m_count++;
+}
+
+void FieldReadback::poll(FieldRecorder& recorder) {
+  while (m_count > 0) {
+    Slot& slot = m_slots[m_head];
+
+    // flushes once so the fence is guaranteed to signal eventually, never waits
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED) break;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    auto* data = (const f32*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.bytes, GL_MAP_READ_BIT);
+    if (data) {
+      recorder.submit(slot.step, slot.width, slot.height, data + 1, data, 2 * slot.width, 2);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+      recorder.noteDropped();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_head = (m_head + 1) % SLOTS;
+    m_count--;
+  }
+}
+
+void FieldReadback::clear() {
+  for (; m_count > 0; m_count--, m_head = (m_head + 1) % SLOTS) {
+    Slot& slot = m_slots[m_head];
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+  }
+  m_head = 0;
+}
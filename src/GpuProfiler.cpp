@@ -0,0 +1,73 @@
+#include "GpuProfiler.h"
+
+#include <glad/glad.h>
+
+GpuProfiler::GpuProfiler(Profiler& profiler)
+    : m_profiler(profiler), m_track(profiler.createTrack("GPU")) {
+  for (Frame& frame : m_frames) glGenQueries(2 * MAX_SCOPES, frame.queries);
+}
+
+GpuProfiler::~GpuProfiler() {
+  for (Frame& frame : m_frames) glDeleteQueries(2 * MAX_SCOPES, frame.queries);
+}
+
+void GpuProfiler::beginFrame() {
+  static const ScopeId FRAME = Profiler::intern("GPU frame");
+
+  m_current = (m_current + 1) % FRAMES_IN_FLIGHT;
+  Frame& frame = m_frames[m_current];
+  if (frame.pending) collect(frame);
+
+  // GL_TIMESTAMP read through glGet is the GPU clock "now", without waiting
+  // for queued work; it anchors this frame's queries to the profiler clock
+  GLint64 gpuNow = 0;
+  glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+  frame.offsetNs = m_profiler.now() - gpuNow;
+  frame.count = 0;
+  frame.pending = true;
+
+  m_frameScope = begin(FRAME);
+}
+
+void GpuProfiler::endFrame() { end(m_frameScope); }
+
+i32 GpuProfiler::begin(ScopeId id) {
+  Frame& frame = m_frames[m_current];
+  if (frame.count == MAX_SCOPES) {
+    ++m_lost;
+    return -1;
+  }
+
+  i32 index = frame.count++;
+  frame.ids[index] = id;
+  glQueryCounter(frame.queries[2 * index], GL_TIMESTAMP);
+  return index;
+}
+
+void GpuProfiler::end(i32 index) {
+  if (index < 0) return;
+  glQueryCounter(m_frames[m_current].queries[2 * index + 1], GL_TIMESTAMP);
+}
+
+void GpuProfiler::collect(Frame& frame) {
+  frame.pending = false;
+  if (frame.count == 0) return;
+
+  // the last query written is the frame end; if that one is done, all are
+  GLint available = 0;
+  glGetQueryObjectiv(frame.queries[2 * 0 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    m_lost += frame.count;
+    return;
+  }
+
+  for (i32 i = 0; i < frame.count; ++i) {
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(frame.queries[2 * i], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(frame.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+
+    m_profiler.record(
+        m_track, frame.ids[i], (i64)begin + frame.offsetNs, (i64)end + frame.offsetNs
+    );
+  }
+}
@@ -0,0 +1,480 @@
+#include "GpuSolver.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Quad.h"
+#include "types.h"
+
+// std140 layout of the SimParams uniform block
+struct alignas(16) SimParamsBlock {
+  f32 F, k, Du, Dv;
+  f32 dt, activityThreshold;
+};
+
+static constexpr u32 SIM_PARAMS_BINDING = 0;
+
+// shader storage bindings of the activity mask
+static constexpr u32 TILE_LIST_BINDING = 1;
+static constexpr u32 TILE_REST_BINDING = 2;
+static constexpr u32 TILE_COMPUTED_BINDING = 3;
+
+static constexpr i32 ACTIVITY_GROUP_SIZE = 64;  // local_size_x of activity.comp
+
+GpuSolver::GpuSolver(i32 width, i32 height, const GrayScottParams& params)
+    : m_width{std::max(width, 1)},
+      m_height{std::max(height, 1)},
+      m_params(params),
+      m_fragmentShader(VERTEX_SHADER_PATH, SIM_SHADER_PATH) {
+  glGenVertexArrays(1, &VAO);
+  glBindVertexArray(VAO);
+
+  glGenBuffers(1, &VBO);
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), QUAD_VERTICES, GL_STATIC_DRAW);
+
+  glGenBuffers(1, &EBO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(QUAD_INDICES), QUAD_INDICES, GL_STATIC_DRAW);
+
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+  glEnableVertexAttribArray(0);
+
+  glBindVertexArray(0);
+
+  glGenBuffers(1, &UBO);
+  glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(SimParamsBlock), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  compileComputeShaders();
+  initTextures();
+}
+
+GpuSolver::~GpuSolver() {
+  destroyTextures();
+  destroyActivity();
+
+  glDeleteBuffers(1, &UBO);
+  glDeleteBuffers(1, &VBO);
+  glDeleteBuffers(1, &EBO);
+  glDeleteVertexArrays(1, &VAO);
+
+  glDeleteProgram(m_fragmentShader.id());
+  if (m_computeShader) glDeleteProgram(m_computeShader->id());
+  if (m_computeTailShader) glDeleteProgram(m_computeTailShader->id());
+  if (m_activityShader) glDeleteProgram(m_activityShader->id());
+}
+
+void GpuSolver::resize(i32 width, i32 height) {
+  m_width = std::max(width, 1);
+  m_height = std::max(height, 1);
+
+  destroyTextures();
+  initTextures();
+}
+
+void GpuSolver::reset() {
+  std::vector<float> data(m_width * m_height * 2);
+  for (int i = 0; i < m_width * m_height; ++i) {
+    data[2 * i] = 1.0f;      // u
+    data[2 * i + 1] = 0.0f;  // v
+  }
+
+  glBindTexture(GL_TEXTURE_2D, texture());
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RG, GL_FLOAT, data.data());
+
+  m_step = 0;
+  m_activityValid = false;
+}
+
+void GpuSolver::setState(const f32* u, const f32* v, i32 stride) {
+  std::vector<float> data(m_width * m_height * 2);
+  for (i32 y = 0; y < m_height; ++y) {
+    for (i32 x = 0; x < m_width; ++x) {
+      data[2 * (y * m_width + x)] = u[y * stride + x];
+      data[2 * (y * m_width + x) + 1] = v[y * stride + x];
+    }
+  }
+
+  glBindTexture(GL_TEXTURE_2D, texture());
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RG, GL_FLOAT, data.data());
+  m_activityValid = false;
+}
+
+void GpuSolver::setState(StoragePrecision precision, const void* u, const void* v) {
+  const usize cells = (usize)m_width * m_height;
+  m_activityValid = false;
+  glBindTexture(GL_TEXTURE_2D, texture());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  if (precision == StoragePrecision::F16) {
+    std::vector<u16> data(cells * 2);
+    for (usize i = 0; i < cells; ++i) {
+      data[2 * i] = ((const u16*)u)[i];
+      data[2 * i + 1] = ((const u16*)v)[i];
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RG, GL_HALF_FLOAT, data.data());
+    return;
+  }
+
+  std::vector<f32> data(cells * 2);
+  if (precision == StoragePrecision::F32) {
+    for (usize i = 0; i < cells; ++i) {
+      data[2 * i] = ((const f32*)u)[i];
+      data[2 * i + 1] = ((const f32*)v)[i];
+    }
+  } else {
+    for (usize i = 0; i < cells; ++i) {
+      data[2 * i] = decodeValue(precision, ((const u16*)u)[i]);
+      data[2 * i + 1] = decodeValue(precision, ((const u16*)v)[i]);
+    }
+  }
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RG, GL_FLOAT, data.data());
+}
+
+void GpuSolver::getState(f32* u, f32* v, i32 stride) {
+  std::vector<f32> data((usize)m_width * m_height * 2);
+  glBindTexture(GL_TEXTURE_2D, texture());
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_FLOAT, data.data());
+
+  for (i32 y = 0; y < m_height; ++y) {
+    for (i32 x = 0; x < m_width; ++x) {
+      u[y * stride + x] = data[2 * (y * m_width + x)];
+      v[y * stride + x] = data[2 * (y * m_width + x) + 1];
+    }
+  }
+}
+
+void GpuSolver::setStoragePrecision(StoragePrecision precision) {
+  if (precision == StoragePrecision::BF16) precision = StoragePrecision::F16;
+  if (precision == m_precision) return;
+
+  std::vector<float> data(m_width * m_height * 2);
+  glBindTexture(GL_TEXTURE_2D, texture());
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_FLOAT, data.data());
+
+  const u64 step = m_step;
+  m_precision = precision;
+  destroyTextures();
+  initTextures();
+  compileComputeShaders();
+  m_step = step;
+
+  glBindTexture(GL_TEXTURE_2D, texture());
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RG, GL_FLOAT, data.data());
+}
+
+u32 GpuSolver::textureFormat() const {
+  return m_precision == StoragePrecision::F32 ? GL_RG32F : GL_RG16F;
+}
+
+void GpuSolver::setWorkGroupSize(i32 x, i32 y) {
+  if (x == m_workGroupX && y == m_workGroupY) return;
+
+  m_workGroupX = x;
+  m_workGroupY = y;
+  compileComputeShaders();
+  m_activityValid = false;  // tiles are work groups
+}
+
+void GpuSolver::setFusedSteps(i32 steps) {
+  steps = std::max(steps, 1);
+  if (steps == m_fusedSteps) return;
+
+  m_fusedSteps = steps;
+  compileComputeShaders();
+}
+
+void GpuSolver::compileComputeShaders() {
+  auto build = [&](i32 steps) {
+    std::string defines = "#define WG_X " + std::to_string(m_workGroupX) + "\n#define WG_Y " +
+                          std::to_string(m_workGroupY) + "\n#define STEPS " +
+                          std::to_string(steps) + "\n#define IMAGE_FORMAT " +
+                          (m_precision == StoragePrecision::F32 ? "rg32f" : "rg16f") + "\n" +
+                          (m_precision == StoragePrecision::F32 ? "" : "#define HALF_STORAGE\n") +
+                          (m_activityEnabled ? "#define SPARSE\n" : "");
+    return std::make_unique<Shader>(Shader::compute(SIM_COMPUTE_SHADER_PATH, defines));
+  };
+
+  if (m_computeShader) glDeleteProgram(m_computeShader->id());
+  if (m_computeTailShader) glDeleteProgram(m_computeTailShader->id());
+
+  m_computeShader = build(m_fusedSteps);
+  m_computeTailShader = m_fusedSteps > 1 ? build(1) : nullptr;
+}
+
+void GpuSolver::uploadParams() {
+  SimParamsBlock block{};
+  block.F = m_params.F;
+  block.k = m_params.k;
+  block.Du = m_params.Du;
+  block.Dv = m_params.Dv;
+  block.dt = m_params.dt;
+  block.activityThreshold = m_activityThreshold;
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, SIM_PARAMS_BINDING, UBO);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+}
+
+void GpuSolver::applyStamps(const std::vector<BrushStamp>& stamps) {
+  const std::vector<BrushSpan> spans = rasterizeStamps(stamps, m_width, m_height);
+  if (spans.empty()) return;
+
+  for (const BrushSpan& span : spans) {
+    const f32 value[2] = {span.u, span.v};
+    glClearTexSubImage(
+        m_textures[m_current], 0, span.x0, span.y, 0, span.x1 - span.x0, 1, 1, GL_RG, GL_FLOAT,
+        value
+    );
+  }
+
+  // the next dispatch reads the texture as an image; the fragment path's
+  // texelFetch is ordered after the clear by GL already
+  glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  // stamped tiles are no longer at rest, so they and their neighbours get listed
+  if (!sparse() || !m_activityValid) return;
+
+  const u32 zero = 0;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileRest);
+  for (const BrushSpan& span : spans) {
+    const i32 row = span.y / m_workGroupY * m_tilesX;
+    const i32 tx0 = span.x0 / m_workGroupX, tx1 = (span.x1 - 1) / m_workGroupX;
+    glClearBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, GL_R32UI, (row + tx0) * sizeof(u32),
+        (tx1 - tx0 + 1) * sizeof(u32), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero
+    );
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuSolver::step(i32 n) {
+  if (n <= 0) return;
+
+  uploadParams();
+
+  if (m_backend == GpuBackend::Compute)
+    stepCompute(n);
+  else
+    stepFragment(n);
+
+  m_step += n;
+}
+
+void GpuSolver::stepFragment(i32 n) {
+  glViewport(0, 0, m_width, m_height);
+
+  m_fragmentShader.use();
+  m_fragmentShader.setBool("halfStorage", m_precision != StoragePrecision::F32);
+  glBindVertexArray(VAO);
+  glActiveTexture(GL_TEXTURE0);
+
+  for (i32 i = 0; i < n; ++i) {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbos[m_current ^ 1]);
+    glBindTexture(GL_TEXTURE_2D, m_textures[m_current]);
+
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+    m_current ^= 1;
+  }
+
+  glBindVertexArray(0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GpuSolver::stepCompute(i32 n) {
+  const i32 fused = n / m_fusedSteps;
+  const i32 tail = n % m_fusedSteps;
+
+  if (sparse()) {
+    if (!m_activityValid) resetActivity();
+    readActiveTileFraction();
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_LIST_BINDING, m_tileList);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_REST_BINDING, m_tileRest);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_COMPUTED_BINDING, m_tileComputed);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_tileList);
+
+    m_activityShader->use();
+    glUniform2i(glGetUniformLocation(m_activityShader->id(), "tileCount"), m_tilesX, m_tilesY);
+  }
+
+  for (i32 i = 0; i < fused; ++i) dispatch(*m_computeShader);
+  for (i32 i = 0; i < tail; ++i) dispatch(*m_computeTailShader);
+
+  if (!sparse()) return;
+
+  // keep the computed-tile count of the last dispatch, unless the ring is full
+  u32& buffer = m_fractionBuffers[m_fractionSlot];
+  if (m_fractionFences[m_fractionSlot]) return;
+
+  if (!buffer) {
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(u32), nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_COPY_READ_BUFFER, m_tileList);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 3 * sizeof(u32), 0, sizeof(u32));
+
+  m_fractionFences[m_fractionSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  m_fractionSlot = (m_fractionSlot + 1) % FRACTION_SLOTS;
+}
+
+void GpuSolver::dispatch(const Shader& program) {
+  glBindImageTexture(0, m_textures[m_current], 0, GL_FALSE, 0, GL_READ_ONLY, textureFormat());
+  glBindImageTexture(1, m_textures[m_current ^ 1], 0, GL_FALSE, 0, GL_WRITE_ONLY, textureFormat());
+
+  if (sparse()) {
+    // list this dispatch's tiles from the rest flags the previous one left
+    const u32 zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileList);
+    glClearBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(u32), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero
+    );
+    glClearBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, GL_R32UI, 3 * sizeof(u32), sizeof(u32), GL_RED_INTEGER,
+        GL_UNSIGNED_INT, &zero
+    );
+
+    m_activityShader->use();
+    const i32 tiles = m_tilesX * m_tilesY;
+    glDispatchCompute((tiles + ACTIVITY_GROUP_SIZE - 1) / ACTIVITY_GROUP_SIZE, 1, 1);
+    glMemoryBarrier(
+        GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT
+    );
+
+    program.use();
+    glDispatchComputeIndirect(0);
+  } else {
+    const u32 groupsX = (m_width + m_workGroupX - 1) / m_workGroupX;
+    const u32 groupsY = (m_height + m_workGroupY - 1) / m_workGroupY;
+
+    program.use();
+    glDispatchCompute(groupsX, groupsY, 1);
+  }
+
+  // next step reads the result as an image, the display pass as a texture; the
+  // rest flags feed the next activity pass
+  glMemoryBarrier(
+      GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT |
+      GL_SHADER_STORAGE_BARRIER_BIT
+  );
+
+  m_current ^= 1;
+}
+
+void GpuSolver::setActivityMask(bool enabled, f32 threshold) {
+  m_activityThreshold = std::max(threshold, 0.0f);
+  m_activityValid = false;
+  if (enabled == m_activityEnabled) return;
+
+  m_activityEnabled = enabled;
+  if (enabled && !m_activityShader)
+    m_activityShader = std::make_unique<Shader>(Shader::compute(ACTIVITY_SHADER_PATH));
+  compileComputeShaders();
+}
+
+void GpuSolver::resetActivity() {
+  destroyActivity();
+
+  m_tilesX = (m_width + m_workGroupX - 1) / m_workGroupX;
+  m_tilesY = (m_height + m_workGroupY - 1) / m_workGroupY;
+  const usize tiles = (usize)m_tilesX * m_tilesY;
+
+  // nothing known to be at rest, and both textures may differ everywhere
+  std::vector<u32> list(4 + tiles, 0), rest(tiles, 0), computed(tiles, 1);
+  list[1] = list[2] = 1;  // groups y / z
+
+  auto create = [](u32& buffer, const std::vector<u32>& data) {
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, data.size() * sizeof(u32), data.data(), GL_DYNAMIC_COPY
+    );
+  };
+  create(m_tileList, list);
+  create(m_tileRest, rest);
+  create(m_tileComputed, computed);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  m_activityValid = true;
+}
+
+void GpuSolver::destroyActivity() {
+  glDeleteBuffers(1, &m_tileList);
+  glDeleteBuffers(1, &m_tileRest);
+  glDeleteBuffers(1, &m_tileComputed);
+  m_tileList = m_tileRest = m_tileComputed = 0;
+
+  for (i32 i = 0; i < FRACTION_SLOTS; ++i) {
+    if (m_fractionFences[i]) glDeleteSync(m_fractionFences[i]);
+    m_fractionFences[i] = nullptr;
+    glDeleteBuffers(1, &m_fractionBuffers[i]);
+    m_fractionBuffers[i] = 0;
+  }
+}
+
+void GpuSolver::readActiveTileFraction() {
+  // oldest first; stops at the first copy still in flight
+  for (i32 i = 0; i < FRACTION_SLOTS; ++i) {
+    const i32 slot = (m_fractionSlot + i) % FRACTION_SLOTS;
+    if (!m_fractionFences[slot]) continue;
+
+    GLenum status = glClientWaitSync(m_fractionFences[slot], 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) break;
+
+    glDeleteSync(m_fractionFences[slot]);
+    m_fractionFences[slot] = nullptr;
+
+    u32 computed = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, m_fractionBuffers[slot]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(u32), &computed);
+    m_activeTileFraction = (f64)computed / std::max(m_tilesX * m_tilesY, 1);
+  }
+}
+
+f64 GpuSolver::activeTileFraction() const { return sparse() ? m_activeTileFraction : 1.0; }
+
+void GpuSolver::initTextures() {
+  glGenTextures(2, m_textures);
+  glGenFramebuffers(2, m_fbos);
+
+  for (i32 i = 0; i < 2; ++i) {
+    glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, textureFormat(), m_width, m_height, 0, GL_RG, GL_FLOAT, nullptr);
+
+    // setup framebuffer
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbos[i]);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_textures[i], 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+      std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  m_current = 0;
+  reset();
+  m_activityValid = false;
+}
+
+void GpuSolver::destroyTextures() {
+  glDeleteFramebuffers(2, m_fbos);
+  glDeleteTextures(2, m_textures);
+}
+
+const char* GpuSolver::backendName(GpuBackend backend) {
+  switch (backend) {
+    case GpuBackend::Fragment: return "Fragment (FBO ping-pong)";
+    case GpuBackend::Compute: return "Compute (shared-memory tiles)";
+    default: return "Unknown";
+  }
+}
@@ -0,0 +1,99 @@
+#include "GpuSweep.h"
+
+#include <algorithm>
+
+#include "Seeding.h"
+
+static constexpr u32 POINTS_BINDING = 0;
+
+GpuSweep::GpuSweep(i32 size, const std::vector<SweepPoint>& points, const GrayScottParams& shared)
+    : m_size{std::max(size, 1)},
+      m_layers{std::clamp((i32)points.size(), 1, maxLayers())},
+      m_shared(shared),
+      m_shader(Shader::compute(SWEEP_SHADER_PATH)) {
+  glCreateTextures(GL_TEXTURE_2D_ARRAY, 2, m_textures);
+  for (u32 texture : m_textures) {
+    glTextureStorage3D(texture, 1, GL_RG32F, m_size, m_size, m_layers);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  }
+
+  // a tightly packed vec2 per layer (std430)
+  std::vector<f32> data(2 * (usize)m_layers);
+  for (i32 i = 0; i < m_layers; ++i) {
+    const SweepPoint p = i < (i32)points.size() ? points[i] : SweepPoint{shared.F, shared.k};
+    data[2 * i] = p.F;
+    data[2 * i + 1] = p.k;
+  }
+  glCreateBuffers(1, &m_points);
+  glNamedBufferStorage(m_points, data.size() * sizeof(f32), data.data(), 0);
+
+  seed(1);
+}
+
+GpuSweep::~GpuSweep() {
+  glDeleteTextures(2, m_textures);
+  glDeleteBuffers(1, &m_points);
+  glDeleteProgram(m_shader.id());
+}
+
+i32 GpuSweep::maxLayers() {
+  GLint layers = 0;
+  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layers);
+  return std::max(layers, 1);
+}
+
+void GpuSweep::seed(u32 seed) {
+  const usize cells = (usize)m_size * m_size;
+  std::vector<f32> u(cells, 1.0f), v(cells, 0.0f);
+  seedSquares(u.data(), v.data(), m_size, m_size, m_size, seed);
+
+  std::vector<f32> data(2 * cells);
+  for (usize i = 0; i < cells; ++i) {
+    data[2 * i] = u[i];
+    data[2 * i + 1] = v[i];
+  }
+
+  m_current = 0;
+  for (i32 layer = 0; layer < m_layers; ++layer) {
+    glTextureSubImage3D(
+        m_textures[m_current], 0, 0, 0, layer, m_size, m_size, 1, GL_RG, GL_FLOAT, data.data()
+    );
+  }
+  m_step = 0;
+}
+
+void GpuSweep::step(i32 n) {
+  m_shader.use();
+  m_shader.setFloat("Du", m_shared.Du);
+  m_shader.setFloat("Dv", m_shared.Dv);
+  m_shader.setFloat("dt", m_shared.dt);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINTS_BINDING, m_points);
+
+  const i32 groups = (m_size + GROUP_SIZE - 1) / GROUP_SIZE;
+  for (i32 i = 0; i < n; ++i) {
+    glBindImageTexture(0, m_textures[m_current], 0, GL_TRUE, 0, GL_READ_ONLY, GL_RG32F);
+    glBindImageTexture(1, m_textures[m_current ^ 1], 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RG32F);
+    glDispatchCompute(groups, groups, m_layers);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    m_current ^= 1;
+  }
+  m_step += n;
+}
+
+void GpuSweep::copyRun(i32 run, f32* u, f32* v) {
+  const usize cells = (usize)m_size * m_size;
+  std::vector<f32> data(2 * cells);
+
+  glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glGetTextureSubImage(
+      m_textures[m_current], 0, 0, 0, run, m_size, m_size, 1, GL_RG, GL_FLOAT,
+      (GLsizei)(data.size() * sizeof(f32)), data.data()
+  );
+
+  for (usize i = 0; i < cells; ++i) {
+    u[i] = data[2 * i];
+    v[i] = data[2 * i + 1];
+  }
+}
@@ -0,0 +1,67 @@
+#include "GpuTuner.h"
+
+#include <glad/glad.h>
+
+#include "GpuSolver.h"
+
+// the sizes the Performance panel offers
+static constexpr i32 WORK_GROUPS[][2] = {{8, 8}, {16, 16}, {32, 8}, {32, 32}};
+static constexpr i32 FUSED_STEPS[] = {1, 2, 4};
+
+std::string glRendererName() {
+  const char* renderer = (const char*)glGetString(GL_RENDERER);
+  return renderer ? renderer : "unknown";
+}
+
+std::vector<TuningCandidate> tuneGpu(
+    i32 width, i32 height, const std::vector<f32>& state, const TuningOptions& options
+) {
+  std::vector<TunedConfig> configs;
+  TunedConfig fragment;
+  fragment.gpu = true;
+  fragment.gpuBackend = (i32)GpuBackend::Fragment;
+  configs.push_back(fragment);
+
+  for (const auto& wg : WORK_GROUPS) {
+    for (i32 fused : FUSED_STEPS) {
+      if (fused > options.stepsPerFrame) continue;
+      TunedConfig c = fragment;
+      c.gpuBackend = (i32)GpuBackend::Compute;
+      c.gpuWorkGroupX = wg[0];
+      c.gpuWorkGroupY = wg[1];
+      c.gpuFusedSteps = fused;
+      configs.push_back(c);
+    }
+  }
+
+  if (options.allowReducedPrecision) {
+    const usize n = configs.size();
+    for (usize i = 0; i < n; ++i) {
+      TunedConfig c = configs[i];
+      c.precision = StoragePrecision::F16;
+      configs.push_back(c);
+    }
+  }
+
+  GpuSolver solver(width, height);
+  std::vector<TuningCandidate> candidates;
+  for (TunedConfig c : configs) {
+    c.stepsPerFrame = options.stepsPerFrame;
+    solver.setBackend((GpuBackend)c.gpuBackend);
+    solver.setWorkGroupSize(c.gpuWorkGroupX, c.gpuWorkGroupY);
+    solver.setFusedSteps(c.gpuFusedSteps);
+    solver.setStoragePrecision(c.precision);
+    solver.setState(state.data(), state.data() + (usize)width * height, width);
+
+    c.stepsPerSecond = measureStepRate(
+        [&] {
+          solver.step(options.stepsPerFrame);
+          glFinish();
+        },
+        options.stepsPerFrame, options.secondsPerCandidate
+    );
+
+    candidates.push_back({tunedConfigName(c), c});
+  }
+  return candidates;
+}
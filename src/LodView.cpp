@@ -0,0 +1,45 @@
+#include "LodView.h"
+
+#include <algorithm>
+
+#include <glad/glad.h>
+
+LodView::LodView() : m_shader(Shader::compute(LOD_SHADER_PATH)) {}
+
+LodView::~LodView() {
+  if (m_texture) glDeleteTextures(1, &m_texture);
+  glDeleteProgram(m_shader.id());
+}
+
+void LodView::update(u32 stateTexture, i32 gridWidth, i32 gridHeight, const ViewRect& rect) {
+  const i32 texelsX = rect.texelsX(), texelsY = rect.texelsY();
+  if (texelsX <= 0 || texelsY <= 0) return;
+
+  // grows only: the view's texel count follows the window, which rarely shrinks for long
+  if (texelsX > m_capacityX || texelsY > m_capacityY) {
+    if (m_texture) glDeleteTextures(1, &m_texture);
+    m_capacityX = std::max(texelsX, m_capacityX);
+    m_capacityY = std::max(texelsY, m_capacityY);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_texture);
+    glTextureStorage2D(m_texture, 1, GL_R32F, m_capacityX, m_capacityY);
+    glTextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  }
+
+  m_shader.use();
+  m_shader.setInt("level", rect.level);
+  m_shader.setIVec2("origin", rect.x0, rect.y0);
+  m_shader.setIVec2(
+      "lastCell", std::min(rect.x0 + rect.width, gridWidth) - 1,
+      std::min(rect.y0 + rect.height, gridHeight) - 1
+  );
+  m_shader.setIVec2("texels", texelsX, texelsY);
+
+  glBindTextureUnit(0, stateTexture);
+  glBindImageTexture(0, m_texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+  glDispatchCompute(
+      (texelsX + GROUP_SIZE - 1) / GROUP_SIZE, (texelsY + GROUP_SIZE - 1) / GROUP_SIZE, 1
+  );
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
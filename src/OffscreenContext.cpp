@@ -0,0 +1,89 @@
+#include "OffscreenContext.h"
+
+#include <cstring>
+
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+
+static bool fail(std::string* error, const char* reason) {
+  if (error) *error = reason;
+  return false;
+}
+
+OffscreenContext::~OffscreenContext() { destroy(); }
+
+void OffscreenContext::destroy() {
+  if (m_display == EGL_NO_DISPLAY) return;
+
+  eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (m_surface != EGL_NO_SURFACE) eglDestroySurface(m_display, m_surface);
+  if (m_context != EGL_NO_CONTEXT) eglDestroyContext(m_display, m_context);
+  eglTerminate(m_display);
+
+  m_display = EGL_NO_DISPLAY;
+  m_context = EGL_NO_CONTEXT;
+  m_surface = EGL_NO_SURFACE;
+  m_renderer.clear();
+}
+
+bool OffscreenContext::create(std::string* error) {
+  destroy();
+  if (init(error)) return true;
+
+  destroy();
+  return false;
+}
+
+bool OffscreenContext::init(std::string* error) {
+  auto getPlatformDisplay =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+  const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+  if (getPlatformDisplay && clientExtensions &&
+      std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  if (m_display == EGL_NO_DISPLAY) m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  EGLint major, minor;
+  if (m_display == EGL_NO_DISPLAY) return fail(error, "no EGL display");
+  if (!eglInitialize(m_display, &major, &minor)) {
+    m_display = EGL_NO_DISPLAY;
+    return fail(error, "cannot initialize the EGL display");
+  }
+  if (!eglBindAPI(EGL_OPENGL_API)) return fail(error, "EGL driver has no desktop OpenGL");
+
+  const EGLint configAttribs[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE
+  };
+  EGLConfig config = nullptr;
+  EGLint configCount = 0;
+  eglChooseConfig(m_display, configAttribs, &config, 1, &configCount);
+
+  for (EGLint minorVersion : {6, 5}) {
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE
+    };
+    m_context = eglCreateContext(
+        m_display, configCount ? config : nullptr, EGL_NO_CONTEXT, contextAttribs
+    );
+    if (m_context != EGL_NO_CONTEXT) break;
+  }
+  if (m_context == EGL_NO_CONTEXT) return fail(error, "no GL 4.5 core context");
+
+  // without surfaceless contexts, a pbuffer stands in for the default framebuffer
+  const char* extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+  if (!extensions || !std::strstr(extensions, "EGL_KHR_surfaceless_context")) {
+    const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    m_surface = eglCreatePbufferSurface(m_display, config, pbufferAttribs);
+    if (m_surface == EGL_NO_SURFACE) return fail(error, "no pbuffer surface");
+  }
+
+  if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context))
+    return fail(error, "cannot make the context current");
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    return fail(error, "cannot load GL functions");
+
+  m_renderer = (const char*)glGetString(GL_RENDERER);
+  return true;
+}
@@ -0,0 +1,86 @@
+#include "StreamingTexture.h"
+
+void StreamingTexture::resize(i32 width, i32 height) {
+  destroy();
+
+  m_width = width;
+  m_height = height;
+
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_width, m_height, 0, GL_RED, GL_FLOAT, nullptr);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  if (!GLAD_GL_VERSION_4_4) return;
+
+  m_slotCapacity = (usize)m_width * m_height;
+
+  // coherent: writes from the simulation thread need no explicit flush
+  const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  const GLsizeiptr bytes = SLOTS * m_slotCapacity * sizeof(f32);
+
+  glGenBuffers(1, &m_pbo);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+  glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, flags);
+  f32* mapped = (f32*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, flags);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  if (!mapped) {
+    glDeleteBuffers(1, &m_pbo);
+    m_pbo = 0;
+    return;
+  }
+
+  for (i32 i = 0; i < SLOTS; ++i) m_slots[i] = mapped + i * m_slotCapacity;
+}
+
+void StreamingTexture::upload(i32 slot, i32 width, i32 height) {
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+
+  // with a PBO bound the pointer argument is a byte offset into it
+  const usize offset = slot * m_slotCapacity * sizeof(f32);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_FLOAT, (const void*)offset);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  if (m_fences[slot]) glDeleteSync(m_fences[slot]);
+  m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamingTexture::uploadFromMemory(const f32* data, i32 width, i32 height) {
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_FLOAT, data);
+}
+
+void StreamingTexture::waitForSlot(i32 slot) {
+  if (!m_fences[slot]) return;
+
+  // usually signaled already: the upload was queued at least a frame ago
+  for (;;) {
+    GLenum status = glClientWaitSync(m_fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+    if (status != GL_TIMEOUT_EXPIRED) break;
+  }
+
+  glDeleteSync(m_fences[slot]);
+  m_fences[slot] = nullptr;
+}
+
+void StreamingTexture::destroy() {
+  for (GLsync& fence : m_fences) {
+    if (fence) glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  // deleting a mapped buffer unmaps it
+  if (m_pbo) glDeleteBuffers(1, &m_pbo);
+  if (m_texture) glDeleteTextures(1, &m_texture);
+
+  m_pbo = m_texture = 0;
+  for (f32*& slot : m_slots) slot = nullptr;
+  m_slotCapacity = 0;
+}
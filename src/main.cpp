@@ -11,6 +11,7 @@
 #include "Application.h"
 #include "types.h"
 
+#include "GpuProfiler.h"
 #include "Profiler.h"
 #include "ProfilerUI.h"
 
@@ -27,6 +28,7 @@ bool g_wireframeActive = false;
 bool g_draggingMouse = false;
 bool g_drawUI = true;
 bool g_drawProfiler = false;
+Profiler* g_profiler;
 
 void windowSizeCallback(GLFWwindow* window, i32 width, i32 height) {
   glViewport(0, 0, width, height);
@@ -46,10 +48,18 @@ void keyCallback(GLFWwindow* window, i32 key, i32 scancode, i32 action, i32 mods
     g_drawProfiler = !g_drawProfiler;
   } else if (action == GLFW_PRESS && key == GLFW_KEY_I) {
     g_drawUI = !g_drawUI;
+  } else if (action == GLFW_PRESS && key == GLFW_KEY_T) {
+    // start recording a trace, or stop and save it
+    if (!g_profiler->isTracing())
+      g_profiler->startTrace();
+    else if (g_profiler->writeTrace(TRACE_PATH))
+      std::cout << "Trace written to " << TRACE_PATH << '\n';
   } else if (action == GLFW_PRESS && key == GLFW_KEY_R) {
     if (g_app) g_app->resetConcentrations();
   } else if (action == GLFW_PRESS && key == GLFW_KEY_G) {
     if (g_app) g_app->toggleGPUComputation();
+  } else if (action == GLFW_PRESS && key == GLFW_KEY_F) {
+    if (g_app) g_app->fitView();
   } else if (action == GLFW_PRESS && (key == GLFW_KEY_ESCAPE || key == GLFW_KEY_Q)) {
     glfwSetWindowShouldClose(window, true);
   }
@@ -60,6 +70,12 @@ void mouse_button_callback(GLFWwindow* window, i32 button, i32 action, i32 mods)
     if (g_app) g_app->setDraggingMouse(true);
   if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE)
     if (g_app) g_app->setDraggingMouse(false);
+  if (button == GLFW_MOUSE_BUTTON_RIGHT)
+    if (g_app) g_app->setPanning(action == GLFW_PRESS);
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+  if (g_app) g_app->zoom(yoffset);
 }
 
 void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -93,6 +109,7 @@ void initGLFW() {
   glfwSetKeyCallback(g_window, keyCallback);
   glfwSetMouseButtonCallback(g_window, mouse_button_callback);
   glfwSetCursorPosCallback(g_window, cursor_position_callback);
+  glfwSetScrollCallback(g_window, scroll_callback);
 }
 
 void initOpenGL() {
@@ -130,47 +147,55 @@ int main() {
   initOpenGL();
   initImgui();
 
-  Profiler profiler;
+  // the GPU profiler deletes its queries on destruction, so it must go while
+  // the context is still current
+  {
+    Profiler profiler;
+    profiler.setThreadName("Render");
+    g_profiler = &profiler;
 
-  i32 w, h;
-  glfwGetWindowSize(g_window, &w, &h);
-  g_app = new Application(w, h, 10, profiler);
+    GpuProfiler gpuProfiler(profiler);
 
-  const f32 sim_dt = 1.0f;
+    i32 w, h;
+    glfwGetWindowSize(g_window, &w, &h);
+    g_app = new Application(w, h, 10, profiler, gpuProfiler);
 
-  while (!glfwWindowShouldClose(g_window)) {
-    profiler.beginFrame();
-    glfwSwapBuffers(g_window);
+    while (!glfwWindowShouldClose(g_window)) {
+      profiler.beginFrame();
+      glfwSwapBuffers(g_window);
+      gpuProfiler.beginFrame();
 
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+      glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT);
 
-    // imgui rendering
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+      // imgui rendering
+      ImGui_ImplOpenGL3_NewFrame();
+      ImGui_ImplGlfw_NewFrame();
+      ImGui::NewFrame();
 
-    if (!g_app->isRunningOnGPU()) {
-      Profiler::Scope _s(profiler, "Simulation");
-      for (i32 step = 0; step < g_app->getStepsPerFrame(); ++step) {
-        g_app->computeConcentrationsCPU(sim_dt);
-      }
-    }
+      // the CPU solver steps on its own thread; this only hands over input
+      if (!g_app->isRunningOnGPU()) g_app->updateSimulationCPU();
 
-    // render
-    g_app->render(g_drawUI);
+      // render
+      g_app->render(g_drawUI);
 
-    // profiling
-    profiler.endFrame();
-    if (g_drawProfiler) (DrawProfilerImGui(profiler));
+      // profiling
+      profiler.endFrame();
+      if (g_drawProfiler) (DrawProfilerImGui(profiler));
 
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+      ImGui::Render();
+      {
+        GPU_PROFILE_SCOPE(gpuProfiler, "GPU ImGui");
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+      }
+      gpuProfiler.endFrame();
 
-    glfwPollEvents();
-  }
+      glfwPollEvents();
+    }
 
-  delete g_app;
+    delete g_app;
+    g_profiler = nullptr;
+  }
 
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
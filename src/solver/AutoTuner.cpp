@@ -0,0 +1,244 @@
+#include "AutoTuner.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include "GrayScottSolver.h"
+#include "Seeding.h"
+#include "ThreadPool.h"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr char CACHE_HEADER[] = "# reaction_diffusion tuning cache v1";
+
+std::string tunedConfigName(const TunedConfig& c) {
+  std::string name;
+  if (!c.gpu) {
+    name = std::string("cpu ") + kernelIsaName(c.cpuKernel) + ", " + std::to_string(c.cpuThreads) +
+           (c.cpuThreads == 1 ? " thread" : " threads");
+    if (c.cpuBlockDepth > 1) name += ", block " + std::to_string(c.cpuBlockDepth);
+  } else if (c.gpuBackend == 0) {  // GpuBackend::Fragment
+    name = "gpu fragment";
+  } else {
+    name = "gpu compute " + std::to_string(c.gpuWorkGroupX) + "x" + std::to_string(c.gpuWorkGroupY);
+    if (c.gpuFusedSteps > 1) name += ", fused " + std::to_string(c.gpuFusedSteps);
+  }
+  return name + ", " + storagePrecisionName(c.precision);
+}
+
+std::string cpuModelName() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  for (std::string line; std::getline(cpuinfo, line);) {
+    if (line.rfind("model name", 0) == 0) return line.substr(line.find(':') + 2);
+  }
+  return "unknown";
+}
+
+f64 measureStepRate(const std::function<void()>& frame, i32 stepsPerFrame, f64 seconds) {
+  frame();  // warmup: first-touch, shader compiles, thread start
+
+  // best of three rounds, so a burst of other load costs one round, not the candidate
+  f64 best = 0;
+  for (i32 round = 0; round < 3; ++round) {
+    i32 frames = 0;
+    const auto t0 = Clock::now();
+    f64 elapsed = 0;
+    while (frames < 2 || elapsed < seconds / 3) {
+      frame();
+      ++frames;
+      elapsed = std::chrono::duration<f64>(Clock::now() - t0).count();
+    }
+    best = std::max(best, frames * (f64)stepsPerFrame / elapsed);
+  }
+  return best;
+}
+
+std::vector<f32> tuningState(i32 width, i32 height, const TuningOptions& options) {
+  GrayScottSolver solver(width, height);
+  solver.setThreadCount(ThreadPool::hardwareThreads());
+  solver.setKernelIsa(detectKernelIsa());
+  seedSquares(solver, 1);
+
+  const auto t0 = Clock::now();
+  for (i32 done = 0; done < options.warmupSteps; done += 100) {
+    solver.step(std::min(100, options.warmupSteps - done));
+    if (std::chrono::duration<f64>(Clock::now() - t0).count() > options.warmupSeconds) break;
+  }
+
+  const usize cells = (usize)width * height;
+  std::vector<f32> state(2 * cells);
+  solver.exportState(StoragePrecision::F32, state.data(), state.data() + cells);
+  return state;
+}
+
+std::vector<TuningCandidate> tuneCpu(
+    i32 width, i32 height, const std::vector<f32>& state, const TuningOptions& options
+) {
+  const i32 hw = ThreadPool::hardwareThreads();
+  std::vector<i32> threads{1};
+  if (hw / 2 > 1) threads.push_back(hw / 2);
+  if (hw > 1) threads.push_back(hw);
+
+  // AVX-512 can lose to AVX2 where it lowers the clock, so both are tried
+  const KernelIsa best = detectKernelIsa();
+  std::vector<KernelIsa> isas{best};
+  if (best == KernelIsa::AVX512) isas.push_back(KernelIsa::AVX2);
+
+  std::vector<i32> depths{1};
+  if (options.stepsPerFrame >= 4) depths.push_back(4);
+
+  std::vector<StoragePrecision> precisions{StoragePrecision::F32};
+  if (options.allowReducedPrecision) {
+    precisions.push_back(StoragePrecision::F16);
+    precisions.push_back(StoragePrecision::BF16);
+  }
+
+  GrayScottSolver solver(width, height);
+  std::vector<TuningCandidate> candidates;
+
+  for (StoragePrecision precision : precisions) {
+    for (i32 t : threads) {
+      for (KernelIsa isa : isas) {
+        for (i32 depth : depths) {
+          // reduced precision only at the best ISA, unblocked
+          if (precision != StoragePrecision::F32 && (isa != best || depth > 1)) continue;
+
+          TuningCandidate c;
+          c.config.stepsPerFrame = options.stepsPerFrame;
+          c.config.cpuThreads = t;
+          c.config.cpuKernel = isa;
+          c.config.cpuBlockDepth = depth;
+          c.config.precision = precision;
+
+          solver.setThreadCount(t);
+          solver.setKernelIsa(isa);
+          solver.setTemporalBlocking(depth);
+          solver.setStoragePrecision(precision);
+          solver.importState(
+              StoragePrecision::F32, state.data(), state.data() + (usize)width * height
+          );
+
+          c.config.stepsPerSecond = measureStepRate(
+              [&] { solver.step(options.stepsPerFrame); }, options.stepsPerFrame,
+              options.secondsPerCandidate
+          );
+          c.name = tunedConfigName(c.config);
+          candidates.push_back(c);
+        }
+      }
+    }
+  }
+  return candidates;
+}
+
+TunedConfig pickTunedConfig(const std::vector<TuningCandidate>& candidates) {
+  TunedConfig best;
+  for (const TuningCandidate& c : candidates)
+    if (c.config.stepsPerSecond > best.stepsPerSecond) best = c.config;
+
+  best.stepsPerFrame = std::clamp((i32)(best.stepsPerSecond / TUNING_TARGET_FPS), 1, 32);
+  return best;
+}
+
+// tabs and newlines would break the line format
+static std::string field(std::string s) {
+  for (char& c : s)
+    if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+  return s;
+}
+
+static std::string keyPrefix(const TuningKey& key) {
+  return field(key.cpu) + '\t' + field(key.glRenderer) + '\t' + std::to_string(key.width) + '\t' +
+         std::to_string(key.height) + '\t';
+}
+
+bool loadTunedConfig(const char* path, const TuningKey& key, TunedConfig& config) {
+  std::ifstream in(path);
+  std::string line;
+  if (!std::getline(in, line) || line != CACHE_HEADER) return false;
+
+  const std::string prefix = keyPrefix(key);
+  while (std::getline(in, line)) {
+    if (line.compare(0, prefix.size(), prefix) != 0) continue;
+
+    TunedConfig c;
+    i32 gpu, isa, precision;
+    const i32 fields = std::sscanf(
+        line.c_str() + prefix.size(), "%d %d %d %d %d %d %d %d %d %d %lf", &gpu,
+        &c.stepsPerFrame, &c.cpuThreads, &isa, &c.cpuBlockDepth, &c.gpuBackend, &c.gpuWorkGroupX,
+        &c.gpuWorkGroupY, &c.gpuFusedSteps, &precision, &c.stepsPerSecond
+    );
+    if (fields != 11 || isa < 0 || isa >= (i32)KernelIsa::Count || precision < 0 ||
+        precision >= (i32)StoragePrecision::Count)
+      return false;
+
+    c.gpu = gpu != 0;
+    c.cpuKernel = (KernelIsa)isa;
+    c.precision = (StoragePrecision)precision;
+    config = c;
+    return true;
+  }
+  return false;
+}
+
+bool saveTunedConfig(
+    const char* path, const TuningKey& key, const TunedConfig& c, std::string* error
+) {
+  // keep every other host's entry
+  const std::string prefix = keyPrefix(key);
+  std::vector<std::string> lines;
+  {
+    std::ifstream in(path);
+    std::string line;
+    if (std::getline(in, line) && line == CACHE_HEADER) {
+      while (std::getline(in, line))
+        if (!line.empty() && line.compare(0, prefix.size(), prefix) != 0) lines.push_back(line);
+    }
+  }
+
+  char values[256];
+  std::snprintf(
+      values, sizeof(values), "%d %d %d %d %d %d %d %d %d %d %.1f", (i32)c.gpu, c.stepsPerFrame,
+      c.cpuThreads, (i32)c.cpuKernel, c.cpuBlockDepth, c.gpuBackend, c.gpuWorkGroupX,
+      c.gpuWorkGroupY, c.gpuFusedSteps, (i32)c.precision, c.stepsPerSecond
+  );
+  lines.push_back(prefix + values);
+
+  const std::string tmp = std::string(path) + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    out << CACHE_HEADER << '\n';
+    for (const std::string& line : lines) out << line << '\n';
+    if (!out.flush()) {
+      if (error) *error = "cannot write " + tmp;
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), path) != 0) {
+    if (error) *error = "cannot replace " + std::string(path) + ": " + std::strerror(errno);
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string defaultTuningCachePath() {
+  std::string dir;
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+    dir = xdg;
+  else if (const char* home = std::getenv("HOME"); home && *home)
+    dir = std::string(home) + "/.cache";
+  else
+    return "rd_tuning.cache";
+
+  dir += "/reaction_diffusion";
+  if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return "rd_tuning.cache";
+  return dir + "/tuning.cache";
+}
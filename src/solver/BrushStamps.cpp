@@ -0,0 +1,140 @@
+#include "BrushStamps.h"
+
+#include <algorithm>
+#include <cmath>
+
+const char* brushShapeName(BrushShape shape) {
+  switch (shape) {
+    case BrushShape::Disc: return "Disc";
+    case BrushShape::Square: return "Square";
+    default: return "?";
+  }
+}
+
+static BrushStamp segment(const BrushEvent& from, const BrushEvent& to) {
+  return {from.x, from.y, to.x, to.y, to.radius, to.shape, to.u, to.v};
+}
+
+void BrushQueue::push(const BrushEvent& event) {
+  if (!m_strokeOpen) {
+    m_stamps.push_back(segment(event, event));
+    m_strokeOpen = true;
+    m_last = event;
+    return;
+  }
+
+  const f32 dx = event.x - m_last.x, dy = event.y - m_last.y;
+  const bool sameBrush = event.radius == m_last.radius && event.shape == m_last.shape &&
+                         event.u == m_last.u && event.v == m_last.v;
+  if (sameBrush && dx * dx + dy * dy < 0.25f) return;
+
+  m_stamps.push_back(segment(m_last, event));
+  m_last = event;
+}
+
+void BrushQueue::endStroke() { m_strokeOpen = false; }
+
+std::vector<BrushStamp> BrushQueue::takeFrame() {
+  // held still: keep feeding the same spot
+  if (m_stamps.empty() && m_strokeOpen) m_stamps.push_back(segment(m_last, m_last));
+
+  std::vector<BrushStamp> stamps;
+  stamps.swap(m_stamps);
+  return stamps;
+}
+
+// intersects [lo, hi] with the x that satisfy lo' <= a * x + b <= hi'
+static void clampLinear(f32 a, f32 b, f32 lower, f32 upper, f32& lo, f32& hi) {
+  if (a == 0) {
+    if (b < lower || b > upper) hi = lo - 1;  // empty
+    return;
+  }
+  f32 x0 = (lower - b) / a, x1 = (upper - b) / a;
+  if (x0 > x1) std::swap(x0, x1);
+  lo = std::max(lo, x0);
+  hi = std::min(hi, x1);
+}
+
+// the x range the stamp covers on row y; false if it misses the row
+static bool rowExtent(const BrushStamp& s, f32 y, f32& lo, f32& hi) {
+  const f32 r = s.radius;
+  const f32 dx = s.x1 - s.x0, dy = s.y1 - s.y0;
+  lo = INFINITY;
+  hi = -INFINITY;
+
+  if (s.shape == BrushShape::Square) {
+    // the parameters t in [0, 1] whose square reaches row y
+    f32 t0 = 0, t1 = 1;
+    clampLinear(dy, s.y0 - y, -r, r, t0, t1);
+    if (t0 > t1) return false;
+    lo = s.x0 + std::min(t0 * dx, t1 * dx) - r;
+    hi = s.x0 + std::max(t0 * dx, t1 * dx) + r;
+    return true;
+  }
+
+  // a capsule: the discs at both ends plus the band between them. it is
+  // convex, so the row is a single run spanning all three pieces
+  auto disc = [&](f32 cx, f32 cy) {
+    const f32 h2 = r * r - (y - cy) * (y - cy);
+    if (h2 < 0) return;
+    const f32 h = std::sqrt(h2);
+    lo = std::min(lo, cx - h);
+    hi = std::max(hi, cx + h);
+  };
+  disc(s.x0, s.y0);
+  disc(s.x1, s.y1);
+
+  const f32 len2 = dx * dx + dy * dy;
+  if (len2 > 0) {
+    // projection onto the segment within [0, len2], distance from its line within r
+    f32 bandLo = -INFINITY, bandHi = INFINITY;
+    clampLinear(dx, dy * (y - s.y0) - dx * s.x0, 0, len2, bandLo, bandHi);
+    const f32 reach = r * std::sqrt(len2);
+    clampLinear(-dy, dx * (y - s.y0) + dy * s.x0, -reach, reach, bandLo, bandHi);
+    if (bandLo <= bandHi) {
+      lo = std::min(lo, bandLo);
+      hi = std::max(hi, bandHi);
+    }
+  }
+  return lo <= hi;
+}
+
+std::vector<BrushSpan> rasterizeStamps(
+    const std::vector<BrushStamp>& stamps, i32 width, i32 height
+) {
+  std::vector<BrushSpan> spans, run;
+
+  // sorts and merges the spans of a run of stamps sharing one value
+  auto flush = [&] {
+    std::sort(run.begin(), run.end(), [](const BrushSpan& a, const BrushSpan& b) {
+      return a.y != b.y ? a.y < b.y : a.x0 < b.x0;
+    });
+    for (const BrushSpan& s : run) {
+      BrushSpan* last = spans.empty() ? nullptr : &spans.back();
+      if (last && last->y == s.y && last->u == s.u && last->v == s.v && s.x0 <= last->x1)
+        last->x1 = std::max(last->x1, s.x1);
+      else
+        spans.push_back(s);
+    }
+    run.clear();
+  };
+
+  for (usize i = 0; i < stamps.size(); ++i) {
+    const BrushStamp& s = stamps[i];
+    if (i > 0 && (s.u != stamps[i - 1].u || s.v != stamps[i - 1].v)) flush();
+
+    const i32 y0 = std::max((i32)std::ceil(std::min(s.y0, s.y1) - s.radius), 0);
+    const i32 y1 = std::min((i32)std::floor(std::max(s.y0, s.y1) + s.radius), height - 1);
+    for (i32 y = y0; y <= y1; ++y) {
+      f32 lo, hi;
+      if (!rowExtent(s, (f32)y, lo, hi)) continue;
+
+      const i32 x0 = std::max((i32)std::ceil(lo), 0);
+      const i32 x1 = std::min((i32)std::floor(hi) + 1, width);
+      if (x0 < x1) run.push_back({y, x0, x1, s.u, s.v});
+    }
+  }
+  flush();
+
+  return spans;
+}
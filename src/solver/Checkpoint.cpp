@@ -0,0 +1,174 @@
+#include "Checkpoint.h"
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool fail(std::string* error, std::string message) {
+  if (error) *error = std::move(message);
+  return false;
+}
+
+static CheckpointHeader makeHeader(
+    const GrayScottParams& params, u64 step, i32 width, i32 height, StoragePrecision precision
+) {
+  CheckpointHeader h{};
+  std::memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+  h.version = CHECKPOINT_VERSION;
+  h.headerSize = sizeof(CheckpointHeader);
+  h.width = width;
+  h.height = height;
+  h.F = params.F;
+  h.k = params.k;
+  h.Du = params.Du;
+  h.Dv = params.Dv;
+  h.dt = params.dt;
+  h.precision = (i32)precision;
+  h.step = step;
+  return h;
+}
+
+// maps a fresh file of the final size, lets `fill` write both planes into it
+// and moves it over `path` once everything reached the file
+static bool writeMapped(
+    const char* path, const CheckpointHeader& header,
+    const std::function<void(u8* u, u8* v)>& fill, std::string* error
+) {
+  const usize plane = (usize)header.width * header.height *
+                      storageElementSize((StoragePrecision)header.precision);
+  const usize size = sizeof(CheckpointHeader) + 2 * plane;
+  const std::string tmp = std::string(path) + ".tmp";
+
+  int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return fail(error, "cannot create " + tmp + ": " + std::strerror(errno));
+
+  void* data = MAP_FAILED;
+  if (::ftruncate(fd, (off_t)size) == 0)
+    data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (data == MAP_FAILED) {
+    std::string reason = std::strerror(errno);
+    ::close(fd);
+    ::unlink(tmp.c_str());
+    return fail(error, "cannot map " + tmp + ": " + reason);
+  }
+
+  u8* bytes = (u8*)data;
+  std::memcpy(bytes, &header, sizeof(header));
+  fill(bytes + sizeof(header), bytes + sizeof(header) + plane);
+
+  bool ok = ::msync(data, size, MS_SYNC) == 0;
+  ::munmap(data, size);
+  ok = ::close(fd) == 0 && ok;
+
+  if (!ok || ::rename(tmp.c_str(), path) != 0) {
+    std::string reason = std::strerror(errno);
+    ::unlink(tmp.c_str());
+    return fail(error, std::string("cannot write ") + path + ": " + reason);
+  }
+  return true;
+}
+
+bool saveCheckpoint(const char* path, GrayScottSolver& solver, std::string* error) {
+  const StoragePrecision precision = solver.storagePrecision();
+  CheckpointHeader header = makeHeader(
+      solver.params(), solver.stepCount(), solver.width(), solver.height(), precision
+  );
+
+  return writeMapped(
+      path, header, [&](u8* u, u8* v) { solver.exportState(precision, u, v); }, error
+  );
+}
+
+bool saveCheckpoint(const char* path, const CheckpointState& state, std::string* error) {
+  CheckpointHeader header =
+      makeHeader(state.params, state.step, state.width, state.height, state.precision);
+
+  auto fill = [&](u8* u, u8* v) {
+    const usize rowBytes = state.width * storageElementSize(state.precision);
+    const f32* src[2] = {state.u, state.v};
+    u8* dst[2] = {u, v};
+
+    for (i32 p = 0; p < 2; ++p) {
+      for (i32 y = 0; y < state.height; ++y) {
+        const f32* row = src[p] + (usize)y * state.stride;
+        u8* out = dst[p] + y * rowBytes;
+        if (state.precision == StoragePrecision::F32)
+          std::memcpy(out, row, rowBytes);
+        else
+          encodeRow(state.precision, row, (u16*)out, state.width);
+      }
+    }
+  };
+
+  return writeMapped(path, header, fill, error);
+}
+
+std::unique_ptr<Checkpoint> Checkpoint::open(const char* path, std::string* error) {
+  auto reject = [&](std::string message) {
+    fail(error, std::string(path) + ": " + message);
+    return nullptr;
+  };
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return reject(std::strerror(errno));
+
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || (usize)st.st_size < sizeof(CheckpointHeader)) {
+    ::close(fd);
+    return reject("not a checkpoint (too short)");
+  }
+
+  const usize size = (usize)st.st_size;
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // the mapping keeps the file alive
+  if (data == MAP_FAILED) return reject(std::strerror(errno));
+
+  // whole planes are read front to back on restore
+  ::madvise(data, size, MADV_SEQUENTIAL);
+  ::madvise(data, size, MADV_WILLNEED);
+
+  std::unique_ptr<Checkpoint> checkpoint(new Checkpoint(data, size));
+  const CheckpointHeader& h = checkpoint->header();
+
+  if (std::memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) != 0)
+    return reject("not a checkpoint (bad magic)");
+  if (h.version != CHECKPOINT_VERSION)
+    return reject("unsupported checkpoint version " + std::to_string(h.version));
+  if (h.headerSize < sizeof(CheckpointHeader) || h.width <= 0 || h.height <= 0 ||
+      h.precision < 0 || h.precision >= (i32)StoragePrecision::Count)
+    return reject("corrupt checkpoint header");
+  // compared by dividing the file size down, since multiplying a corrupt width
+  // and height out could wrap and pass a short file as whole
+  const usize rowBytes = (usize)h.width * storageElementSize((StoragePrecision)h.precision);
+  if (size < h.headerSize || (size - h.headerSize) / 2 / rowBytes < (usize)h.height)
+    return reject("truncated checkpoint");
+
+  return checkpoint;
+}
+
+Checkpoint::~Checkpoint() {
+  if (m_data) ::munmap(m_data, m_size);
+}
+
+GrayScottParams Checkpoint::params() const {
+  const CheckpointHeader& h = header();
+  return GrayScottParams{h.F, h.k, h.Du, h.Dv, h.dt};
+}
+
+void Checkpoint::restore(GrayScottSolver& solver) const {
+  if (solver.width() != width() || solver.height() != height()) solver.resize(width(), height());
+
+  const GrayScottParams p = params();
+  solver.setParams(p.F, p.k);
+  solver.setDiffusion(p.Du, p.Dv);
+  solver.setTimeStep(p.dt);
+
+  solver.importState(precision(), u(), v());
+  solver.setStepCount(step());
+}
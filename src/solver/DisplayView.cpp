@@ -0,0 +1,68 @@
+#include "DisplayView.h"
+
+#include <algorithm>
+#include <cmath>
+
+i32 viewLevel(f64 cellsPerPixel) {
+  if (!(cellsPerPixel > 1)) return 0;
+  // the epsilon keeps exact powers of two on their own level
+  return std::clamp((i32)std::ceil(std::log2(cellsPerPixel) - 1e-9), 0, 30);
+}
+
+// [lo, hi) of cells on one axis, widened to whole texels and clipped to the grid
+static void visibleSpan(f64 from, f64 to, i32 size, i32 level, i32& lo, i32& hi) {
+  const i32 block = 1 << level;
+  lo = (i32)std::clamp(std::floor(from), 0.0, (f64)size);
+  hi = (i32)std::clamp(std::ceil(to), 0.0, (f64)size);
+  lo &= ~(block - 1);
+  hi = std::min(size, (hi + block - 1) & ~(block - 1));
+  if (hi < lo) hi = lo;
+}
+
+ViewRect visibleRect(
+    const Viewport& view, i32 windowWidth, i32 windowHeight, i32 gridWidth, i32 gridHeight
+) {
+  ViewRect rect;
+  rect.level = viewLevel(view.cellsPerPixel);
+
+  i32 x1, y1;
+  const f64 spanX = windowWidth * view.cellsPerPixel, spanY = windowHeight * view.cellsPerPixel;
+  visibleSpan(view.x, view.x + spanX, gridWidth, rect.level, rect.x0, x1);
+  visibleSpan(view.y, view.y + spanY, gridHeight, rect.level, rect.y0, y1);
+  rect.width = x1 - rect.x0;
+  rect.height = y1 - rect.y0;
+  return rect;
+}
+
+void reduceView(
+    const f32* v, i32 stride, i32 gridWidth, i32 gridHeight, const ViewRect& rect, f32* out
+) {
+  const i32 block = 1 << rect.level;
+  const i32 texelsX = rect.texelsX(), texelsY = rect.texelsY();
+
+  if (block == 1) {
+    for (i32 j = 0; j < texelsY; ++j)
+      std::copy_n(v + (usize)(rect.y0 + j) * stride + rect.x0, texelsX, out + (usize)j * texelsX);
+    return;
+  }
+
+  // two samples per axis: every cell at level 1, block / 4 and 3 block / 4 above
+  const i32 spacing = block / 2, offset = spacing / 2;
+  const i32 lastX = std::min(rect.x0 + rect.width, gridWidth) - 1;
+  const i32 lastY = std::min(rect.y0 + rect.height, gridHeight) - 1;
+
+  for (i32 j = 0; j < texelsY; ++j) {
+    const i32 by = rect.y0 + j * block;
+    const f32* rows[2] = {
+        v + (usize)std::min(by + offset, lastY) * stride,
+        v + (usize)std::min(by + spacing + offset, lastY) * stride,
+    };
+
+    f32* dst = out + (usize)j * texelsX;
+    for (i32 i = 0; i < texelsX; ++i) {
+      const i32 bx = rect.x0 + i * block;
+      const i32 x0 = std::min(bx + offset, lastX), x1 = std::min(bx + spacing + offset, lastX);
+      dst[i] = 0.25f * ((rows[0][x0] + rows[0][x1]) + (rows[1][x0] + rows[1][x1]));
+    }
+  }
+}
@@ -0,0 +1,447 @@
+#include "DistributedSolver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// halo tags name the direction a row travels: a strip's top row goes up to the
+// rank above, where it becomes the bottom ghost row
+enum Tag : i32 { TAG_HALO_UP = 0, TAG_HALO_DOWN, TAG_CONTROL, TAG_DATA };
+
+enum Op : i32 { OP_CONFIG = 0, OP_PARAMS, OP_SCATTER, OP_GATHER, OP_STEP, OP_STOP };
+
+// coordinator -> worker on TAG_CONTROL. scatter is followed by the strip's U and
+// V on TAG_DATA; gather and step are answered on TAG_DATA
+struct Command {
+  i32 op, arg;
+  i32 width, height;
+  GrayScottParams params;
+};
+
+struct StepReply {
+  u64 steps;
+  f64 computeSeconds, waitSeconds;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static f64 seconds(Clock::time_point t0, Clock::time_point t1) {
+  return std::chrono::duration<f64>(t1 - t0).count();
+}
+
+static bool fail(std::string* error, std::string message) {
+  if (error) *error = std::move(message);
+  return false;
+}
+
+const char* transportName(TransportKind kind) {
+  switch (kind) {
+    case TransportKind::SharedMemory: return "shared memory";
+    case TransportKind::Socket: return "socket";
+    default: return "?";
+  }
+}
+
+Subdomain subdomain(i32 height, i32 workers, i32 rank) {
+  const i32 y0 = (i32)((i64)height * rank / workers);
+  const i32 y1 = (i32)((i64)height * (rank + 1) / workers);
+  return {y0, y1 - y0};
+}
+
+static i32 rankAbove(i32 rank, i32 workers) { return (rank + workers - 1) % workers; }
+static i32 rankBelow(i32 rank, i32 workers) { return (rank + 1) % workers; }
+
+std::vector<HaloChannel> distributedChannels(i32 width, i32 height, i32 workers) {
+  const usize halo = 2 * (usize)width * sizeof(f32);  // U and V of one row
+  const usize strip = (usize)width * ((height + workers - 1) / workers) * sizeof(f32);
+  const i32 coordinator = workers;
+
+  std::vector<HaloChannel> channels;
+  for (i32 r = 0; r < workers; ++r) {
+    channels.push_back({r, rankAbove(r, workers), TAG_HALO_UP, halo});
+    channels.push_back({r, rankBelow(r, workers), TAG_HALO_DOWN, halo});
+    channels.push_back({coordinator, r, TAG_CONTROL, sizeof(Command)});
+    channels.push_back({coordinator, r, TAG_DATA, strip});
+    channels.push_back({r, coordinator, TAG_DATA, std::max(strip, sizeof(StepReply))});
+  }
+  return channels;
+}
+
+// one worker's rows, padded like GrayScottSolver's planes: a ghost column on
+// either side, and ghost rows 0 and rows + 1 filled from the neighbours
+namespace {
+struct Strip {
+  i32 width{0}, rows{0}, stride{0};
+  GrayScottParams params;
+  RowKernel kernel{selectRowKernel(detectKernelIsa())};
+
+  std::vector<f32> storage;
+  f32 *u{nullptr}, *v{nullptr}, *nextU{nullptr}, *nextV{nullptr};
+  std::vector<f32> sendUp, sendDown, halo, transfer;
+
+  void configure(i32 w, i32 h) {
+    width = w;
+    rows = h;
+    stride = paddedStride(width);
+
+    const usize plane = (usize)stride * (rows + 2);
+    storage.assign(4 * plane, 0.0f);
+    u = storage.data();
+    v = u + plane;
+    nextU = v + plane;
+    nextV = nextU + plane;
+
+    sendUp.resize(2 * (usize)width);
+    sendDown.resize(2 * (usize)width);
+    halo.resize(2 * (usize)width);
+    transfer.resize((usize)width * rows);
+  }
+
+  // padded row y + 1 holds strip row y
+  f32* row(f32* plane, i32 y) const { return plane + (usize)(y + 1) * stride + 1; }
+
+  static void wrapColumns(f32* r, i32 w) {
+    r[-1] = r[w - 1];
+    r[w] = r[0];
+  }
+
+  void computeRows(i32 y0, i32 y1) {
+    const i32 s = stride;
+    for (i32 y = y0; y < y1; ++y) {
+      const f32* U = row(u, y);
+      const f32* V = row(v, y);
+      f32* outU = row(nextU, y);
+      f32* outV = row(nextV, y);
+
+      StencilRow r{U, U + s, U - s, V, V + s, V - s, outU, outV};
+      kernel(r, width, params);
+      wrapColumns(outU, width);
+      wrapColumns(outV, width);
+    }
+  }
+
+  void packRow(std::vector<f32>& out, i32 y) {
+    std::memcpy(out.data(), row(u, y), width * sizeof(f32));
+    std::memcpy(out.data() + width, row(v, y), width * sizeof(f32));
+  }
+
+  void unpackGhost(i32 y) {
+    f32* gu = row(u, y);
+    f32* gv = row(v, y);
+    std::memcpy(gu, halo.data(), width * sizeof(f32));
+    std::memcpy(gv, halo.data() + width, width * sizeof(f32));
+    wrapColumns(gu, width);
+    wrapColumns(gv, width);
+  }
+
+  // edges out, interior, halos in, edges: the interior hides the exchange
+  bool step(HaloTransport& transport, i32 workers, StepReply& reply) {
+    const i32 rank = transport.rank();
+    const i32 above = rankAbove(rank, workers), below = rankBelow(rank, workers);
+    const usize haloBytes = 2 * (usize)width * sizeof(f32);
+
+    packRow(sendUp, 0);
+    packRow(sendDown, rows - 1);
+    if (!transport.send(above, TAG_HALO_UP, sendUp.data(), haloBytes)) return false;
+    if (!transport.send(below, TAG_HALO_DOWN, sendDown.data(), haloBytes)) return false;
+
+    auto t0 = Clock::now();
+    computeRows(1, rows - 1);
+
+    auto t1 = Clock::now();
+    if (!transport.receive(above, TAG_HALO_DOWN, halo.data(), haloBytes)) return false;
+    unpackGhost(-1);
+    if (!transport.receive(below, TAG_HALO_UP, halo.data(), haloBytes)) return false;
+    unpackGhost(rows);
+
+    auto t2 = Clock::now();
+    computeRows(0, 1);
+    if (rows > 1) computeRows(rows - 1, rows);
+    auto t3 = Clock::now();
+
+    std::swap(u, nextU);
+    std::swap(v, nextV);
+
+    reply.computeSeconds += seconds(t0, t1) + seconds(t2, t3);
+    reply.waitSeconds += seconds(t1, t2);
+    ++reply.steps;
+    return true;
+  }
+
+  bool scatter(HaloTransport& transport, i32 coordinator) {
+    const usize bytes = transfer.size() * sizeof(f32);
+    for (f32* plane : {u, v}) {
+      if (!transport.receive(coordinator, TAG_DATA, transfer.data(), bytes)) return false;
+      for (i32 y = 0; y < rows; ++y) {
+        f32* r = row(plane, y);
+        std::memcpy(r, transfer.data() + (usize)y * width, width * sizeof(f32));
+        wrapColumns(r, width);
+      }
+    }
+    return true;
+  }
+
+  bool gather(HaloTransport& transport, i32 coordinator) {
+    const usize bytes = transfer.size() * sizeof(f32);
+    for (f32* plane : {u, v}) {
+      for (i32 y = 0; y < rows; ++y)
+        std::memcpy(transfer.data() + (usize)y * width, row(plane, y), width * sizeof(f32));
+      if (!transport.send(coordinator, TAG_DATA, transfer.data(), bytes)) return false;
+    }
+    return true;
+  }
+};
+}  // namespace
+
+int runDistributedWorker(HaloTransport& transport, i32 workers) {
+  const i32 coordinator = workers;
+  Strip strip;
+
+  for (;;) {
+    Command c;
+    if (!transport.receive(coordinator, TAG_CONTROL, &c, sizeof(c))) return 1;
+
+    switch (c.op) {
+      case OP_CONFIG:
+        strip.configure(c.width, subdomain(c.height, workers, transport.rank()).rows);
+        strip.params = c.params;
+        break;
+      case OP_PARAMS: strip.params = c.params; break;
+      case OP_SCATTER:
+        if (!strip.scatter(transport, coordinator)) return 1;
+        break;
+      case OP_GATHER:
+        if (!strip.gather(transport, coordinator)) return 1;
+        break;
+      case OP_STEP: {
+        StepReply reply{};
+        for (i32 i = 0; i < c.arg; ++i)
+          if (!strip.step(transport, workers, reply)) return 1;
+        if (!transport.send(coordinator, TAG_DATA, &reply, sizeof(reply))) return 1;
+        break;
+      }
+      case OP_STOP: return 0;
+      default: return 1;
+    }
+  }
+}
+
+DistributedSolver::DistributedSolver(
+    i32 width, i32 height, i32 workers, const GrayScottParams& params, TransportKind kind
+)
+    : m_width(width), m_height(height), m_workers(workers), m_params(params), m_kind(kind) {}
+
+std::unique_ptr<DistributedSolver> DistributedSolver::launch(
+    i32 width, i32 height, i32 workers, const GrayScottParams& params, TransportKind kind,
+    const std::vector<std::string>& endpoints, std::string* error
+) {
+  width = std::max(width, 1);
+  height = std::max(height, 1);
+  if (workers < 1 || workers > height) {
+    fail(error, "need between 1 and " + std::to_string(height) + " workers");
+    return nullptr;
+  }
+
+  std::unique_ptr<DistributedSolver> solver(
+      new DistributedSolver(width, height, workers, params, kind)
+  );
+  const i32 coordinator = workers;
+  const bool remote = !endpoints.empty();
+
+  if (remote && kind != TransportKind::Socket) {
+    fail(error, "remote workers need the socket transport");
+    return nullptr;
+  }
+  if (remote && (i32)endpoints.size() != workers + 1) {
+    fail(error, "expected " + std::to_string(workers + 1) + " endpoints");
+    return nullptr;
+  }
+
+  // local socket runs listen on ports the kernel picks, bound before forking so
+  // every worker inherits its own listener. the coordinator, the highest rank,
+  // only dials out
+  std::vector<std::string> local = endpoints;
+  std::vector<int> listeners;
+  auto closeListeners = [&] {
+    for (int fd : listeners) ::close(fd);
+    listeners.clear();
+  };
+  if (!remote && kind == TransportKind::Socket) {
+    local.resize(workers + 1);
+    local[coordinator] = "127.0.0.1:0";
+    for (i32 r = 0; r < workers; ++r) {
+      const int fd = SocketTransport::listenLocal(workers + 1, local[r], error);
+      if (fd < 0) {
+        closeListeners();
+        return nullptr;
+      }
+      listeners.push_back(fd);
+    }
+  }
+
+  if (kind == TransportKind::SharedMemory) {
+    solver->m_segment = "/rd-halo-" + std::to_string(::getpid());
+    if (!ShmTransport::createSegment(
+            solver->m_segment.c_str(), distributedChannels(width, height, workers), error
+        )) {
+      solver->m_segment.clear();
+      return nullptr;
+    }
+  }
+
+  if (!remote) {
+    std::fflush(nullptr);
+    for (i32 r = 0; r < workers; ++r) {
+      const pid_t pid = ::fork();
+      if (pid < 0) {
+        fail(error, std::string("fork failed: ") + std::strerror(errno));
+        closeListeners();
+        return nullptr;
+      }
+      if (pid > 0) {
+        solver->m_children.push_back(pid);
+        continue;
+      }
+
+      // workers exit with the coordinator rather than waiting on it forever
+      ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+      std::unique_ptr<HaloTransport> transport;
+      if (kind == TransportKind::SharedMemory) {
+        transport = ShmTransport::attach(solver->m_segment.c_str(), r);
+      } else {
+        for (i32 other = 0; other < workers; ++other)
+          if (other != r) ::close(listeners[other]);
+        std::set<i32> peers = {rankAbove(r, workers), rankBelow(r, workers), coordinator};
+        transport =
+            SocketTransport::connect(r, local, {peers.begin(), peers.end()}, nullptr, listeners[r]);
+      }
+      ::_exit(transport ? runDistributedWorker(*transport, workers) : 1);
+    }
+  }
+
+  closeListeners();  // the workers hold their own copies
+
+  if (kind == TransportKind::SharedMemory) {
+    solver->m_transport = ShmTransport::attach(solver->m_segment.c_str(), coordinator, error);
+  } else {
+    std::vector<i32> peers;
+    for (i32 r = 0; r < workers; ++r) peers.push_back(r);
+    solver->m_transport = SocketTransport::connect(coordinator, local, peers, error);
+  }
+  if (!solver->m_transport) return nullptr;
+
+  if (!remote) {
+    DistributedSolver* s = solver.get();
+    s->m_transport->setLivenessCheck([s] { return s->childrenAlive(); });
+  }
+
+  if (!solver->command(OP_CONFIG, 0)) {
+    fail(error, "workers did not start");
+    return nullptr;
+  }
+  return solver;
+}
+
+DistributedSolver::~DistributedSolver() {
+  if (m_transport) command(OP_STOP, 0);
+  m_transport.reset();
+
+  for (i32 pid : m_children) {
+    if (pid <= 0) continue;
+    if (::waitpid(pid, nullptr, WNOHANG) == 0) {
+      // a worker that did not get the stop (transport broken) is not coming back
+      ::usleep(100000);
+      if (::waitpid(pid, nullptr, WNOHANG) == 0) ::kill(pid, SIGTERM);
+      ::waitpid(pid, nullptr, 0);
+    }
+  }
+  if (!m_segment.empty()) ShmTransport::removeSegment(m_segment.c_str());
+}
+
+bool DistributedSolver::childrenAlive() {
+  for (i32& pid : m_children) {
+    if (pid > 0 && ::waitpid(pid, nullptr, WNOHANG) == pid) {
+      pid = 0;  // reaped
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DistributedSolver::command(i32 op, i32 arg) {
+  const Command c{op, arg, m_width, m_height, m_params};
+  for (i32 r = 0; r < m_workers; ++r)
+    if (!m_transport->send(r, TAG_CONTROL, &c, sizeof(c))) return false;
+  return true;
+}
+
+bool DistributedSolver::setParams(const GrayScottParams& params) {
+  m_params = params;
+  return command(OP_PARAMS, 0);
+}
+
+bool DistributedSolver::scatter(const f32* u, const f32* v, i32 stride) {
+  if (!command(OP_SCATTER, 0)) return false;
+
+  std::vector<f32> transfer;
+  for (i32 r = 0; r < m_workers; ++r) {
+    const Subdomain d = subdomain(m_height, m_workers, r);
+    transfer.resize((usize)m_width * d.rows);
+
+    for (const f32* plane : {u, v}) {
+      for (i32 y = 0; y < d.rows; ++y) {
+        std::memcpy(
+            transfer.data() + (usize)y * m_width, plane + (usize)(d.y0 + y) * stride,
+            m_width * sizeof(f32)
+        );
+      }
+      if (!m_transport->send(r, TAG_DATA, transfer.data(), transfer.size() * sizeof(f32)))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool DistributedSolver::gather(f32* u, f32* v, i32 stride) {
+  if (!command(OP_GATHER, 0)) return false;
+
+  std::vector<f32> transfer;
+  for (i32 r = 0; r < m_workers; ++r) {
+    const Subdomain d = subdomain(m_height, m_workers, r);
+    transfer.resize((usize)m_width * d.rows);
+
+    for (f32* plane : {u, v}) {
+      if (!m_transport->receive(r, TAG_DATA, transfer.data(), transfer.size() * sizeof(f32)))
+        return false;
+      for (i32 y = 0; y < d.rows; ++y) {
+        std::memcpy(
+            plane + (usize)(d.y0 + y) * stride, transfer.data() + (usize)y * m_width,
+            m_width * sizeof(f32)
+        );
+      }
+    }
+  }
+  return true;
+}
+
+bool DistributedSolver::step(i32 n) {
+  if (n <= 0) return true;
+  if (!command(OP_STEP, n)) return false;
+
+  m_stats = {};
+  for (i32 r = 0; r < m_workers; ++r) {
+    StepReply reply;
+    if (!m_transport->receive(r, TAG_DATA, &reply, sizeof(reply))) return false;
+    m_stats.computeSeconds = std::max(m_stats.computeSeconds, reply.computeSeconds);
+    m_stats.waitSeconds = std::max(m_stats.waitSeconds, reply.waitSeconds);
+  }
+  m_step += n;
+  return true;
+}
@@ -0,0 +1,115 @@
+#include "Fft.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numbers>
+
+// std::complex's operator* checks for inf / nan (a libgcc call per product
+// without -ffast-math); the values here are always finite
+static inline Fft::Complex mul(Fft::Complex a, Fft::Complex b) {
+  return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+Fft::Fft(i32 n) : m_size{std::max(n, 1)} {
+  m_bluestein = !std::has_single_bit((u32)m_size);
+  m_length = m_bluestein ? (i32)std::bit_ceil((u32)(2 * m_size - 1)) : m_size;
+
+  const i32 bits = std::countr_zero((u32)m_length);
+  m_bitReverse.resize(m_length);
+  for (i32 i = 0; i < m_length; ++i) {
+    u32 r = 0;
+    for (i32 b = 0; b < bits; ++b) r |= ((i >> b) & 1u) << (bits - 1 - b);
+    m_bitReverse[i] = (i32)r;
+  }
+
+  // level by level, so every butterfly pass reads its twiddles contiguously
+  m_twiddles.resize(std::max(m_length - 1, 0));
+  m_inverseTwiddles.resize(m_twiddles.size());
+  for (i32 half = 1; half < m_length; half *= 2) {
+    for (i32 k = 0; k < half; ++k) {
+      m_twiddles[half - 1 + k] = std::polar(1.0, -std::numbers::pi * k / half);
+      m_inverseTwiddles[half - 1 + k] = std::conj(m_twiddles[half - 1 + k]);
+    }
+  }
+
+  if (!m_bluestein) return;
+
+  // k^2 is reduced mod 2n first: the angle stays small, and so does its error
+  m_chirp.resize(m_size);
+  for (i32 k = 0; k < m_size; ++k) {
+    const i64 k2 = (i64)k * k % (2 * (i64)m_size);
+    m_chirp[k] = std::polar(1.0, -std::numbers::pi * k2 / m_size);
+  }
+
+  // conj(chirp) laid out circularly: index k and m_length - k hold entry k
+  m_chirpSpectrum.assign(m_length, Complex(0));
+  m_chirpSpectrum[0] = std::conj(m_chirp[0]);
+  for (i32 k = 1; k < m_size; ++k)
+    m_chirpSpectrum[k] = m_chirpSpectrum[m_length - k] = std::conj(m_chirp[k]);
+  radix2(m_chirpSpectrum.data(), false);
+}
+
+void Fft::radix2(Complex* data, bool inverse) const {
+  const i32 n = m_length;
+
+  for (i32 i = 0; i < n; ++i) {
+    const i32 j = m_bitReverse[i];
+    if (i < j) std::swap(data[i], data[j]);
+  }
+
+  // the first level only adds and subtracts neighbours
+  for (i32 i = 0; i + 1 < n; i += 2) {
+    const Complex a = data[i], b = data[i + 1];
+    data[i] = a + b;
+    data[i + 1] = a - b;
+  }
+
+  const Complex* twiddles = inverse ? m_inverseTwiddles.data() : m_twiddles.data();
+  for (i32 half = 2; half < n; half *= 2) {
+    const Complex* w = twiddles + half - 1;
+    for (i32 start = 0; start < n; start += 2 * half) {
+      Complex* lo = data + start;
+      Complex* hi = lo + half;
+      for (i32 k = 0; k < half; ++k) {
+        const Complex a = lo[k];
+        const Complex b = mul(hi[k], w[k]);
+        lo[k] = a + b;
+        hi[k] = a - b;
+      }
+    }
+  }
+}
+
+void Fft::forward(Complex* data, Complex* scratch) const {
+  if (!m_bluestein) {
+    radix2(data, false);
+    return;
+  }
+
+  // X_k = chirp_k * sum_j (x_j chirp_j) conj(chirp_{k - j}): a convolution
+  for (i32 k = 0; k < m_size; ++k) scratch[k] = mul(data[k], m_chirp[k]);
+  for (i32 k = m_size; k < m_length; ++k) scratch[k] = 0;
+
+  radix2(scratch, false);
+  for (i32 k = 0; k < m_length; ++k) scratch[k] = mul(scratch[k], m_chirpSpectrum[k]);
+  radix2(scratch, true);
+
+  const f64 scale = 1.0 / m_length;
+  for (i32 k = 0; k < m_size; ++k) data[k] = mul(scratch[k], m_chirp[k]) * scale;
+}
+
+void Fft::inverse(Complex* data, Complex* scratch) const {
+  const f64 scale = 1.0 / m_size;
+
+  if (!m_bluestein) {
+    radix2(data, true);
+    for (i32 k = 0; k < m_size; ++k) data[k] *= scale;
+    return;
+  }
+
+  // conj(F(conj(x))) / n
+  for (i32 k = 0; k < m_size; ++k) data[k] = std::conj(data[k]);
+  forward(data, scratch);
+  for (i32 k = 0; k < m_size; ++k) data[k] = std::conj(data[k]) * scale;
+}
@@ -0,0 +1,382 @@
+#include "FieldRecorder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+static bool fail(std::string* error, std::string message) {
+  if (error) *error = std::move(message);
+  return false;
+}
+
+static u32 maxSample(i32 bits) { return (1u << bits) - 1; }
+
+// ---------------------------------------------------------------------------
+// quantization
+
+template <typename T>
+static void quantizePlane(
+    const f32* src, i32 width, i32 height, i32 rowStride, i32 cellStride, bool downsample,
+    f32 scale, T* dst
+) {
+  auto quantize = [scale](f32 x) { return (T)(std::clamp(x, 0.0f, 1.0f) * scale + 0.5f); };
+
+  if (!downsample) {
+    for (i32 y = 0; y < height; ++y) {
+      const f32* row = src + (usize)y * rowStride;
+      for (i32 x = 0; x < width; ++x) dst[(usize)y * width + x] = quantize(row[x * cellStride]);
+    }
+    return;
+  }
+
+  // 2x2 box average; odd edges average what is there
+  const i32 w = (width + 1) / 2, h = (height + 1) / 2;
+  for (i32 y = 0; y < h; ++y) {
+    for (i32 x = 0; x < w; ++x) {
+      f32 sum = 0;
+      i32 count = 0;
+      for (i32 sy = 2 * y; sy < std::min(2 * y + 2, height); ++sy) {
+        for (i32 sx = 2 * x; sx < std::min(2 * x + 2, width); ++sx) {
+          sum += src[(usize)sy * rowStride + sx * cellStride];
+          ++count;
+        }
+      }
+      dst[(usize)y * w + x] = quantize(sum / count);
+    }
+  }
+}
+
+// small signed deltas (mod 2^bits) <-> small unsigned values
+static u32 zigzag(u32 delta, i32 bits) {
+  const i32 d = delta >= (1u << (bits - 1)) ? (i32)delta - (1 << bits) : (i32)delta;
+  return d >= 0 ? 2 * (u32)d : 2 * (u32)(-d) - 1;
+}
+
+static u32 unzigzag(u32 z, i32 bits) {
+  const i32 d = (z & 1) ? -(i32)((z + 1) / 2) : (i32)(z / 2);
+  return (u32)d & maxSample(bits);
+}
+
+// ---------------------------------------------------------------------------
+// PackBits: a control byte c < 128 is followed by c + 1 literal bytes,
+// c >= 128 by one byte repeated c - 126 times
+
+static void packBits(const u8* in, usize n, std::vector<u8>& out) {
+  out.clear();
+
+  usize i = 0;
+  while (i < n) {
+    usize run = 1;
+    while (i + run < n && run < 129 && in[i + run] == in[i]) ++run;
+
+    if (run >= 2) {
+      out.push_back((u8)(run + 126));
+      out.push_back(in[i]);
+      i += run;
+      continue;
+    }
+
+    // literals up to the next repeat
+    const usize start = i;
+    while (i < n && i - start < 128 && !(i + 1 < n && in[i + 1] == in[i])) ++i;
+
+    out.push_back((u8)(i - start - 1));
+    out.insert(out.end(), in + start, in + i);
+  }
+}
+
+static bool unpackBits(const u8* in, usize n, u8* out, usize outSize) {
+  usize o = 0;
+  for (usize i = 0; i < n;) {
+    const u8 c = in[i++];
+    if (c < 128) {
+      const usize len = c + 1;
+      if (i + len > n || o + len > outSize) return false;
+      std::memcpy(out + o, in + i, len);
+      i += len;
+      o += len;
+    } else {
+      const usize len = c - 126;
+      if (i >= n || o + len > outSize) return false;
+      std::memset(out + o, in[i++], len);
+      o += len;
+    }
+  }
+  return o == outSize;
+}
+
+// ---------------------------------------------------------------------------
+// recorder
+
+bool FieldRecorder::start(
+    const char* path, i32 width, i32 height, const RecorderOptions& options, std::string* error
+) {
+  stop();
+
+  if (options.bits != 8 && options.bits != 16) return fail(error, "bits must be 8 or 16");
+  if (width <= 0 || height <= 0) return fail(error, "empty frame size");
+
+  m_options = options;
+  m_options.interval = std::max(options.interval, 1);
+  m_options.queueFrames = std::max(options.queueFrames, 1);
+  m_options.keyInterval = std::max(options.keyInterval, 1);
+  m_width = width;
+  m_height = height;
+
+  std::FILE* file = std::fopen(path, "wb");
+  if (!file) return fail(error, std::string("cannot create ") + path + ": " + std::strerror(errno));
+
+  RecordingHeader header{};
+  std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+  header.version = RECORDING_VERSION;
+  header.headerSize = sizeof(RecordingHeader);
+  header.width = width;
+  header.height = height;
+  header.bits = m_options.bits;
+  header.fields = m_options.recordU ? 2 : 1;
+  header.interval = m_options.interval;
+
+  if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+    std::fclose(file);
+    return fail(error, std::string("cannot write ") + path);
+  }
+
+  // every buffer the recording will use is allocated here
+  const usize bytes = (usize)header.fields * width * height * (m_options.bits / 8);
+  m_frames.clear();
+  m_free.clear();
+  m_queue.clear();
+  m_queue.reserve(m_options.queueFrames);
+  for (i32 i = 0; i < m_options.queueFrames; ++i) {
+    m_frames.push_back(std::make_unique<Frame>());
+    m_frames.back()->samples.resize(bytes);
+    m_free.push_back(m_frames.back().get());
+  }
+
+  m_stats = {};
+  m_stats.fileBytes = sizeof(header);
+  m_stop = false;
+  m_file = file;
+  m_writer = std::thread(&FieldRecorder::run, this);
+  return true;
+}
+
+void FieldRecorder::stop() {
+  if (!m_file) return;
+
+  {
+    std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_one();
+  m_writer.join();
+
+  std::fclose(m_file);
+  m_file = nullptr;
+
+  m_free.clear();
+  m_frames.clear();
+}
+
+bool FieldRecorder::submit(
+    u64 step, i32 width, i32 height, const f32* v, const f32* u, i32 rowStride, i32 cellStride
+) {
+  if (!m_file || width != m_width || height != m_height) {
+    noteDropped();
+    return false;
+  }
+
+  Frame* frame;
+  bool downsample;
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_free.empty()) {
+      m_stats.dropped++;
+      return false;
+    }
+
+    frame = m_free.back();
+    m_free.pop_back();
+    downsample = m_options.overflow == RecorderOverflow::Downsample &&
+                 m_options.queueFrames > 1 && 2 * (i32)m_queue.size() >= m_options.queueFrames;
+  }
+
+  frame->step = step;
+  frame->downsampled = downsample;
+  frame->width = downsample ? (width + 1) / 2 : width;
+  frame->height = downsample ? (height + 1) / 2 : height;
+
+  const usize cells = (usize)frame->width * frame->height;
+  const f32 scale = (f32)maxSample(m_options.bits);
+  const f32* planes[2] = {v, u};
+
+  for (i32 p = 0; p < (m_options.recordU ? 2 : 1); ++p) {
+    if (m_options.bits == 8) {
+      u8* dst = frame->samples.data() + p * cells;
+      quantizePlane(planes[p], width, height, rowStride, cellStride, downsample, scale, dst);
+    } else {
+      u16* dst = (u16*)frame->samples.data() + p * cells;
+      quantizePlane(planes[p], width, height, rowStride, cellStride, downsample, scale, dst);
+    }
+  }
+
+  {
+    std::lock_guard lock(m_mutex);
+    m_queue.push_back(frame);
+  }
+  m_wake.notify_one();
+  return true;
+}
+
+void FieldRecorder::noteDropped() {
+  std::lock_guard lock(m_mutex);
+  m_stats.dropped++;
+}
+
+RecorderStats FieldRecorder::stats() const {
+  std::lock_guard lock(m_mutex);
+  return m_stats;
+}
+
+void FieldRecorder::run() {
+  const i32 bits = m_options.bits;
+  const i32 fields = m_options.recordU ? 2 : 1;
+
+  std::vector<u16> previous;
+  i32 previousWidth = 0, previousHeight = 0;
+  i32 sinceKey = 0;
+  std::vector<u8> raw, packed;
+
+  for (;;) {
+    Frame* frame;
+    {
+      std::unique_lock lock(m_mutex);
+      m_wake.wait(lock, [&] { return !m_queue.empty() || m_stop; });
+      if (m_queue.empty()) return;  // stopping, everything written
+
+      frame = m_queue.front();
+      m_queue.erase(m_queue.begin());
+    }
+
+    const usize samples = (usize)fields * frame->width * frame->height;
+    const bool key = sinceKey == 0 || frame->width != previousWidth ||
+                     frame->height != previousHeight;
+
+    // deltas against the previous frame, split into byte planes
+    previous.resize(samples);
+    raw.resize(samples * (bits / 8));
+    for (usize i = 0; i < samples; ++i) {
+      const u32 s = bits == 8 ? frame->samples[i] : ((const u16*)frame->samples.data())[i];
+      const u32 z = key ? s : zigzag((s - previous[i]) & maxSample(bits), bits);
+      previous[i] = (u16)s;
+
+      raw[i] = (u8)z;
+      if (bits == 16) raw[samples + i] = (u8)(z >> 8);
+    }
+    packBits(raw.data(), raw.size(), packed);
+
+    RecordedFrameHeader header{};
+    header.magic = RECORDED_FRAME_MAGIC;
+    header.flags = (key ? FRAME_KEY : 0) | (frame->downsampled ? FRAME_DOWNSAMPLED : 0);
+    header.step = frame->step;
+    header.width = frame->width;
+    header.height = frame->height;
+    header.rawBytes = (u32)raw.size();
+    header.packedBytes = (u32)packed.size();
+
+    const bool written = std::fwrite(&header, sizeof(header), 1, m_file) == 1 &&
+                         std::fwrite(packed.data(), 1, packed.size(), m_file) == packed.size();
+
+    previousWidth = frame->width;
+    previousHeight = frame->height;
+    sinceKey = (sinceKey + 1) % m_options.keyInterval;
+    if (!written) sinceKey = 0;  // whatever made it to disk, restart from a key frame
+
+    std::lock_guard lock(m_mutex);
+    if (written) {
+      m_stats.written++;
+      m_stats.downsampled += frame->downsampled;
+      m_stats.rawBytes += raw.size();
+      m_stats.fileBytes += sizeof(header) + packed.size();
+    } else {
+      m_stats.dropped++;
+    }
+    m_free.push_back(frame);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// reader
+
+std::unique_ptr<FieldReader> FieldReader::open(const char* path, std::string* error) {
+  std::FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    fail(error, std::string(path) + ": " + std::strerror(errno));
+    return nullptr;
+  }
+
+  RecordingHeader h{};
+  const bool ok = std::fread(&h, sizeof(h), 1, file) == 1 &&
+                  std::memcmp(h.magic, RECORDING_MAGIC, sizeof(h.magic)) == 0 &&
+                  h.version == RECORDING_VERSION && h.headerSize >= sizeof(h) &&
+                  h.width > 0 && h.height > 0 && (h.bits == 8 || h.bits == 16) &&
+                  (h.fields == 1 || h.fields == 2) &&
+                  std::fseek(file, h.headerSize, SEEK_SET) == 0;
+  if (!ok) {
+    std::fclose(file);
+    fail(error, std::string(path) + ": not a recording of a supported version");
+    return nullptr;
+  }
+
+  return std::unique_ptr<FieldReader>(new FieldReader(file, h));
+}
+
+FieldReader::~FieldReader() {
+  if (m_file) std::fclose(m_file);
+}
+
+bool FieldReader::next(RecordedFrame& frame) {
+  RecordedFrameHeader h{};
+  if (std::fread(&h, sizeof(h), 1, m_file) != 1) return false;
+
+  const i32 bits = m_header.bits;
+  const usize cells = (usize)h.width * h.height;
+  const usize samples = cells * m_header.fields;
+  const bool key = h.flags & FRAME_KEY;
+
+  if (h.magic != RECORDED_FRAME_MAGIC || h.width <= 0 || h.height <= 0 ||
+      h.width > m_header.width || h.height > m_header.height ||
+      h.rawBytes != samples * (bits / 8))
+    return false;
+  if (!key && (h.width != m_previousWidth || h.height != m_previousHeight)) return false;
+
+  m_packed.resize(h.packedBytes);
+  m_raw.resize(h.rawBytes);
+  if (std::fread(m_packed.data(), 1, m_packed.size(), m_file) != m_packed.size() ||
+      !unpackBits(m_packed.data(), m_packed.size(), m_raw.data(), m_raw.size()))
+    return false;
+
+  m_previous.resize(samples);
+  for (usize i = 0; i < samples; ++i) {
+    u32 z = m_raw[i];
+    if (bits == 16) z |= (u32)m_raw[samples + i] << 8;
+    m_previous[i] = (u16)(key ? z : (m_previous[i] + unzigzag(z, bits)) & maxSample(bits));
+  }
+  m_previousWidth = h.width;
+  m_previousHeight = h.height;
+
+  frame.step = h.step;
+  frame.width = h.width;
+  frame.height = h.height;
+  frame.key = key;
+  frame.downsampled = h.flags & FRAME_DOWNSAMPLED;
+
+  const f32 scale = 1.0f / maxSample(bits);
+  frame.v.resize(cells);
+  for (usize i = 0; i < cells; ++i) frame.v[i] = m_previous[i] * scale;
+
+  frame.u.resize(m_header.fields == 2 ? cells : 0);
+  for (usize i = 0; i < frame.u.size(); ++i) frame.u[i] = m_previous[cells + i] * scale;
+
+  return true;
+}
@@ -0,0 +1,71 @@
+#include "FrameGovernor.h"
+
+#include <algorithm>
+#include <cmath>
+
+// weight of the newest sample in the smoothed costs
+static constexpr f64 SMOOTHING = 0.2;
+
+void FrameGovernor::setOptions(const GovernorOptions& options) {
+  m_options = options;
+  m_steps = std::clamp(m_steps, m_options.minSteps, m_options.maxSteps);
+  m_overFrames = m_underFrames = m_stuckFrames = 0;
+}
+
+void FrameGovernor::reset(i32 steps) {
+  m_steps = std::clamp(steps, m_options.minSteps, m_options.maxSteps);
+  m_stepMs = m_otherMs = 0;
+  m_skip = m_options.latency;
+  m_overFrames = m_underFrames = m_stuckFrames = 0;
+  m_coarsen = false;
+}
+
+i32 FrameGovernor::update(f64 stepMs, f64 otherMs) {
+  if (!(stepMs > 0) || !std::isfinite(stepMs)) return m_steps;
+  otherMs = std::isfinite(otherMs) ? std::max(otherMs, 0.0) : 0.0;
+
+  if (m_skip > 0) {
+    --m_skip;
+    return m_steps;
+  }
+
+  if (m_stepMs == 0) {
+    m_stepMs = stepMs;
+    m_otherMs = otherMs;
+  } else {
+    m_stepMs += SMOOTHING * (stepMs - m_stepMs);
+    m_otherMs += SMOOTHING * (otherMs - m_otherMs);
+  }
+
+  const f64 budget = m_options.budgetMs;
+  const bool over = predictedMs() > m_options.lowerAbove * budget;
+  const bool roomForMore = m_otherMs + (m_steps + 1) * m_stepMs <= m_options.raiseBelow * budget;
+
+  m_overFrames = over ? m_overFrames + 1 : 0;
+  m_underFrames = !over && roomForMore ? m_underFrames + 1 : 0;
+
+  const i32 target = stepsFitting((m_options.raiseBelow + m_options.lowerAbove) / 2);
+  i32 next = m_steps;
+  if (m_overFrames >= m_options.lowerFrames && m_steps > m_options.minSteps)
+    next = std::min(target, m_steps - 1);
+  else if (m_underFrames >= m_options.raiseFrames && m_steps < m_options.maxSteps)
+    next = std::max(target, m_steps + 1);
+
+  if (next != m_steps) {
+    m_steps = std::clamp(next, m_options.minSteps, m_options.maxSteps);
+    m_skip = m_options.latency;
+    m_overFrames = m_underFrames = 0;
+  }
+
+  // a single step per frame that still overruns is beyond what steps can fix
+  m_stuckFrames = over && m_steps == m_options.minSteps ? m_stuckFrames + 1 : 0;
+  if (m_options.allowCoarsening && m_stuckFrames >= m_options.coarsenFrames) m_coarsen = true;
+
+  return m_steps;
+}
+
+i32 FrameGovernor::stepsFitting(f64 share) const {
+  const f64 room = share * m_options.budgetMs - m_otherMs;
+  const f64 steps = std::floor(room / m_stepMs);
+  return (i32)std::clamp(steps, (f64)m_options.minSteps, (f64)m_options.maxSteps);
+}
@@ -0,0 +1,759 @@
+#include "GrayScottSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+static i32 wrap(i32 a, i32 n) { return ((a % n) + n) % n; }
+
+// f32 <-> storage element copies, so the tile and halo code serves both formats
+static void loadCells(f32* dst, const f32* src, i32 n, StoragePrecision) {
+  std::memcpy(dst, src, n * sizeof(f32));
+}
+static void loadCells(f32* dst, const u16* src, i32 n, StoragePrecision p) {
+  decodeRow(p, src, dst, n);
+}
+static void storeCells(f32* dst, const f32* src, i32 n, StoragePrecision) {
+  std::memcpy(dst, src, n * sizeof(f32));
+}
+static void storeCells(u16* dst, const f32* src, i32 n, StoragePrecision p) {
+  encodeRow(p, src, dst, n);
+}
+
+// loads `len` cells of a toroidal row starting at (possibly negative) column x
+template <typename T>
+static void loadWrapped(f32* dst, const T* row, i32 x, i32 len, i32 width, StoragePrecision p) {
+  x = wrap(x, width);
+  while (len > 0) {
+    i32 seg = std::min(len, width - x);
+    loadCells(dst, row + x, seg, p);
+    dst += seg;
+    len -= seg;
+    x = 0;
+  }
+}
+
+// mirrors interior rows [y0, y1) into the ghost cells of a padded plane: the
+// left/right ghosts of each row, plus the top/bottom ghost rows when the range
+// holds the last/first interior row (corners are never read by the stencil)
+template <typename T>
+static void refreshHalo(T* plane, i32 stride, i32 w, i32 h, i32 y0, i32 y1) {
+  for (i32 y = y0; y < y1; ++y) {
+    T* row = plane + (usize)(y + 1) * stride;
+    row[0] = row[w];
+    row[w + 1] = row[1];
+  }
+
+  if (y0 <= 0 && 0 < y1)
+    std::memcpy(plane + (usize)(h + 1) * stride, plane + stride, stride * sizeof(T));
+  if (y0 <= h - 1 && h - 1 < y1) std::memcpy(plane, plane + (usize)h * stride, stride * sizeof(T));
+}
+
+GrayScottSolver::GrayScottSolver(i32 width, i32 height, const GrayScottParams& params)
+    : m_params(params) {
+  resize(width, height);
+}
+
+void GrayScottSolver::resize(i32 width, i32 height) {
+  m_width = std::max(width, 1);
+  m_height = std::max(height, 1);
+  m_stride = paddedStride(m_width);
+
+  allocate();
+  reset();
+}
+
+void GrayScottSolver::allocate() {
+  const usize n = planeSize();
+
+  if (packed()) {
+    m_packedStorage.assign(4 * n, 0);
+    m_packedU = m_packedStorage.data();
+    m_packedV = m_packedU + n;
+    m_packedNextU = m_packedV + n;
+    m_packedNextV = m_packedNextU + n;
+
+    // the f32 view is allocated on first use
+    std::vector<f32>().swap(m_storage);
+    m_u = m_v = m_nextU = m_nextV = nullptr;
+  } else {
+    m_storage.assign(4 * n, 0.0f);
+    m_u = m_storage.data();
+    m_v = m_u + n;
+    m_nextU = m_v + n;
+    m_nextV = m_nextU + n;
+
+    std::vector<u16>().swap(m_packedStorage);
+    m_packedU = m_packedV = m_packedNextU = m_packedNextV = nullptr;
+  }
+
+  m_viewValid = m_viewDirty = false;
+  m_activityValid = false;
+}
+
+void GrayScottSolver::reset() {
+  const usize n = planeSize();
+
+  if (packed()) {
+    std::fill_n(m_packedU, n, encodeValue(m_precision, 1.0f));
+    std::fill_n(m_packedV, n, encodeValue(m_precision, 0.0f));
+    m_viewValid = m_viewDirty = false;
+  } else {
+    std::fill_n(m_u, n, 1.0f);
+    std::fill_n(m_v, n, 0.0f);
+  }
+
+  m_step = 0;
+  m_activityValid = false;
+}
+
+GrayScottState GrayScottSolver::state() {
+  syncView();
+  return {interior(m_u), interior(m_v), m_width, m_height, m_stride, m_step};
+}
+
+f32* GrayScottSolver::u() {
+  syncView();
+  m_viewDirty = packed();
+  m_activityValid = false;
+  return interior(m_u);
+}
+
+f32* GrayScottSolver::v() {
+  syncView();
+  m_viewDirty = packed();
+  m_activityValid = false;
+  return interior(m_v);
+}
+
+void GrayScottSolver::applyStamps(const std::vector<BrushStamp>& stamps) {
+  for (const BrushSpan& span : rasterizeStamps(stamps, m_width, m_height)) {
+    const usize row = (usize)span.y * m_stride;
+    const i32 n = span.x1 - span.x0;
+
+    if (packed()) {
+      const u16 u = encodeValue(m_precision, span.u), v = encodeValue(m_precision, span.v);
+      std::fill_n(interior(m_packedU) + row + span.x0, n, u);
+      std::fill_n(interior(m_packedV) + row + span.x0, n, v);
+      if (m_viewValid) {
+        std::fill_n(interior(m_u) + row + span.x0, n, decodeValue(m_precision, u));
+        std::fill_n(interior(m_v) + row + span.x0, n, decodeValue(m_precision, v));
+      }
+    } else {
+      std::fill_n(interior(m_u) + row + span.x0, n, span.u);
+      std::fill_n(interior(m_v) + row + span.x0, n, span.v);
+    }
+
+    for (i32 x = span.x0; x < span.x1; x += ACTIVITY_TILE) markActive(x, span.y);
+    markActive(span.x1 - 1, span.y);
+  }
+}
+
+void GrayScottSolver::syncView() {
+  if (!packed() || m_viewValid) return;
+
+  const usize n = planeSize();
+  if (m_storage.size() != 2 * n) {
+    m_storage.assign(2 * n, 0.0f);
+    m_u = m_storage.data();
+    m_v = m_u + n;
+  }
+
+  for (i32 y = 0; y < m_height + 2; ++y) {
+    const usize row = (usize)y * m_stride;
+    decodeRow(m_precision, m_packedU + row, m_u + row, m_stride);
+    decodeRow(m_precision, m_packedV + row, m_v + row, m_stride);
+  }
+
+  m_viewValid = true;
+}
+
+void GrayScottSolver::commitView() {
+  if (!m_viewDirty) return;
+
+  for (i32 y = 0; y < m_height + 2; ++y) {
+    const usize row = (usize)y * m_stride;
+    encodeRow(m_precision, m_u + row, m_packedU + row, m_stride);
+    encodeRow(m_precision, m_v + row, m_packedV + row, m_stride);
+  }
+
+  m_viewDirty = false;
+}
+
+// converts n cells between any two storage formats; scratch holds n floats
+static void convertRow(
+    StoragePrecision from, const void* src, StoragePrecision to, void* dst, i32 n, f32* scratch
+) {
+  if (from == to) {
+    std::memcpy(dst, src, n * storageElementSize(from));
+  } else if (from == StoragePrecision::F32) {
+    encodeRow(to, (const f32*)src, (u16*)dst, n);
+  } else if (to == StoragePrecision::F32) {
+    decodeRow(from, (const u16*)src, (f32*)dst, n);
+  } else {
+    decodeRow(from, (const u16*)src, scratch, n);
+    encodeRow(to, scratch, (u16*)dst, n);
+  }
+}
+
+void GrayScottSolver::exportState(StoragePrecision precision, void* u, void* v) {
+  commitView();
+
+  const usize rowBytes = m_width * storageElementSize(precision);
+  const void* planes[2] = {packed() ? (const void*)interior(m_packedU) : interior(m_u),
+                           packed() ? (const void*)interior(m_packedV) : interior(m_v)};
+  u8* out[2] = {(u8*)u, (u8*)v};
+  std::vector<f32> scratch(m_width);
+
+  for (i32 p = 0; p < 2; ++p) {
+    for (i32 y = 0; y < m_height; ++y) {
+      const u8* row = (const u8*)planes[p] + (usize)y * m_stride * storageElementSize(m_precision);
+      convertRow(m_precision, row, precision, out[p] + y * rowBytes, m_width, scratch.data());
+    }
+  }
+}
+
+void GrayScottSolver::importState(StoragePrecision precision, const void* u, const void* v) {
+  const usize rowBytes = m_width * storageElementSize(precision);
+  void* planes[2] = {packed() ? (void*)interior(m_packedU) : interior(m_u),
+                     packed() ? (void*)interior(m_packedV) : interior(m_v)};
+  const u8* in[2] = {(const u8*)u, (const u8*)v};
+  std::vector<f32> scratch(m_width);
+
+  for (i32 p = 0; p < 2; ++p) {
+    for (i32 y = 0; y < m_height; ++y) {
+      u8* row = (u8*)planes[p] + (usize)y * m_stride * storageElementSize(m_precision);
+      convertRow(precision, in[p] + y * rowBytes, m_precision, row, m_width, scratch.data());
+    }
+  }
+
+  // ghost cells are refreshed by the next step
+  m_viewValid = m_viewDirty = false;
+  m_activityValid = false;
+}
+
+void GrayScottSolver::setStoragePrecision(StoragePrecision precision) {
+  if (precision == m_precision) return;
+
+  // carry the current state over through an f32 copy
+  syncView();
+
+  const usize n = planeSize();
+  std::vector<f32> saved(2 * n);
+  std::copy_n(m_u, n, saved.data());
+  std::copy_n(m_v, n, saved.data() + n);
+
+  m_precision = precision;
+  allocate();
+
+  if (packed()) {
+    for (i32 y = 0; y < m_height + 2; ++y) {
+      const usize row = (usize)y * m_stride;
+      encodeRow(m_precision, saved.data() + row, m_packedU + row, m_stride);
+      encodeRow(m_precision, saved.data() + n + row, m_packedV + row, m_stride);
+    }
+  } else {
+    std::copy_n(saved.data(), n, m_u);
+    std::copy_n(saved.data() + n, n, m_v);
+  }
+}
+
+void GrayScottSolver::setThreadCount(i32 threads) {
+  threads = std::max(threads, 1);
+  if (threads == threadCount()) return;
+
+  m_pool = threads > 1 ? std::make_unique<ThreadPool>(threads) : nullptr;
+  nameWorkers();
+}
+
+void GrayScottSolver::nameWorkers() {
+  if (!m_profiler || !m_pool) return;
+
+  // worker 0 is the calling thread, which names itself
+  m_pool->run([&](i32 t, i32) {
+    if (t > 0) m_profiler->setThreadName(("Solver worker " + std::to_string(t)).c_str());
+  });
+}
+
+void GrayScottSolver::reserveScratch(usize size) {
+  m_scratch.resize(threadCount());
+  for (auto& s : m_scratch)
+    if (s.size() < size) s.assign(size, 0.0f);
+}
+
+void GrayScottSolver::step(i32 n) {
+  if (n <= 0) return;
+
+  commitView();
+
+  if (m_integrator != Integrator::Explicit) {
+    stepSpectral(n);
+    m_step += n;
+    return;
+  }
+
+  auto run = [&](auto*& u, auto*& v, auto*& nextU, auto*& nextV) {
+    // the current planes may have been written from outside since the last step
+    refreshHalo(u, m_stride, m_width, m_height, 0, m_height);
+    refreshHalo(v, m_stride, m_width, m_height, 0, m_height);
+
+    if (m_activityEnabled)
+      stepSparse(n, u, v, nextU, nextV);
+    else if (m_blockDepth > 1 && n > 1)
+      stepBlocked(n, u, v, nextU, nextV);
+    else
+      stepBands(n, u, v, nextU, nextV);
+  };
+
+  if (packed()) {
+    run(m_packedU, m_packedV, m_packedNextU, m_packedNextV);
+    m_viewValid = false;
+  } else {
+    run(m_u, m_v, m_nextU, m_nextV);
+  }
+
+  m_step += n;
+}
+
+void GrayScottSolver::stepSpectral(i32 n) {
+  if (!m_spectral || m_spectral->width() != m_width || m_spectral->height() != m_height ||
+      m_spectral->integrator() != m_integrator)
+    m_spectral = std::make_unique<SpectralStepper>(m_width, m_height, m_integrator);
+
+  syncView();
+
+  auto finishRow = [&](f32* u, f32* v, i32) {
+    if (packed()) {
+      quantizeRow(m_precision, u, m_width);
+      quantizeRow(m_precision, v, m_width);
+    }
+  };
+
+  for (i32 i = 0; i < n; ++i) {
+    PROFILE_SCOPE(m_profiler, "Solver spectral step");
+    m_spectral->step(interior(m_u), interior(m_v), m_stride, m_params, m_pool.get(), finishRow);
+  }
+
+  refreshHalo(m_u, m_stride, m_width, m_height, 0, m_height);
+  refreshHalo(m_v, m_stride, m_width, m_height, 0, m_height);
+
+  // every value was rounded to the storage format, so the view stays exact
+  if (packed()) {
+    m_viewDirty = true;
+    commitView();
+  }
+  m_activityValid = false;
+}
+
+template <typename T>
+void GrayScottSolver::stepBands(i32 n, T*& u, T*& v, T*& nextU, T*& nextV) {
+  // packed rows are widened through a window of 3 rows + 1 output row per field
+  reserveScratch(std::is_same_v<T, f32> ? 0 : 8 * (usize)m_stride);
+
+  auto job = [&](i32 t, i32 threads) {
+    const i32 y0 = (i32)((i64)m_height * t / threads);
+    const i32 y1 = (i32)((i64)m_height * (t + 1) / threads);
+
+    // each worker ping-pongs its own copy of the buffer pointers
+    T *srcU = u, *srcV = v;
+    T *dstU = nextU, *dstV = nextV;
+    f32* scratch = m_scratch[t].data();
+
+    for (i32 i = 0; i < n; ++i) {
+      {
+        PROFILE_SCOPE(m_profiler, "Solver rows");
+        if constexpr (std::is_same_v<T, f32>)
+          stepRows(srcU, srcV, dstU, dstV, y0, y1);
+        else
+          stepRows(srcU, srcV, dstU, dstV, y0, y1, scratch);
+      }
+
+      if (threads > 1) m_pool->barrier();
+
+      std::swap(srcU, dstU);
+      std::swap(srcV, dstV);
+    }
+  };
+
+  if (m_pool)
+    m_pool->run(job);
+  else
+    job(0, 1);
+
+  if (n % 2) {
+    std::swap(u, nextU);
+    std::swap(v, nextV);
+  }
+}
+
+template <typename T>
+void GrayScottSolver::stepBlocked(i32 n, T*& u, T*& v, T*& nextU, T*& nextV) {
+  const i32 tilesX = (m_width + m_tileWidth - 1) / m_tileWidth;
+  const i32 tilesY = (m_height + m_tileHeight - 1) / m_tileHeight;
+  const i32 tileCount = tilesX * tilesY;
+
+  reserveScratch(4 * (usize)(m_tileWidth + 2 * m_blockDepth) * (m_tileHeight + 2 * m_blockDepth));
+
+  auto job = [&](i32 t, i32 threads) {
+    T *srcU = u, *srcV = v;
+    T *dstU = nextU, *dstV = nextV;
+    f32* scratch = m_scratch[t].data();
+
+    for (i32 done = 0; done < n; done += m_blockDepth) {
+      const i32 depth = std::min(m_blockDepth, n - done);
+
+      {
+        PROFILE_SCOPE(m_profiler, "Solver tiles");
+        for (i32 tile = t; tile < tileCount; tile += threads) {
+          i32 x0 = (tile % tilesX) * m_tileWidth;
+          i32 y0 = (tile / tilesX) * m_tileHeight;
+          i32 tw = std::min(m_tileWidth, m_width - x0);
+          i32 th = std::min(m_tileHeight, m_height - y0);
+
+          advanceTile(srcU, srcV, dstU, dstV, x0, y0, tw, th, depth, scratch);
+        }
+      }
+
+      if (threads > 1) m_pool->barrier();
+
+      std::swap(srcU, dstU);
+      std::swap(srcV, dstV);
+    }
+  };
+
+  if (m_pool)
+    m_pool->run(job);
+  else
+    job(0, 1);
+
+  const i32 blocks = (n + m_blockDepth - 1) / m_blockDepth;
+  if (blocks % 2) {
+    std::swap(u, nextU);
+    std::swap(v, nextV);
+  }
+}
+
+template <typename T>
+void GrayScottSolver::stepSparse(i32 n, T*& u, T*& v, T*& nextU, T*& nextV) {
+  // packed tiles are widened through a window of 3 rows + 1 output row per field
+  reserveScratch(std::is_same_v<T, f32> ? 0 : 8 * (usize)(ACTIVITY_TILE + 2));
+
+  if (!m_activityValid) resetActivity();
+  buildActiveTiles();  // picks up stamps since the last call
+  m_activeTileSteps = 0;
+
+  auto job = [&](i32 t, i32 threads) {
+    const i32 y0 = (i32)((i64)m_height * t / threads);
+    const i32 y1 = (i32)((i64)m_height * (t + 1) / threads);
+
+    T *srcU = u, *srcV = v;
+    T *dstU = nextU, *dstV = nextV;
+    f32* scratch = m_scratch[t].data();
+
+    for (i32 i = 0; i < n; ++i) {
+      {
+        PROFILE_SCOPE(m_profiler, "Solver active tiles");
+
+        // an even share of the list, whatever the tiles' positions
+        const usize count = m_activeTiles.size();
+        for (usize j = count * t / threads; j < count * (t + 1) / threads; ++j) {
+          const i32 tile = m_activeTiles[j];
+          if (tile < 0) {
+            // going quiet: the back buffer still holds an older step of it
+            copyTile(srcU, srcV, dstU, dstV, ~tile);
+            m_tileComputed[~tile] = 0;
+          } else {
+            if constexpr (std::is_same_v<T, f32>)
+              m_tileRest[tile] = stepTile(srcU, srcV, dstU, dstV, tile);
+            else
+              m_tileRest[tile] = stepTile(srcU, srcV, dstU, dstV, tile, scratch);
+            m_tileComputed[tile] = 1;
+          }
+        }
+      }
+
+      if (threads > 1) m_pool->barrier();
+
+      refreshHalo(dstU, m_stride, m_width, m_height, y0, y1);
+      refreshHalo(dstV, m_stride, m_width, m_height, y0, y1);
+      if (t == 0) buildActiveTiles();
+
+      if (threads > 1) m_pool->barrier();
+
+      std::swap(srcU, dstU);
+      std::swap(srcV, dstV);
+    }
+  };
+
+  if (m_pool)
+    m_pool->run(job);
+  else
+    job(0, 1);
+
+  if (n % 2) {
+    std::swap(u, nextU);
+    std::swap(v, nextV);
+  }
+
+  // buildActiveTiles() ran once up front and once per step; the last list is for the next call
+  m_activeTileSteps -= m_activeTiles.size() - std::count_if(
+      m_activeTiles.begin(), m_activeTiles.end(), [](i32 tile) { return tile < 0; }
+  );
+  m_activeTileFraction =
+      (f64)m_activeTileSteps / ((f64)n * m_activityTilesX * m_activityTilesY);
+}
+
+template <typename T>
+void GrayScottSolver::advanceTile(
+    const T* srcU, const T* srcV, T* dstU, T* dstV, i32 x0, i32 y0, i32 tw, i32 th, i32 depth,
+    f32* scratch
+) const {
+  const i32 lw = tw + 2 * depth, lh = th + 2 * depth;
+  const usize plane = (usize)lw * lh;
+
+  f32* bufU[2] = {scratch, scratch + plane};
+  f32* bufV[2] = {scratch + 2 * plane, scratch + 3 * plane};
+
+  // load the tile plus a `depth`-wide halo
+  const T* U = interior(srcU);
+  const T* V = interior(srcV);
+  for (i32 ly = 0; ly < lh; ++ly) {
+    const usize gy = wrap(y0 - depth + ly, m_height);
+    loadWrapped(bufU[0] + ly * lw, U + gy * m_stride, x0 - depth, lw, m_width, m_precision);
+    loadWrapped(bufV[0] + ly * lw, V + gy * m_stride, x0 - depth, lw, m_width, m_precision);
+  }
+
+  // step s recomputes everything but the outer s cells
+  i32 cur = 0;
+  for (i32 s = 1; s <= depth; ++s) {
+    const i32 nxt = cur ^ 1;
+
+    for (i32 ly = s; ly < lh - s; ++ly) {
+      const f32* u = bufU[cur] + ly * lw + s;
+      const f32* v = bufV[cur] + ly * lw + s;
+      f32* outU = bufU[nxt] + ly * lw + s;
+      f32* outV = bufV[nxt] + ly * lw + s;
+
+      StencilRow r{u, u + lw, u - lw, v, v + lw, v - lw, outU, outV};
+      m_kernel(r, lw - 2 * s, m_params);
+
+      // keep intermediate steps rounded exactly like stored ones
+      if (packed()) {
+        quantizeRow(m_precision, outU, lw - 2 * s);
+        quantizeRow(m_precision, outV, lw - 2 * s);
+      }
+    }
+
+    cur = nxt;
+  }
+
+  // write back the fully advanced interior
+  for (i32 y = 0; y < th; ++y) {
+    const usize src = (usize)(y + depth) * lw + depth;
+    const usize dst = (usize)(y0 + y) * m_stride + x0;
+    storeCells(interior(dstU) + dst, bufU[cur] + src, tw, m_precision);
+    storeCells(interior(dstV) + dst, bufV[cur] + src, tw, m_precision);
+  }
+}
+
+void GrayScottSolver::stepRows(
+    const f32* srcU, const f32* srcV, f32* dstU, f32* dstV, i32 y0, i32 y1
+) const {
+  const i32 s = m_stride;
+  const f32* U = interior(srcU);
+  const f32* V = interior(srcV);
+
+  for (i32 y = y0; y < y1; ++y) {
+    const usize row = (usize)y * s;
+    f32* outU = interior(dstU) + row;
+    f32* outV = interior(dstV) + row;
+
+    StencilRow r{U + row, U + row + s, U + row - s, V + row, V + row + s, V + row - s, outU, outV};
+    m_kernel(r, m_width, m_params);
+  }
+
+  refreshHalo(dstU, s, m_width, m_height, y0, y1);
+  refreshHalo(dstV, s, m_width, m_height, y0, y1);
+}
+
+void GrayScottSolver::stepRows(
+    const u16* srcU, const u16* srcV, u16* dstU, u16* dstV, i32 y0, i32 y1, f32* scratch
+) const {
+  if (y0 >= y1) return;
+
+  const i32 s = m_stride, n = m_width + 2;
+
+  // rolling window of three widened padded rows per field, plus an output row
+  f32* winU[3] = {scratch, scratch + s, scratch + 2 * s};
+  f32* winV[3] = {scratch + 3 * s, scratch + 4 * s, scratch + 5 * s};
+  f32* outU = scratch + 6 * s;
+  f32* outV = scratch + 7 * s;
+
+  // interior row y is padded row y + 1
+  for (i32 i = 0; i < 2; ++i) {
+    decodeRow(m_precision, srcU + (usize)(y0 + i) * s, winU[i], n);
+    decodeRow(m_precision, srcV + (usize)(y0 + i) * s, winV[i], n);
+  }
+
+  for (i32 y = y0; y < y1; ++y) {
+    const i32 below = (y - y0) % 3, center = (y - y0 + 1) % 3, above = (y - y0 + 2) % 3;
+    decodeRow(m_precision, srcU + (usize)(y + 2) * s, winU[above], n);
+    decodeRow(m_precision, srcV + (usize)(y + 2) * s, winV[above], n);
+
+    StencilRow r{
+        winU[center] + 1, winU[above] + 1, winU[below] + 1,
+        winV[center] + 1, winV[above] + 1, winV[below] + 1,
+        outU, outV,
+    };
+    m_kernel(r, m_width, m_params);
+
+    encodeRow(m_precision, outU, interior(dstU) + (usize)y * s, m_width);
+    encodeRow(m_precision, outV, interior(dstV) + (usize)y * s, m_width);
+  }
+
+  refreshHalo(dstU, s, m_width, m_height, y0, y1);
+  refreshHalo(dstV, s, m_width, m_height, y0, y1);
+}
+
+void GrayScottSolver::setActivityMask(bool enabled, f32 threshold) {
+  m_activityEnabled = enabled;
+  m_activityThreshold = std::max(threshold, 0.0f);
+  m_activityValid = false;
+}
+
+void GrayScottSolver::resetActivity() {
+  m_activityTilesX = (m_width + ACTIVITY_TILE - 1) / ACTIVITY_TILE;
+  m_activityTilesY = (m_height + ACTIVITY_TILE - 1) / ACTIVITY_TILE;
+
+  // nothing known to be at rest, and both buffers may differ everywhere
+  const usize tiles = (usize)m_activityTilesX * m_activityTilesY;
+  m_tileRest.assign(tiles, 0);
+  m_tileComputed.assign(tiles, 1);
+  m_activeTiles.reserve(tiles);
+
+  m_activityValid = true;
+}
+
+void GrayScottSolver::buildActiveTiles() {
+  const i32 tx = m_activityTilesX, ty = m_activityTilesY;
+
+  m_activeTiles.clear();
+  for (i32 y = 0; y < ty; ++y) {
+    for (i32 x = 0; x < tx; ++x) {
+      const i32 tile = y * tx + x;
+
+      // diffusion reaches one cell per step, so only direct neighbours matter
+      bool active = false;
+      for (i32 dy = -1; dy <= 1 && !active; ++dy)
+        for (i32 dx = -1; dx <= 1 && !active; ++dx)
+          active = !m_tileRest[wrap(y + dy, ty) * tx + wrap(x + dx, tx)];
+
+      if (active)
+        m_activeTiles.push_back(tile);
+      else if (m_tileComputed[tile])
+        m_activeTiles.push_back(~tile);
+    }
+  }
+
+  for (i32 tile : m_activeTiles) m_activeTileSteps += tile >= 0;
+}
+
+void GrayScottSolver::markActive(i32 x, i32 y) {
+  if (m_activityValid) m_tileRest[(y / ACTIVITY_TILE) * m_activityTilesX + x / ACTIVITY_TILE] = 0;
+}
+
+void GrayScottSolver::tileBounds(i32 tile, i32& x0, i32& y0, i32& tw, i32& th) const {
+  x0 = (tile % m_activityTilesX) * ACTIVITY_TILE;
+  y0 = (tile / m_activityTilesX) * ACTIVITY_TILE;
+  tw = std::min(ACTIVITY_TILE, m_width - x0);
+  th = std::min(ACTIVITY_TILE, m_height - y0);
+}
+
+bool GrayScottSolver::atRest(const f32* u, const f32* v, i32 n) const {
+  const f32 eps = m_activityThreshold;
+  i32 moving = 0;  // an int reduction, which vectorizes
+  for (i32 x = 0; x < n; ++x) moving |= (v[x] > eps) | (std::fabs(u[x] - 1.0f) > eps);
+  return !moving;
+}
+
+bool GrayScottSolver::stepTile(
+    const f32* srcU, const f32* srcV, f32* dstU, f32* dstV, i32 tile
+) const {
+  i32 x0, y0, tw, th;
+  tileBounds(tile, x0, y0, tw, th);
+
+  const i32 s = m_stride;
+  const f32* U = interior(srcU);
+  const f32* V = interior(srcV);
+  bool rest = true;
+
+  for (i32 y = y0; y < y0 + th; ++y) {
+    const usize c = (usize)y * s + x0;
+    f32* outU = interior(dstU) + c;
+    f32* outV = interior(dstV) + c;
+
+    StencilRow r{U + c, U + c + s, U + c - s, V + c, V + c + s, V + c - s, outU, outV};
+    m_kernel(r, tw, m_params);
+
+    rest &= atRest(outU, outV, tw);
+  }
+
+  return rest;
+}
+
+bool GrayScottSolver::stepTile(
+    const u16* srcU, const u16* srcV, u16* dstU, u16* dstV, i32 tile, f32* scratch
+) const {
+  i32 x0, y0, tw, th;
+  tileBounds(tile, x0, y0, tw, th);
+
+  // padded row y + 1 holds interior row y; padded column x0 is interior x0 - 1
+  const i32 s = m_stride, n = tw + 2, ws = ACTIVITY_TILE + 2;
+  f32* winU[3] = {scratch, scratch + ws, scratch + 2 * ws};
+  f32* winV[3] = {scratch + 3 * ws, scratch + 4 * ws, scratch + 5 * ws};
+  f32* outU = scratch + 6 * ws;
+  f32* outV = scratch + 7 * ws;
+  bool rest = true;
+
+  for (i32 i = 0; i < 2; ++i) {
+    decodeRow(m_precision, srcU + (usize)(y0 + i) * s + x0, winU[i], n);
+    decodeRow(m_precision, srcV + (usize)(y0 + i) * s + x0, winV[i], n);
+  }
+
+  for (i32 y = y0; y < y0 + th; ++y) {
+    const i32 below = (y - y0) % 3, center = (y - y0 + 1) % 3, above = (y - y0 + 2) % 3;
+    decodeRow(m_precision, srcU + (usize)(y + 2) * s + x0, winU[above], n);
+    decodeRow(m_precision, srcV + (usize)(y + 2) * s + x0, winV[above], n);
+
+    StencilRow r{
+        winU[center] + 1, winU[above] + 1, winU[below] + 1,
+        winV[center] + 1, winV[above] + 1, winV[below] + 1,
+        outU, outV,
+    };
+    m_kernel(r, tw, m_params);
+
+    quantizeRow(m_precision, outU, tw);
+    quantizeRow(m_precision, outV, tw);
+    rest &= atRest(outU, outV, tw);
+
+    encodeRow(m_precision, outU, interior(dstU) + (usize)y * s + x0, tw);
+    encodeRow(m_precision, outV, interior(dstV) + (usize)y * s + x0, tw);
+  }
+
+  return rest;
+}
+
+template <typename T>
+void GrayScottSolver::copyTile(const T* srcU, const T* srcV, T* dstU, T* dstV, i32 tile) const {
+  i32 x0, y0, tw, th;
+  tileBounds(tile, x0, y0, tw, th);
+
+  for (i32 y = y0; y < y0 + th; ++y) {
+    const usize c = (usize)y * m_stride + x0;
+    std::memcpy(interior(dstU) + c, interior(srcU) + c, tw * sizeof(T));
+    std::memcpy(interior(dstV) + c, interior(srcV) + c, tw * sizeof(T));
+  }
+}
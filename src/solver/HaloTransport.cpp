@@ -0,0 +1,544 @@
+#include "HaloTransport.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define CPU_RELAX() _mm_pause()
+#else
+#define CPU_RELAX() std::this_thread::yield()
+#endif
+
+static bool fail(std::string* error, std::string message) {
+  if (error) *error = std::move(message);
+  return false;
+}
+
+// segment: SegmentHeader, ChannelEntry[channelCount], then one mailbox per
+// channel at its offset (cache-line aligned)
+struct SegmentHeader {
+  char magic[8];
+  u64 size;
+  u32 channelCount;
+  u32 reserved;
+};
+
+struct ChannelEntry {
+  i32 from, to, tag;
+  u32 reserved;
+  u64 capacity;
+  u64 offset;
+};
+
+inline constexpr char SEGMENT_MAGIC[8] = {'R', 'D', 'H', 'A', 'L', 'O', '\0', '\0'};
+static constexpr usize LINE = 64;
+static constexpr u64 SLOTS = 2;  // messages a sender may be ahead of its receiver
+
+// single producer, single consumer. each side only writes its own counter, on
+// its own cache line, so the two processes never contend for a line. a side
+// that ran out of spins parks on `wakeups` (a futex); the other side bumps it
+// and wakes it after moving its counter, but only while `sleepers` is set
+struct ShmTransport::Mailbox {
+  alignas(LINE) std::atomic<u64> written;
+  alignas(LINE) std::atomic<u64> consumed;
+  alignas(LINE) std::atomic<u32> wakeups;
+  std::atomic<u32> sleepers;
+  alignas(LINE) u64 capacity;
+  u64 bytes[SLOTS];
+
+  u8* slot(u64 i) { return (u8*)(this + 1) + (i % SLOTS) * capacity; }
+};
+
+static_assert(std::atomic<u64>::is_always_lock_free, "counters must work across processes");
+static_assert(std::atomic<u32>::is_always_lock_free && sizeof(std::atomic<u32>) == 4, "futex word");
+
+static usize alignUp(usize n, usize a) { return (n + a - 1) / a * a; }
+
+// futexes on the segment are shared between processes, so not FUTEX_PRIVATE
+static void futexWait(std::atomic<u32>& word, u32 seen, i64 timeoutNs) {
+  timespec timeout{(time_t)(timeoutNs / 1000000000), (long)(timeoutNs % 1000000000)};
+  ::syscall(SYS_futex, (u32*)&word, FUTEX_WAIT, seen, &timeout, nullptr, 0);
+}
+
+static void futexWakeAll(std::atomic<u32>& word) {
+  ::syscall(SYS_futex, (u32*)&word, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+// after moving a counter: wakes the other side if it is parked on the mailbox.
+// the fence pairs with the one in waitFor(), so either the sleeper sees the
+// new counter or this sees the sleeper
+static void wakePeer(std::atomic<u32>& wakeups, std::atomic<u32>& sleepers) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleepers.load(std::memory_order_relaxed) == 0) return;
+  wakeups.fetch_add(1);
+  futexWakeAll(wakeups);
+}
+
+// spins for a few microseconds (a neighbour is usually just finishing its
+// edge rows), then parks on the mailbox until the other side moves its
+// counter, waking every 50 ms to poll `alive`
+template <typename Ready>
+static bool waitFor(
+    Ready ready, std::atomic<u32>& wakeups, std::atomic<u32>& sleepers,
+    const std::function<bool()>& alive
+) {
+  for (i32 i = 0; i < 1024; ++i) {
+    if (ready()) return true;
+    CPU_RELAX();
+  }
+
+  sleepers.fetch_add(1);
+  bool ok = true;
+  for (;;) {
+    const u32 seen = wakeups.load();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ready()) break;
+    if (alive && !alive()) {
+      ok = false;
+      break;
+    }
+    futexWait(wakeups, seen, 50'000'000);
+  }
+  sleepers.fetch_sub(1);
+  return ok;
+}
+
+bool ShmTransport::createSegment(
+    const char* name, const std::vector<HaloChannel>& channels, std::string* error
+) {
+  usize offset = alignUp(sizeof(SegmentHeader) + channels.size() * sizeof(ChannelEntry), LINE);
+  std::vector<ChannelEntry> table;
+
+  for (const HaloChannel& c : channels) {
+    const u64 capacity = alignUp(std::max<usize>(c.capacity, 1), LINE);
+    table.push_back({c.from, c.to, c.tag, 0, capacity, offset});
+    offset += sizeof(Mailbox) + SLOTS * capacity;
+  }
+  const usize size = offset;
+
+  ::shm_unlink(name);
+  int fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) return fail(error, std::string("cannot create ") + name + ": " + std::strerror(errno));
+
+  void* data = MAP_FAILED;
+  if (::ftruncate(fd, (off_t)size) == 0)
+    data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (data == MAP_FAILED) {
+    std::string reason = std::strerror(errno);
+    ::shm_unlink(name);
+    return fail(error, std::string("cannot map ") + name + ": " + reason);
+  }
+
+  // the header and table first, then each mailbox constructed in place
+  SegmentHeader header{};
+  std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+  header.size = size;
+  header.channelCount = (u32)table.size();
+
+  u8* bytes = (u8*)data;
+  std::memcpy(bytes, &header, sizeof(header));
+  std::memcpy(bytes + sizeof(header), table.data(), table.size() * sizeof(ChannelEntry));
+  for (const ChannelEntry& c : table) {
+    auto* box = new (bytes + c.offset) Mailbox;
+    box->written.store(0, std::memory_order_relaxed);
+    box->consumed.store(0, std::memory_order_relaxed);
+    box->wakeups.store(0, std::memory_order_relaxed);
+    box->sleepers.store(0, std::memory_order_relaxed);
+    box->capacity = c.capacity;
+  }
+
+  ::munmap(data, size);
+  return true;
+}
+
+void ShmTransport::removeSegment(const char* name) { ::shm_unlink(name); }
+
+std::unique_ptr<ShmTransport> ShmTransport::attach(const char* name, i32 rank, std::string* error) {
+  int fd = ::shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    fail(error, std::string("cannot open ") + name + ": " + std::strerror(errno));
+    return nullptr;
+  }
+
+  SegmentHeader header{};
+  if (::pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+      std::memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) != 0) {
+    ::close(fd);
+    fail(error, std::string(name) + " is not a halo segment");
+    return nullptr;
+  }
+
+  void* data = ::mmap(nullptr, header.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    fail(error, std::string("cannot map ") + name + ": " + std::strerror(errno));
+    return nullptr;
+  }
+
+  std::unique_ptr<ShmTransport> transport(new ShmTransport(data, header.size, rank));
+  const auto* table = (const ChannelEntry*)((const u8*)data + sizeof(SegmentHeader));
+
+  for (u32 i = 0; i < header.channelCount; ++i) {
+    const ChannelEntry& c = table[i];
+    if (c.from == rank || c.to == rank)
+      transport->m_channels[{c.from, c.to, c.tag}] = (Mailbox*)((u8*)data + c.offset);
+  }
+  return transport;
+}
+
+ShmTransport::ShmTransport(void* data, usize size, i32 rank)
+    : m_data(data), m_size(size), m_rank(rank) {}
+
+ShmTransport::~ShmTransport() {
+  if (m_data) ::munmap(m_data, m_size);
+}
+
+ShmTransport::Mailbox* ShmTransport::mailbox(i32 from, i32 to, i32 tag) const {
+  auto it = m_channels.find({from, to, tag});
+  return it == m_channels.end() ? nullptr : it->second;
+}
+
+bool ShmTransport::send(i32 to, i32 tag, const void* data, usize bytes) {
+  Mailbox* box = mailbox(m_rank, to, tag);
+  if (!box || bytes > box->capacity) return false;
+
+  const u64 n = box->written.load(std::memory_order_relaxed);
+  auto hasRoom = [&] { return n - box->consumed.load(std::memory_order_acquire) < SLOTS; };
+  if (!waitFor(hasRoom, box->wakeups, box->sleepers, m_alive)) return false;
+
+  std::memcpy(box->slot(n), data, bytes);
+  box->bytes[n % SLOTS] = bytes;
+  box->written.store(n + 1, std::memory_order_release);
+  wakePeer(box->wakeups, box->sleepers);
+  return true;
+}
+
+bool ShmTransport::receive(i32 from, i32 tag, void* data, usize bytes) {
+  Mailbox* box = mailbox(from, m_rank, tag);
+  if (!box) return false;
+
+  const u64 n = box->consumed.load(std::memory_order_relaxed);
+  auto hasMessage = [&] { return box->written.load(std::memory_order_acquire) > n; };
+  if (!waitFor(hasMessage, box->wakeups, box->sleepers, m_alive)) return false;
+
+  const bool ok = box->bytes[n % SLOTS] == bytes;
+  if (ok) std::memcpy(data, box->slot(n), bytes);
+  box->consumed.store(n + 1, std::memory_order_release);
+  wakePeer(box->wakeups, box->sleepers);
+  return ok;
+}
+
+// socket transport: each message is a FrameHeader followed by its bytes
+struct FrameHeader {
+  u32 tag, bytes;
+};
+
+static bool splitEndpoint(const std::string& endpoint, std::string& host, std::string& port) {
+  const usize colon = endpoint.rfind(':');
+  if (colon == std::string::npos) return false;
+  host = endpoint.substr(0, colon);
+  port = endpoint.substr(colon + 1);
+  return !host.empty() && !port.empty();
+}
+
+static addrinfo* resolve(const std::string& endpoint, bool passive, std::string* error) {
+  std::string host, port;
+  if (!splitEndpoint(endpoint, host, port)) {
+    fail(error, "bad endpoint " + endpoint + " (expected host:port)");
+    return nullptr;
+  }
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+  addrinfo* result = nullptr;
+  if (int rc = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &result); rc != 0) {
+    fail(error, "cannot resolve " + endpoint + ": " + ::gai_strerror(rc));
+    return nullptr;
+  }
+  return result;
+}
+
+static bool writeAll(int fd, const void* data, usize bytes) {
+  const u8* p = (const u8*)data;
+  while (bytes > 0) {
+    ssize_t n = ::write(fd, p, bytes);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    bytes -= n;
+  }
+  return true;
+}
+
+static bool readAll(int fd, void* data, usize bytes) {
+  u8* p = (u8*)data;
+  while (bytes > 0) {
+    ssize_t n = ::read(fd, p, bytes);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    bytes -= n;
+  }
+  return true;
+}
+
+static void configure(int fd) {
+  int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+std::unique_ptr<SocketTransport> SocketTransport::connect(
+    i32 rank, const std::vector<std::string>& endpoints, const std::vector<i32>& peers,
+    std::string* error, int listener
+) {
+  std::unique_ptr<SocketTransport> transport(new SocketTransport(rank));
+  i32 higherPeers = 0;
+
+  for (i32 peer : peers) {
+    if (peer < 0 || peer >= (i32)endpoints.size()) {
+      fail(error, "no endpoint for rank " + std::to_string(peer));
+      return nullptr;
+    }
+    if (peer > rank) ++higherPeers;
+    transport->m_peers[peer];
+  }
+
+  // listen before connecting anywhere: a higher rank may already be dialing in,
+  // and its connection waits in the backlog until accepted below
+  if (higherPeers == 0 && listener >= 0) {
+    ::close(listener);
+    listener = -1;
+  }
+  if (higherPeers > 0 && listener < 0) {
+    addrinfo* addr = resolve(endpoints[rank], true, error);
+    if (!addr) return nullptr;
+
+    listener = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+    int one = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    const bool ok = listener >= 0 && ::bind(listener, addr->ai_addr, addr->ai_addrlen) == 0 &&
+                    ::listen(listener, higherPeers) == 0;
+    ::freeaddrinfo(addr);
+
+    if (!ok) {
+      fail(error, "cannot listen on " + endpoints[rank] + ": " + std::strerror(errno));
+      if (listener >= 0) ::close(listener);
+      return nullptr;
+    }
+  }
+
+  // lower ranks: dial, retrying while they start up, and introduce ourselves
+  for (auto& [peer, state] : transport->m_peers) {
+    if (peer >= rank) continue;
+
+    addrinfo* addr = resolve(endpoints[peer], false, error);
+    if (!addr) break;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (state.fd < 0 && std::chrono::steady_clock::now() < deadline) {
+      int fd = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+      if (fd >= 0 && ::connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) {
+        state.fd = fd;
+        break;
+      }
+      if (fd >= 0) ::close(fd);
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    ::freeaddrinfo(addr);
+
+    if (state.fd < 0 || !writeAll(state.fd, &rank, sizeof(rank))) {
+      fail(error, "cannot connect to " + endpoints[peer]);
+      break;
+    }
+  }
+
+  // higher ranks: accept and tell them apart by their introduction
+  for (i32 accepted = 0; listener >= 0 && accepted < higherPeers; ++accepted) {
+    int fd = ::accept(listener, nullptr, nullptr);
+    i32 peer = -1;
+    if (fd < 0 || !readAll(fd, &peer, sizeof(peer))) {
+      if (fd >= 0) ::close(fd);
+      fail(error, "failed accepting on " + endpoints[rank]);
+      break;
+    }
+
+    auto it = transport->m_peers.find(peer);
+    if (peer <= rank || it == transport->m_peers.end() || it->second.fd >= 0) {
+      ::close(fd);
+      fail(error, "unexpected rank " + std::to_string(peer) + " on " + endpoints[rank]);
+      break;
+    }
+    it->second.fd = fd;
+  }
+  if (listener >= 0) ::close(listener);
+
+  for (auto& [peer, state] : transport->m_peers) {
+    if (peer == rank) continue;
+    if (state.fd < 0) return nullptr;  // error was set above
+    configure(state.fd);
+    ::fcntl(state.fd, F_SETFL, ::fcntl(state.fd, F_GETFL) | O_NONBLOCK);
+  }
+  return transport;
+}
+
+int SocketTransport::listenLocal(i32 backlog, std::string& endpoint, std::string* error) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t size = sizeof(addr);
+
+  if (fd < 0 || ::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(fd, backlog) != 0 ||
+      ::getsockname(fd, (sockaddr*)&addr, &size) != 0) {
+    fail(error, std::string("cannot listen on a loopback port: ") + std::strerror(errno));
+    if (fd >= 0) ::close(fd);
+    return -1;
+  }
+  endpoint = "127.0.0.1:" + std::to_string(ntohs(addr.sin_port));
+  return fd;
+}
+
+SocketTransport::~SocketTransport() {
+  // a clean shutdown delivers whatever is still queued
+  for (auto& [peer, state] : m_peers) {
+    if (state.fd < 0) continue;
+    ::fcntl(state.fd, F_SETFL, ::fcntl(state.fd, F_GETFL) & ~O_NONBLOCK);
+    if (!m_broken) {
+      writeAll(
+          state.fd, state.outbox.data() + state.outboxSent, state.outbox.size() - state.outboxSent
+      );
+    }
+    ::close(state.fd);
+  }
+}
+
+bool SocketTransport::send(i32 to, i32 tag, const void* data, usize bytes) {
+  if (m_broken) return false;
+
+  if (to == m_rank) {
+    const u8* p = (const u8*)data;
+    m_pending[{to, tag}].emplace_back(p, p + bytes);
+    return true;
+  }
+
+  auto it = m_peers.find(to);
+  if (it == m_peers.end() || it->second.fd < 0) return false;
+  Peer& peer = it->second;
+
+  const FrameHeader frame{(u32)tag, (u32)bytes};
+  peer.outbox.insert(peer.outbox.end(), (const u8*)&frame, (const u8*)(&frame + 1));
+  peer.outbox.insert(peer.outbox.end(), (const u8*)data, (const u8*)data + bytes);
+  return flush(peer);
+}
+
+bool SocketTransport::flush(Peer& peer) {
+  while (peer.outboxSent < peer.outbox.size()) {
+    ssize_t n = ::send(
+        peer.fd, peer.outbox.data() + peer.outboxSent, peer.outbox.size() - peer.outboxSent,
+        MSG_NOSIGNAL
+    );
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n <= 0) return !(m_broken = true);
+    peer.outboxSent += n;
+  }
+
+  if (peer.outboxSent == peer.outbox.size()) {
+    peer.outbox.clear();
+    peer.outboxSent = 0;
+  }
+  return true;
+}
+
+bool SocketTransport::readAvailable(i32 from, Peer& peer) {
+  u8 buffer[64 * 1024];
+  for (;;) {
+    ssize_t n = ::read(peer.fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n < 0) return !(m_broken = true);
+    if (n == 0) {
+      // closed by the peer; what it sent before is still delivered below
+      ::close(peer.fd);
+      peer.fd = -1;
+      break;
+    }
+    peer.inbox.insert(peer.inbox.end(), buffer, buffer + n);
+  }
+
+  usize offset = 0;
+  while (peer.inbox.size() - offset >= sizeof(FrameHeader)) {
+    FrameHeader frame;
+    std::memcpy(&frame, peer.inbox.data() + offset, sizeof(frame));
+    if (peer.inbox.size() - offset - sizeof(frame) < frame.bytes) break;
+
+    const u8* body = peer.inbox.data() + offset + sizeof(frame);
+    m_pending[{from, (i32)frame.tag}].emplace_back(body, body + frame.bytes);
+    offset += sizeof(frame) + frame.bytes;
+  }
+  peer.inbox.erase(peer.inbox.begin(), peer.inbox.begin() + offset);
+  return true;
+}
+
+bool SocketTransport::receive(i32 from, i32 tag, void* data, usize bytes) {
+  std::vector<pollfd> fds;
+  std::vector<i32> ranks;
+
+  for (u32 i = 1;; ++i) {
+    if (auto it = m_pending.find({from, tag}); it != m_pending.end() && !it->second.empty()) {
+      std::vector<u8> message = std::move(it->second.front());
+      it->second.pop_front();
+      if (message.size() != bytes) return false;
+      std::memcpy(data, message.data(), bytes);
+      return true;
+    }
+    if (m_broken) return false;
+    if (auto it = m_peers.find(from); from != m_rank && (it == m_peers.end() || it->second.fd < 0))
+      return false;  // nothing more will come
+    if (i % 64 == 0 && m_alive && !m_alive()) return false;
+
+    // wait on every peer, not just `from`: keeps our own sends flowing and
+    // stashes messages that arrive ahead of the one we want
+    fds.clear();
+    ranks.clear();
+    for (auto& [rank, peer] : m_peers) {
+      if (peer.fd < 0) continue;
+      short events = POLLIN;
+      if (!peer.outbox.empty()) events |= POLLOUT;
+      fds.push_back({peer.fd, events, 0});
+      ranks.push_back(rank);
+    }
+    if (fds.empty()) return false;  // waiting on ourselves with nothing queued
+
+    if (::poll(fds.data(), fds.size(), 50) < 0 && errno != EINTR) return !(m_broken = true);
+
+    for (usize k = 0; k < fds.size(); ++k) {
+      Peer& peer = m_peers[ranks[k]];
+      if ((fds[k].revents & POLLOUT) && !flush(peer)) return false;
+      if ((fds[k].revents & (POLLIN | POLLHUP | POLLERR)) && !readAvailable(ranks[k], peer))
+        return false;
+    }
+  }
+}
@@ -0,0 +1,323 @@
+#include "OutOfCoreSolver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static bool fail(std::string* error, std::string message) {
+  if (error) *error = std::move(message);
+  return false;
+}
+
+static f64 now() {
+  return std::chrono::duration<f64>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static usize pageSize() {
+  static const usize size = (usize)::sysconf(_SC_PAGESIZE);
+  return size;
+}
+static usize pageDown(usize n) { return n / pageSize() * pageSize(); }
+static usize pageUp(usize n) { return pageDown(n + pageSize() - 1); }
+
+namespace {
+// one plane of the mapping, walked front to back within a pass. bytes below
+// `evicted` have been written back and dropped; bytes from `reached` on have not
+// been asked for or written yet, so [evicted, reached) is what may be resident
+class PlaneStream {
+ private:
+  int m_fd;
+  u8* m_base;  // plane start in the mapping, page aligned
+  usize m_offset, m_size;  // in the file; the size is a whole number of pages
+  usize m_prefetched{0}, m_written{0}, m_evicted{0}, m_reached{0};
+
+ public:
+  PlaneStream(int fd, u8* map, usize offset, usize size)
+      : m_fd(fd), m_base(map + offset), m_offset(offset), m_size(size) {}
+
+  // starts reading the plane up to byte `end` into the page cache without
+  // waiting for it. returns the bytes newly asked for
+  usize prefetch(usize end) {
+    end = std::min(pageUp(end), m_size);
+    const usize from = std::max(m_prefetched, m_evicted);
+    if (end <= from) return 0;
+    ::madvise(m_base + from, end - from, MADV_WILLNEED);
+    m_prefetched = end;
+    reach(end);
+    return end - from;
+  }
+
+  // the plane is final up to byte `end`: starts writeback of the whole pages
+  // below it without waiting for it. returns the bytes handed over
+  usize writeBehind(usize end) {
+    reach(end);
+    end = pageDown(std::min(end, m_size));
+    const usize from = std::max(m_written, m_evicted);
+    if (end <= from) return 0;
+    ::sync_file_range(m_fd, (off_t)(m_offset + from), (off_t)(end - from), SYNC_FILE_RANGE_WRITE);
+    m_written = end;
+    return end - from;
+  }
+
+  // drops the whole pages below byte `end` once they are on disk (all of the
+  // plane at m_size). dropping the mapping first moves the dirty bits of the
+  // page tables to the page cache, which writeback then sees
+  void evict(usize end) {
+    end = end >= m_size ? m_size : pageDown(end);
+    if (end <= m_evicted) return;
+    const usize n = end - m_evicted;
+    const off_t offset = (off_t)(m_offset + m_evicted);
+
+    ::madvise(m_base + m_evicted, n, MADV_DONTNEED);
+    ::sync_file_range(
+        m_fd, offset, (off_t)n,
+        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER
+    );
+    ::posix_fadvise(m_fd, offset, (off_t)n, POSIX_FADV_DONTNEED);
+    m_evicted = end;
+  }
+
+  // the whole plane is about to be overwritten: frees its blocks, so the first
+  // write to a page faults in zeros instead of reading contents that are
+  // discarded anyway. a file system without hole punching just reads them
+  void discard() {
+    ::fallocate(m_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)m_offset, (off_t)m_size);
+  }
+
+  void reach(usize end) { m_reached = std::max(m_reached, std::min(end, m_size)); }
+  usize resident() const { return m_reached > m_evicted ? m_reached - m_evicted : 0; }
+};
+}  // namespace
+
+// walks interior rows [0, height) in tiles of options.bandRows, calling
+// `rows(y0, y1)` for each. padded row r starts at byte r * rowBytes of every
+// plane. the tile's source rows plus a halo row either side and readAhead tiles
+// after them are prefetched; destination rows are written behind as tiles
+// finish. source rows no later tile needs and destination tiles writeBehind
+// tiles back are dropped. the caller evicts what is left after the walk
+static void streamRows(
+    std::vector<PlaneStream>& sources, std::vector<PlaneStream>& destinations, i32 height,
+    usize rowBytes, const OutOfCoreOptions& options, OutOfCoreStats& stats,
+    const std::function<void(i32 y0, i32 y1)>& rows
+) {
+  const i32 band = options.bandRows;
+
+  for (i32 y0 = 0; y0 < height; y0 += band) {
+    const i32 y1 = std::min(y0 + band, height);
+
+    const usize ahead = (usize)std::min(y1 + options.readAhead * band, height) + 2;
+    for (PlaneStream& s : sources) stats.bytesPrefetched += s.prefetch(ahead * rowBytes);
+
+    const f64 t0 = now();
+    rows(y0, y1);
+    stats.computeSeconds += now() - t0;
+
+    for (PlaneStream& d : destinations)
+      stats.bytesWritten += d.writeBehind((usize)(y1 + 1) * rowBytes);
+
+    usize resident = 0;
+    for (const PlaneStream& s : sources) resident += s.resident();
+    for (const PlaneStream& d : destinations) resident += d.resident();
+    stats.peakResidentBytes = std::max(stats.peakResidentBytes, resident);
+
+    // the next tile reads padded rows from y1 on
+    const f64 t1 = now();
+    for (PlaneStream& s : sources) s.evict((usize)y1 * rowBytes);
+    const i32 done = y1 - options.writeBehind * band;
+    if (done > 0)
+      for (PlaneStream& d : destinations) d.evict((usize)(done + 1) * rowBytes);
+    stats.evictSeconds += now() - t1;
+  }
+}
+
+static void evictAll(std::vector<PlaneStream>& planes, usize size, OutOfCoreStats& stats) {
+  const f64 t0 = now();
+  for (PlaneStream& p : planes) p.evict(size);
+  stats.evictSeconds += now() - t0;
+}
+
+OutOfCoreSolver::OutOfCoreSolver(i32 width, i32 height, const GrayScottParams& params)
+    : m_width(std::max(width, 1)), m_height(std::max(height, 1)), m_params(params) {
+  m_stride = paddedStride(m_width);
+  m_planeBytes = pageUp((usize)m_stride * (m_height + 2) * sizeof(f32));
+  m_mapSize = 4 * m_planeBytes;
+}
+
+std::unique_ptr<OutOfCoreSolver> OutOfCoreSolver::create(
+    const char* path, i32 width, i32 height, const GrayScottParams& params,
+    const OutOfCoreOptions& options, std::string* error
+) {
+  std::unique_ptr<OutOfCoreSolver> solver(new OutOfCoreSolver(width, height, params));
+  solver->setOptions(options);
+
+  int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    fail(error, std::string("cannot create ") + path + ": " + std::strerror(errno));
+    return nullptr;
+  }
+
+  // sparse until written; the planes are filled tile by tile by reset()
+  void* data = MAP_FAILED;
+  if (::ftruncate(fd, (off_t)solver->m_mapSize) == 0)
+    data = ::mmap(nullptr, solver->m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int mapErrno = errno;
+  ::unlink(path);
+
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    fail(error, std::string("cannot map ") + path + ": " + std::strerror(mapErrno));
+    return nullptr;
+  }
+
+  solver->m_fd = fd;
+  solver->m_map = (u8*)data;
+  solver->m_u = (f32*)solver->m_map;
+  solver->m_v = (f32*)(solver->m_map + solver->m_planeBytes);
+  solver->m_nextU = (f32*)(solver->m_map + 2 * solver->m_planeBytes);
+  solver->m_nextV = (f32*)(solver->m_map + 3 * solver->m_planeBytes);
+  solver->reset();
+  return solver;
+}
+
+OutOfCoreSolver::~OutOfCoreSolver() {
+  if (m_map) ::munmap(m_map, m_mapSize);
+  if (m_fd >= 0) ::close(m_fd);
+}
+
+void OutOfCoreSolver::setOptions(const OutOfCoreOptions& options) {
+  m_options.bandRows = std::max(options.bandRows, 1);
+  m_options.readAhead = std::max(options.readAhead, 0);
+  m_options.writeBehind = std::max(options.writeBehind, 0);
+}
+
+void OutOfCoreSolver::setThreadCount(i32 threads) {
+  threads = std::max(threads, 1);
+  if (threads == threadCount()) return;
+  m_pool = threads > 1 ? std::make_unique<ThreadPool>(threads) : nullptr;
+}
+
+GrayScottState OutOfCoreSolver::state() const {
+  return {m_u + m_stride + 1, m_v + m_stride + 1, m_width, m_height, m_stride, m_step};
+}
+
+f32* OutOfCoreSolver::u() {
+  m_ghostsValid = false;
+  return m_u + m_stride + 1;
+}
+
+f32* OutOfCoreSolver::v() {
+  m_ghostsValid = false;
+  return m_v + m_stride + 1;
+}
+
+void OutOfCoreSolver::reset() {
+  const usize rowBytes = (usize)m_stride * sizeof(f32);
+  std::vector<PlaneStream> none, planes;
+  planes.emplace_back(m_fd, m_map, (u8*)m_u - m_map, m_planeBytes);
+  planes.emplace_back(m_fd, m_map, (u8*)m_v - m_map, m_planeBytes);
+
+  // ghost rows included, so no refresh is needed
+  OutOfCoreStats stats;
+  streamRows(none, planes, m_height, rowBytes, m_options, stats, [&](i32 y0, i32 y1) {
+    const usize r0 = y0 == 0 ? 0 : y0 + 1;
+    const usize r1 = y1 == m_height ? y1 + 2 : y1 + 1;
+    std::fill(m_u + r0 * m_stride, m_u + r1 * m_stride, 1.0f);
+    std::fill(m_v + r0 * m_stride, m_v + r1 * m_stride, 0.0f);
+  });
+  evictAll(planes, m_planeBytes, stats);
+
+  m_ghostsValid = true;
+  m_step = 0;
+}
+
+void OutOfCoreSolver::step(i32 n) {
+  m_stats = {};
+  for (i32 i = 0; i < n; ++i) stepOnce();
+}
+
+void OutOfCoreSolver::stepOnce() {
+  const i32 s = m_stride, w = m_width, h = m_height;
+  const usize rowBytes = (usize)s * sizeof(f32);
+  const usize rowFloats = (usize)s;
+
+  std::vector<PlaneStream> sources, destinations;
+  for (f32* plane : {m_u, m_v})
+    sources.emplace_back(m_fd, m_map, (u8*)plane - m_map, m_planeBytes);
+  for (f32* plane : {m_nextU, m_nextV})
+    destinations.emplace_back(m_fd, m_map, (u8*)plane - m_map, m_planeBytes);
+
+  for (PlaneStream& d : destinations) d.discard();
+
+  // after outside writes: ghost rows now, ghost columns row by row below.
+  // corners are never read by the stencil
+  if (!m_ghostsValid) {
+    for (f32* plane : {m_u, m_v}) {
+      std::memcpy(plane, plane + h * rowFloats, rowBytes);
+      std::memcpy(plane + (h + 1) * rowFloats, plane + rowFloats, rowBytes);
+    }
+  }
+
+  streamRows(sources, destinations, h, rowBytes, m_options, m_stats, [&](i32 y0, i32 y1) {
+    if (!m_ghostsValid) {
+      for (f32* plane : {m_u, m_v}) {
+        for (i32 y = y0; y < y1; ++y) {
+          f32* row = plane + (y + 1) * rowFloats + 1;
+          row[-1] = row[w - 1];
+          row[w] = row[0];
+        }
+      }
+    }
+
+    if (m_pool) {
+      m_pool->run([&](i32 t, i32 threads) {
+        const i32 rows = y1 - y0;
+        computeRows(y0 + rows * t / threads, y0 + rows * (t + 1) / threads);
+      });
+    } else {
+      computeRows(y0, y1);
+    }
+
+    // row 0 is final now; the bottom ghost row mirrors it
+    if (y0 == 0) {
+      for (f32* plane : {m_nextU, m_nextV})
+        std::memcpy(plane + (h + 1) * rowFloats, plane + rowFloats, rowBytes);
+    }
+  });
+
+  for (f32* plane : {m_nextU, m_nextV}) std::memcpy(plane, plane + h * rowFloats, rowBytes);
+
+  evictAll(sources, m_planeBytes, m_stats);
+  evictAll(destinations, m_planeBytes, m_stats);
+
+  std::swap(m_u, m_nextU);
+  std::swap(m_v, m_nextV);
+  m_ghostsValid = true;
+  ++m_step;
+}
+
+void OutOfCoreSolver::computeRows(i32 y0, i32 y1) {
+  const usize s = m_stride;
+  const f32* U = m_u + s + 1;
+  const f32* V = m_v + s + 1;
+
+  for (i32 y = y0; y < y1; ++y) {
+    const usize row = (usize)y * s;
+    f32* outU = m_nextU + s + 1 + row;
+    f32* outV = m_nextV + s + 1 + row;
+
+    StencilRow r{U + row, U + row + s, U + row - s, V + row, V + row + s, V + row - s, outU, outV};
+    m_kernel(r, m_width, m_params);
+
+    outU[-1] = outU[m_width - 1];
+    outU[m_width] = outU[0];
+    outV[-1] = outV[m_width - 1];
+    outV[m_width] = outV[0];
+  }
+}
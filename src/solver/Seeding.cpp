@@ -0,0 +1,30 @@
+#include "Seeding.h"
+
+#include <random>
+
+void seedSquares(GrayScottSolver& solver, u32 seed, i32 count, i32 size) {
+  f32* u = solver.u();
+  f32* v = solver.v();
+  seedSquares(u, v, solver.width(), solver.height(), solver.stride(), seed, count, size);
+}
+
+void seedSquares(
+    f32* u, f32* v, i32 width, i32 height, i32 stride, u32 seed, i32 count, i32 size
+) {
+  // mt19937's raw output is fully specified, unlike the std distributions
+  std::mt19937 rng(seed);
+
+  for (i32 i = 0; i < count; ++i) {
+    i32 cx = rng() % width;
+    i32 cy = rng() % height;
+
+    for (i32 y = cy; y < cy + size; ++y) {
+      for (i32 x = cx; x < cx + size; ++x) {
+        usize idx = (usize)(y % height) * stride + (x % width);
+        f32 noise = (rng() % 1000) / 1000.0f * 0.02f;
+        u[idx] = 0.5f + noise;
+        v[idx] = 0.25f + noise;
+      }
+    }
+  }
+}
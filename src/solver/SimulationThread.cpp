@@ -0,0 +1,200 @@
+#include "SimulationThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+// steps/s is averaged over windows of this length
+static constexpr f64 RATE_WINDOW_SECONDS = 0.5;
+
+SimulationThread::SimulationThread(i32 width, i32 height, const GrayScottParams& params)
+    : m_solver(width, height, params), m_controls{params}, m_thread(&SimulationThread::run, this) {}
+
+SimulationThread::~SimulationThread() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_one();
+  m_thread.join();
+}
+
+void SimulationThread::post(Command command) {
+  {
+    std::lock_guard lock(m_mutex);
+    m_commands.push_back(std::move(command));
+  }
+  m_wake.notify_one();
+}
+
+void SimulationThread::setControls(const Controls& controls) {
+  std::lock_guard lock(m_mutex);
+  m_controls = controls;
+  m_controlsChanged = true;
+}
+
+void SimulationThread::setProfiler(Profiler* profiler) {
+  post([this, profiler](GrayScottSolver& solver) {
+    m_profiler = profiler;
+    if (profiler) profiler->setThreadName("Simulation");
+    solver.setProfiler(profiler);
+  });
+}
+
+void SimulationThread::setView(const ViewRect& view) {
+  post([this, view](GrayScottSolver&) {
+    m_view = view;
+    m_viewSet = true;
+  });
+}
+
+void SimulationThread::setRunning(bool running) {
+  {
+    std::lock_guard lock(m_mutex);
+    m_running = running;
+  }
+  m_wake.notify_one();
+}
+
+void SimulationThread::run() {
+  std::vector<Command> commands;
+  Controls controls;
+
+  u64 windowSteps = 0;
+  Clock::time_point windowStart = Clock::now();
+
+  publish();
+
+  for (;;) {
+    bool running, controlsChanged;
+    {
+      std::unique_lock lock(m_mutex);
+
+      if (!m_running && m_commands.empty() && !m_stop) {
+        m_stepsPerSecond.store(0, std::memory_order_relaxed);
+        m_wake.wait(lock, [&] { return m_running || !m_commands.empty() || m_stop; });
+
+        windowSteps = 0;
+        windowStart = Clock::now();
+      }
+      if (m_stop) return;
+
+      commands.swap(m_commands);
+      running = m_running;
+      controlsChanged = m_controlsChanged;
+      if (controlsChanged) controls = m_controls;
+      m_controlsChanged = false;
+    }
+
+    if (controlsChanged) {
+      m_solver.setParams(controls.params.F, controls.params.k);
+      m_solver.setDiffusion(controls.params.Du, controls.params.Dv);
+      m_solver.setTimeStep(controls.params.dt);
+    }
+
+    for (Command& command : commands) command(m_solver);
+
+    if (!running) {
+      // show the effect of commands (reset, stamps) even while paused
+      if (!commands.empty()) publish();
+      commands.clear();
+      continue;
+    }
+    commands.clear();
+
+    const i32 steps = stepsUntilCapture(m_stepsPerBatch.load(std::memory_order_relaxed));
+
+    Clock::time_point t0 = Clock::now();
+    {
+      PROFILE_SCOPE(m_profiler, "Simulation batch");
+      m_solver.step(steps);
+    }
+    m_activeTileFraction.store(m_solver.activeTileFraction(), std::memory_order_relaxed);
+    capture();
+    {
+      PROFILE_SCOPE(m_profiler, "Snapshot publish");
+      publish();
+    }
+    Clock::time_point t1 = Clock::now();
+
+    m_batchMs.store(
+        std::chrono::duration<f64, std::milli>(t1 - t0).count(), std::memory_order_relaxed
+    );
+
+    windowSteps += steps;
+    f64 elapsed = std::chrono::duration<f64>(t1 - windowStart).count();
+    if (elapsed >= RATE_WINDOW_SECONDS) {
+      m_stepsPerSecond.store(windowSteps / elapsed, std::memory_order_relaxed);
+      windowSteps = 0;
+      windowStart = t1;
+    }
+  }
+}
+
+u32 SimulationThread::setSnapshotStorage(f32* const* slots, usize slotCapacity) {
+  std::lock_guard lock(m_storageMutex);
+
+  for (i32 i = 0; i < SNAPSHOT_SLOTS; ++i) m_externalSlots[i] = slots ? slots[i] : nullptr;
+  m_externalCapacity = slots ? slotCapacity : 0;
+  return ++m_storageGeneration;
+}
+
+void SimulationThread::setRecorder(FieldRecorder* recorder) {
+  std::lock_guard lock(m_recorderMutex);
+  m_recorder = recorder;
+}
+
+i32 SimulationThread::stepsUntilCapture(i32 steps) {
+  std::lock_guard lock(m_recorderMutex);
+  if (!m_recorder) return steps;
+
+  const u64 interval = (u64)m_recorder->options().interval;
+  return (i32)std::min<u64>(steps, interval - m_solver.stepCount() % interval);
+}
+
+void SimulationThread::capture() {
+  std::lock_guard lock(m_recorderMutex);
+  if (!m_recorder || m_solver.stepCount() % m_recorder->options().interval != 0) return;
+
+  PROFILE_SCOPE(m_profiler, "Record capture");
+  GrayScottState state = m_solver.state();
+  m_recorder->submit(state.step, state.width, state.height, state.v, state.u, state.stride);
+}
+
+void SimulationThread::publish() {
+  GrayScottState state = m_solver.state();
+
+  // a view set before a resize reached this thread may stick out of the grid
+  ViewRect view{0, 0, state.width, state.height, 0};
+  if (m_viewSet) {
+    view = m_view;
+    view.x0 = std::min(view.x0, state.width);
+    view.y0 = std::min(view.y0, state.height);
+    view.width = std::clamp(view.width, 0, state.width - view.x0);
+    view.height = std::clamp(view.height, 0, state.height - view.y0);
+  }
+  const usize texels = (usize)view.texelsX() * view.texelsY();
+
+  std::lock_guard lock(m_storageMutex);
+
+  Snapshot& snapshot = m_snapshots.back();
+  f32* dst = m_externalSlots[m_snapshots.backIndex()];
+
+  snapshot.external = dst && texels <= m_externalCapacity;
+  if (!snapshot.external) {
+    snapshot.storage.resize(texels);
+    dst = snapshot.storage.data();
+  }
+
+  snapshot.v = dst;
+  snapshot.width = view.texelsX();
+  snapshot.height = view.texelsY();
+  snapshot.view = view;
+  snapshot.step = state.step;
+  snapshot.storageGeneration = m_storageGeneration;
+
+  reduceView(state.v, state.stride, state.width, state.height, view, dst);
+
+  m_snapshots.publish();
+}
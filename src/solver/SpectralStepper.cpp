@@ -0,0 +1,201 @@
+#include "SpectralStepper.h"
+
+#include <cmath>
+#include <numbers>
+
+#include "GrayScottSolver.h"
+
+const char* integratorName(Integrator integrator) {
+  switch (integrator) {
+    case Integrator::Explicit: return "Explicit Euler";
+    case Integrator::Imex: return "IMEX (spectral)";
+    case Integrator::Etd: return "ETD1 (spectral)";
+    default: return "?";
+  }
+}
+
+// eigenvalues of the 1D second difference u[x-1] - 2 u[x] + u[x+1] on a ring of n
+static std::vector<f64> ringEigenvalues(i32 n) {
+  std::vector<f64> eigen(n);
+  for (i32 k = 0; k < n; ++k) eigen[k] = 2.0 * std::cos(2.0 * std::numbers::pi * k / n) - 2.0;
+  return eigen;
+}
+
+SpectralStepper::SpectralStepper(i32 width, i32 height, Integrator integrator)
+    : m_width{std::max(width, 1)},
+      m_height{std::max(height, 1)},
+      m_integrator{integrator},
+      m_rowFft(m_width),
+      m_columnFft(m_height),
+      m_eigenX(ringEigenvalues(m_width)),
+      m_eigenY(ringEigenvalues(m_height)) {
+  const usize cells = (usize)m_width * m_height;
+  m_field.resize(cells);
+  m_next.resize(cells);
+  if (m_integrator == Integrator::Etd) m_reaction.resize(cells);
+}
+
+void SpectralStepper::buildMultipliers(const GrayScottParams& params) {
+  m_dt = params.dt;
+  m_Du = params.Du;
+  m_Dv = params.Dv;
+
+  const usize cells = (usize)m_width * m_height;
+  const bool etd = m_integrator == Integrator::Etd;
+  const f64 dt = params.dt;
+
+  m_p0.resize(cells);
+  m_q0.resize(cells);
+  m_p1.resize(etd ? cells : 0);
+  m_q1.resize(etd ? cells : 0);
+
+  // a mode decays at rate D * lambda (lambda <= 0); mu is what a step does to u
+  // and nu to v, split into the parts acting on Z(k) and on conj(Z(-k))
+  for (i32 y = 0; y < m_height; ++y) {
+    for (i32 x = 0; x < m_width; ++x) {
+      const usize i = (usize)y * m_width + x;
+      const f64 lambda = m_eigenX[x] + m_eigenY[y];
+      const f64 cu = params.Du * lambda, cv = params.Dv * lambda;
+
+      f64 mu, nu;
+      if (!etd) {
+        mu = 1.0 / (1.0 - dt * cu);
+        nu = 1.0 / (1.0 - dt * cv);
+      } else {
+        mu = std::exp(dt * cu);
+        nu = std::exp(dt * cv);
+
+        // integral of exp(c s) over the step, dt for the mean
+        const f64 phiU = cu != 0 ? std::expm1(dt * cu) / cu : dt;
+        const f64 phiV = cv != 0 ? std::expm1(dt * cv) / cv : dt;
+        m_p1[i] = 0.5 * (phiU + phiV);
+        m_q1[i] = 0.5 * (phiU - phiV);
+      }
+
+      m_p0[i] = 0.5 * (mu + nu);
+      m_q0[i] = 0.5 * (mu - nu);
+    }
+  }
+}
+
+void SpectralStepper::transformRows(
+    Complex* field, i32 y0, i32 y1, bool inverse, Complex* scratch
+) const {
+  for (i32 y = y0; y < y1; ++y) {
+    Complex* row = field + (usize)y * m_width;
+    inverse ? m_rowFft.inverse(row, scratch) : m_rowFft.forward(row, scratch);
+  }
+}
+
+void SpectralStepper::transformColumns(
+    Complex* field, i32 x0, i32 x1, bool inverse, Complex* scratch
+) const {
+  const i32 w = m_width, h = m_height;
+  Complex* lines = scratch;
+  Complex* fftScratch = scratch + COLUMN_BATCH * h;
+
+  // a few neighbouring columns at a time, so each row access uses a full line
+  for (i32 x = x0; x < x1; x += COLUMN_BATCH) {
+    const i32 batch = std::min(COLUMN_BATCH, x1 - x);
+
+    for (i32 y = 0; y < h; ++y)
+      for (i32 b = 0; b < batch; ++b) lines[b * h + y] = field[(usize)y * w + x + b];
+
+    for (i32 b = 0; b < batch; ++b) {
+      Complex* line = lines + b * h;
+      inverse ? m_columnFft.inverse(line, fftScratch) : m_columnFft.forward(line, fftScratch);
+    }
+
+    for (i32 y = 0; y < h; ++y)
+      for (i32 b = 0; b < batch; ++b) field[(usize)y * w + x + b] = lines[b * h + y];
+  }
+}
+
+void SpectralStepper::step(
+    f32* u, f32* v, i32 stride, const GrayScottParams& params, ThreadPool* pool,
+    const RowFn& finishRow
+) {
+  if (params.dt != m_dt || params.Du != m_Du || params.Dv != m_Dv) buildMultipliers(params);
+
+  const i32 threads = pool ? pool->threadCount() : 1;
+  const usize scratchSize = std::max(
+      m_rowFft.scratchSize(), COLUMN_BATCH * (usize)m_height + m_columnFft.scratchSize()
+  );
+  if ((i32)m_scratch.size() < threads) m_scratch.resize(threads);
+  for (auto& s : m_scratch) s.resize(scratchSize);
+
+  const bool etd = m_integrator == Integrator::Etd;
+  const i32 w = m_width, h = m_height;
+  const f64 F = params.F, Fk = (f64)params.F + params.k, dt = params.dt;
+
+  auto job = [&](i32 t, i32 threads) {
+    const i32 y0 = (i32)((i64)h * t / threads), y1 = (i32)((i64)h * (t + 1) / threads);
+    const i32 x0 = (i32)((i64)w * t / threads), x1 = (i32)((i64)w * (t + 1) / threads);
+    Complex* scratch = m_scratch[t].data();
+    auto sync = [&] {
+      if (threads > 1) pool->barrier();
+    };
+
+    // reaction terms in real space; IMEX folds the explicit half-step in directly
+    for (i32 y = y0; y < y1; ++y) {
+      const f32* ur = u + (usize)y * stride;
+      const f32* vr = v + (usize)y * stride;
+      Complex* field = m_field.data() + (usize)y * w;
+
+      for (i32 x = 0; x < w; ++x) {
+        const f64 uu = ur[x], vv = vr[x];
+        const f64 uvv = uu * vv * vv;
+        const f64 ru = -uvv + F * (1.0 - uu), rv = uvv - Fk * vv;
+
+        if (etd) {
+          field[x] = Complex(uu, vv);
+          m_reaction[(usize)y * w + x] = Complex(ru, rv);
+        } else {
+          field[x] = Complex(uu + dt * ru, vv + dt * rv);
+        }
+      }
+    }
+
+    transformRows(m_field.data(), y0, y1, false, scratch);
+    if (etd) transformRows(m_reaction.data(), y0, y1, false, scratch);
+    sync();
+    transformColumns(m_field.data(), x0, x1, false, scratch);
+    if (etd) transformColumns(m_reaction.data(), x0, x1, false, scratch);
+    sync();
+
+    // mode k and its mirror -k together hold both fields' coefficients
+    for (i32 y = y0; y < y1; ++y) {
+      const i32 my = (h - y) % h;
+      for (i32 x = 0; x < w; ++x) {
+        const usize i = (usize)y * w + x;
+        const usize j = (usize)my * w + (w - x) % w;
+
+        Complex z = m_p0[i] * m_field[i] + m_q0[i] * std::conj(m_field[j]);
+        if (etd) z += m_p1[i] * m_reaction[i] + m_q1[i] * std::conj(m_reaction[j]);
+        m_next[i] = z;
+      }
+    }
+    sync();
+
+    transformColumns(m_next.data(), x0, x1, true, scratch);
+    sync();
+    transformRows(m_next.data(), y0, y1, true, scratch);
+
+    for (i32 y = y0; y < y1; ++y) {
+      f32* ur = u + (usize)y * stride;
+      f32* vr = v + (usize)y * stride;
+      const Complex* next = m_next.data() + (usize)y * w;
+
+      for (i32 x = 0; x < w; ++x) {
+        ur[x] = std::max((f32)next[x].real(), 0.0f);
+        vr[x] = std::max((f32)next[x].imag(), 0.0f);
+      }
+      if (finishRow) finishRow(ur, vr, y);
+    }
+  };
+
+  if (pool)
+    pool->run(job);
+  else
+    job(0, 1);
+}
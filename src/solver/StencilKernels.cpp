@@ -0,0 +1,201 @@
+#include "StencilKernels.h"
+
+#include <algorithm>
+
+#include "GrayScottSolver.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RD_X86 1
+#include <immintrin.h>
+#endif
+
+// every variant evaluates the update with the same operation order and without
+// FMA contraction, so all of them produce bit-identical results.
+
+namespace {
+
+inline void scalarCell(const StencilRow& r, i32 x, const GrayScottParams& p) {
+  f32 u = r.u[x];
+  f32 v = r.v[x];
+
+  f32 u_lapl = r.u[x - 1] + r.u[x + 1] + r.uDown[x] + r.uUp[x] - 4 * u;
+  f32 v_lapl = r.v[x - 1] + r.v[x + 1] + r.vDown[x] + r.vUp[x] - 4 * v;
+
+  f32 du = -(u * v * v) + p.F * (1 - u) + p.Du * u_lapl;
+  f32 dv = (u * v * v) - (p.F + p.k) * v + p.Dv * v_lapl;
+
+  r.dstU[x] = std::max(u + du * p.dt, 0.0f);
+  r.dstV[x] = std::max(v + dv * p.dt, 0.0f);
+}
+
+void rowScalar(const StencilRow& r, i32 width, const GrayScottParams& p) {
+  for (i32 x = 0; x < width; ++x) scalarCell(r, x, p);
+}
+
+#ifdef RD_X86
+
+// SSE2 is part of the x86-64 baseline, so this one needs no target attribute
+void rowSSE(const StencilRow& r, i32 width, const GrayScottParams& p) {
+  const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), four = _mm_set1_ps(4.0f);
+  const __m128 F = _mm_set1_ps(p.F), Fk = _mm_set1_ps(p.F + p.k);
+  const __m128 Du = _mm_set1_ps(p.Du), Dv = _mm_set1_ps(p.Dv), dt = _mm_set1_ps(p.dt);
+  const __m128 sign = _mm_set1_ps(-0.0f);
+
+  i32 x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128 u = _mm_loadu_ps(r.u + x);
+    __m128 v = _mm_loadu_ps(r.v + x);
+
+    __m128 ul = _mm_add_ps(_mm_loadu_ps(r.u + x - 1), _mm_loadu_ps(r.u + x + 1));
+    ul = _mm_add_ps(ul, _mm_loadu_ps(r.uDown + x));
+    ul = _mm_add_ps(ul, _mm_loadu_ps(r.uUp + x));
+    ul = _mm_sub_ps(ul, _mm_mul_ps(four, u));
+
+    __m128 vl = _mm_add_ps(_mm_loadu_ps(r.v + x - 1), _mm_loadu_ps(r.v + x + 1));
+    vl = _mm_add_ps(vl, _mm_loadu_ps(r.vDown + x));
+    vl = _mm_add_ps(vl, _mm_loadu_ps(r.vUp + x));
+    vl = _mm_sub_ps(vl, _mm_mul_ps(four, v));
+
+    __m128 uvv = _mm_mul_ps(_mm_mul_ps(u, v), v);
+
+    __m128 du = _mm_xor_ps(uvv, sign);
+    du = _mm_add_ps(du, _mm_mul_ps(F, _mm_sub_ps(one, u)));
+    du = _mm_add_ps(du, _mm_mul_ps(Du, ul));
+
+    __m128 dv = _mm_sub_ps(uvv, _mm_mul_ps(Fk, v));
+    dv = _mm_add_ps(dv, _mm_mul_ps(Dv, vl));
+
+    // max(zero, a) keeps std::max(a, 0) semantics for -0 and NaN
+    _mm_storeu_ps(r.dstU + x, _mm_max_ps(zero, _mm_add_ps(u, _mm_mul_ps(du, dt))));
+    _mm_storeu_ps(r.dstV + x, _mm_max_ps(zero, _mm_add_ps(v, _mm_mul_ps(dv, dt))));
+  }
+
+  for (; x < width; ++x) scalarCell(r, x, p);
+}
+
+__attribute__((target("avx2"))) void rowAVX2(
+    const StencilRow& r, i32 width, const GrayScottParams& p
+) {
+  const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+  const __m256 four = _mm256_set1_ps(4.0f);
+  const __m256 F = _mm256_set1_ps(p.F), Fk = _mm256_set1_ps(p.F + p.k);
+  const __m256 Du = _mm256_set1_ps(p.Du), Dv = _mm256_set1_ps(p.Dv), dt = _mm256_set1_ps(p.dt);
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+
+  i32 x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256 u = _mm256_loadu_ps(r.u + x);
+    __m256 v = _mm256_loadu_ps(r.v + x);
+
+    __m256 ul = _mm256_add_ps(_mm256_loadu_ps(r.u + x - 1), _mm256_loadu_ps(r.u + x + 1));
+    ul = _mm256_add_ps(ul, _mm256_loadu_ps(r.uDown + x));
+    ul = _mm256_add_ps(ul, _mm256_loadu_ps(r.uUp + x));
+    ul = _mm256_sub_ps(ul, _mm256_mul_ps(four, u));
+
+    __m256 vl = _mm256_add_ps(_mm256_loadu_ps(r.v + x - 1), _mm256_loadu_ps(r.v + x + 1));
+    vl = _mm256_add_ps(vl, _mm256_loadu_ps(r.vDown + x));
+    vl = _mm256_add_ps(vl, _mm256_loadu_ps(r.vUp + x));
+    vl = _mm256_sub_ps(vl, _mm256_mul_ps(four, v));
+
+    __m256 uvv = _mm256_mul_ps(_mm256_mul_ps(u, v), v);
+
+    __m256 du = _mm256_xor_ps(uvv, sign);
+    du = _mm256_add_ps(du, _mm256_mul_ps(F, _mm256_sub_ps(one, u)));
+    du = _mm256_add_ps(du, _mm256_mul_ps(Du, ul));
+
+    __m256 dv = _mm256_sub_ps(uvv, _mm256_mul_ps(Fk, v));
+    dv = _mm256_add_ps(dv, _mm256_mul_ps(Dv, vl));
+
+    _mm256_storeu_ps(r.dstU + x, _mm256_max_ps(zero, _mm256_add_ps(u, _mm256_mul_ps(du, dt))));
+    _mm256_storeu_ps(r.dstV + x, _mm256_max_ps(zero, _mm256_add_ps(v, _mm256_mul_ps(dv, dt))));
+  }
+
+  for (; x < width; ++x) scalarCell(r, x, p);
+}
+
+__attribute__((target("avx512f"))) void rowAVX512(
+    const StencilRow& r, i32 width, const GrayScottParams& p
+) {
+  const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.0f);
+  const __m512 four = _mm512_set1_ps(4.0f);
+  const __m512 F = _mm512_set1_ps(p.F), Fk = _mm512_set1_ps(p.F + p.k);
+  const __m512 Du = _mm512_set1_ps(p.Du), Dv = _mm512_set1_ps(p.Dv), dt = _mm512_set1_ps(p.dt);
+  const __m512i sign = _mm512_set1_epi32((i32)0x80000000);
+
+  // the tail is handled with a masked iteration instead of scalar code
+  for (i32 x = 0; x < width; x += 16) {
+    const __mmask16 m = width - x >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (width - x)) - 1);
+
+    __m512 u = _mm512_maskz_loadu_ps(m, r.u + x);
+    __m512 v = _mm512_maskz_loadu_ps(m, r.v + x);
+
+    __m512 ul = _mm512_add_ps(
+        _mm512_maskz_loadu_ps(m, r.u + x - 1), _mm512_maskz_loadu_ps(m, r.u + x + 1)
+    );
+    ul = _mm512_add_ps(ul, _mm512_maskz_loadu_ps(m, r.uDown + x));
+    ul = _mm512_add_ps(ul, _mm512_maskz_loadu_ps(m, r.uUp + x));
+    ul = _mm512_sub_ps(ul, _mm512_mul_ps(four, u));
+
+    __m512 vl = _mm512_add_ps(
+        _mm512_maskz_loadu_ps(m, r.v + x - 1), _mm512_maskz_loadu_ps(m, r.v + x + 1)
+    );
+    vl = _mm512_add_ps(vl, _mm512_maskz_loadu_ps(m, r.vDown + x));
+    vl = _mm512_add_ps(vl, _mm512_maskz_loadu_ps(m, r.vUp + x));
+    vl = _mm512_sub_ps(vl, _mm512_mul_ps(four, v));
+
+    __m512 uvv = _mm512_mul_ps(_mm512_mul_ps(u, v), v);
+
+    __m512 du = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(uvv), sign));
+    du = _mm512_add_ps(du, _mm512_mul_ps(F, _mm512_sub_ps(one, u)));
+    du = _mm512_add_ps(du, _mm512_mul_ps(Du, ul));
+
+    __m512 dv = _mm512_sub_ps(uvv, _mm512_mul_ps(Fk, v));
+    dv = _mm512_add_ps(dv, _mm512_mul_ps(Dv, vl));
+
+    __m512 nu = _mm512_max_ps(zero, _mm512_add_ps(u, _mm512_mul_ps(du, dt)));
+    __m512 nv = _mm512_max_ps(zero, _mm512_add_ps(v, _mm512_mul_ps(dv, dt)));
+    _mm512_mask_storeu_ps(r.dstU + x, m, nu);
+    _mm512_mask_storeu_ps(r.dstV + x, m, nv);
+  }
+}
+
+#endif  // RD_X86
+
+}  // namespace
+
+KernelIsa detectKernelIsa() {
+#ifdef RD_X86
+  static const KernelIsa best = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return KernelIsa::AVX512;
+    if (__builtin_cpu_supports("avx2")) return KernelIsa::AVX2;
+    return KernelIsa::SSE;
+  }();
+  return best;
+#else
+  return KernelIsa::Scalar;
+#endif
+}
+
+RowKernel selectRowKernel(KernelIsa isa) {
+  isa = std::min(isa, detectKernelIsa());
+
+  switch (isa) {
+#ifdef RD_X86
+    case KernelIsa::AVX512: return rowAVX512;
+    case KernelIsa::AVX2: return rowAVX2;
+    case KernelIsa::SSE: return rowSSE;
+#endif
+    default: return rowScalar;
+  }
+}
+
+const char* kernelIsaName(KernelIsa isa) {
+  switch (isa) {
+    case KernelIsa::Scalar: return "Scalar";
+    case KernelIsa::SSE: return "SSE";
+    case KernelIsa::AVX2: return "AVX2";
+    case KernelIsa::AVX512: return "AVX-512";
+    default: return "Unknown";
+  }
+}
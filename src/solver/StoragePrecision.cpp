@@ -0,0 +1,169 @@
+#include "StoragePrecision.h"
+
+#include <bit>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+u16 floatToHalf(f32 f) {
+  const u32 x = std::bit_cast<u32>(f);
+  const u32 sign = (x >> 16) & 0x8000;
+  const u32 abs = x & 0x7FFFFFFF;
+
+  if (abs > 0x7F800000) return sign | 0x7E00 | ((abs >> 13) & 0x3FF);  // NaN
+  if (abs >= 0x477FF000) return sign | 0x7C00;                          // overflow / inf
+  if (abs < 0x33000000) return sign;                                    // underflow
+
+  if (abs < 0x38800000) {
+    // half subnormal
+    const u32 shift = 126 - (abs >> 23);
+    const u32 m = (abs & 0x7FFFFF) | 0x800000;
+    u32 h = m >> shift;
+    const u32 rem = m & ((1u << shift) - 1), tie = 1u << (shift - 1);
+    if (rem > tie || (rem == tie && (h & 1))) ++h;
+    return sign | h;
+  }
+
+  // normal, rebias the exponent from 127 to 15
+  u32 h = (abs - 0x38000000) >> 13;
+  const u32 rem = abs & 0x1FFF;
+  if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) ++h;
+  return sign | h;
+}
+
+f32 halfToFloat(u16 h) {
+  const u32 sign = (u32)(h & 0x8000) << 16;
+  const u32 e = (h >> 10) & 0x1F;
+  const u32 m = h & 0x3FF;
+
+  if (e == 0) {
+    f32 r = std::ldexp((f32)m, -24);
+    return sign ? -r : r;
+  }
+  if (e == 31) return std::bit_cast<f32>(sign | 0x7F800000 | (m << 13) | (m ? 0x400000 : 0));
+
+  return std::bit_cast<f32>(sign | ((e + 112) << 23) | (m << 13));
+}
+
+u16 floatToBF16(f32 f) {
+  const u32 x = std::bit_cast<u32>(f);
+  if ((x & 0x7FFFFFFF) > 0x7F800000) return (u16)((x >> 16) | 0x40);  // keep NaN quiet
+  return (u16)((x + 0x7FFF + ((x >> 16) & 1)) >> 16);
+}
+
+f32 bf16ToFloat(u16 b) { return std::bit_cast<f32>((u32)b << 16); }
+
+#ifdef RD_X86
+
+__attribute__((target("avx2,f16c"))) void decodeHalfF16C(const u16* src, f32* dst, i32 n) {
+  i32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  for (; i < n; ++i) dst[i] = halfToFloat(src[i]);
+}
+
+__attribute__((target("avx2,f16c"))) void encodeHalfF16C(const f32* src, u16* dst, i32 n) {
+  i32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*)(dst + i), h);
+  }
+  for (; i < n; ++i) dst[i] = floatToHalf(src[i]);
+}
+
+__attribute__((target("avx2"))) void decodeBF16AVX2(const u16* src, f32* dst, i32 n) {
+  i32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i b = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+    _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(b, 16)));
+  }
+  for (; i < n; ++i) dst[i] = bf16ToFloat(src[i]);
+}
+
+__attribute__((target("avx2"))) void encodeBF16AVX2(const f32* src, u16* dst, i32 n) {
+  const __m256i bias = _mm256_set1_epi32(0x7FFF), one = _mm256_set1_epi32(1);
+
+  i32 i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 f = _mm256_loadu_ps(src + i);
+    __m256i x = _mm256_castps_si256(f);
+
+    // NaN lanes are left to the scalar path below
+    if (_mm256_movemask_ps(_mm256_cmp_ps(f, f, _CMP_UNORD_Q))) break;
+
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+    __m256i r = _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_add_epi32(bias, lsb)), 16);
+
+    // pack the 32-bit lanes down to 16 bits (packus works per 128-bit half)
+    __m128i lo = _mm256_castsi256_si128(r), hi = _mm256_extracti128_si256(r, 1);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi32(lo, hi));
+  }
+  for (; i < n; ++i) dst[i] = floatToBF16(src[i]);
+}
+
+bool hasF16C() {
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+  }();
+  return supported;
+}
+
+#endif  // RD_X86
+
+}  // namespace
+
+void decodeRow(StoragePrecision p, const u16* src, f32* dst, i32 n) {
+#ifdef RD_X86
+  if (hasF16C()) {
+    if (p == StoragePrecision::F16) return decodeHalfF16C(src, dst, n);
+    if (p == StoragePrecision::BF16) return decodeBF16AVX2(src, dst, n);
+  }
+#endif
+  for (i32 i = 0; i < n; ++i) dst[i] = decodeValue(p, src[i]);
+}
+
+void encodeRow(StoragePrecision p, const f32* src, u16* dst, i32 n) {
+#ifdef RD_X86
+  if (hasF16C()) {
+    if (p == StoragePrecision::F16) return encodeHalfF16C(src, dst, n);
+    if (p == StoragePrecision::BF16) return encodeBF16AVX2(src, dst, n);
+  }
+#endif
+  for (i32 i = 0; i < n; ++i) dst[i] = encodeValue(p, src[i]);
+}
+
+void quantizeRow(StoragePrecision p, f32* row, i32 n) {
+  if (p == StoragePrecision::F32) return;
+
+  u16 packed[256];
+  for (i32 i = 0; i < n; i += 256) {
+    i32 len = n - i < 256 ? n - i : 256;
+    encodeRow(p, row + i, packed, len);
+    decodeRow(p, packed, row + i, len);
+  }
+}
+
+u16 encodeValue(StoragePrecision p, f32 value) {
+  return p == StoragePrecision::BF16 ? floatToBF16(value) : floatToHalf(value);
+}
+
+f32 decodeValue(StoragePrecision p, u16 value) {
+  return p == StoragePrecision::BF16 ? bf16ToFloat(value) : halfToFloat(value);
+}
+
+const char* storagePrecisionName(StoragePrecision p) {
+  switch (p) {
+    case StoragePrecision::F32: return "fp32";
+    case StoragePrecision::F16: return "fp16";
+    case StoragePrecision::BF16: return "bf16";
+    default: return "Unknown";
+  }
+}
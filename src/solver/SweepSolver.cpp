@@ -0,0 +1,254 @@
+#include "SweepSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Seeding.h"
+#include "StencilKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <xmmintrin.h>
+#endif
+
+std::vector<SweepPoint> sweepGrid(f32 fMin, f32 fMax, i32 fCount, f32 kMin, f32 kMax, i32 kCount) {
+  auto at = [](f32 lo, f32 hi, i32 i, i32 n) {
+    return n > 1 ? lo + (hi - lo) * i / (n - 1) : lo;
+  };
+
+  std::vector<SweepPoint> points;
+  for (i32 j = 0; j < kCount; ++j)
+    for (i32 i = 0; i < fCount; ++i)
+      points.push_back({at(fMin, fMax, i, fCount), at(kMin, kMax, j, kCount)});
+  return points;
+}
+
+const char* sweepOutcomeName(SweepOutcome outcome) {
+  switch (outcome) {
+    case SweepOutcome::Decayed: return "decayed";
+    case SweepOutcome::Uniform: return "uniform";
+    case SweepOutcome::Steady: return "steady";
+    case SweepOutcome::Dynamic: return "dynamic";
+    case SweepOutcome::Unstable: return "unstable";
+    default: return "?";
+  }
+}
+
+SweepMetrics measureSweepRun(const f32* v, const f32* earlierV, i32 size, i32 interval) {
+  const usize n = (usize)size * size;
+  f64 sum = 0, sq = 0, change = 0, maxV = 0;
+  usize covered = 0;
+  bool finite = true;
+
+  for (usize i = 0; i < n; ++i) {
+    const f64 x = v[i];
+    finite &= std::isfinite(v[i]);
+    sum += x;
+    sq += x * x;
+    maxV = std::max(maxV, x);
+    covered += v[i] > 0.2f;
+    change += (x - earlierV[i]) * (x - earlierV[i]);
+  }
+
+  SweepMetrics m;
+  if (!finite) {
+    m.outcome = SweepOutcome::Unstable;
+    return m;
+  }
+
+  const f64 mean = sum / n;
+  m.meanV = (f32)mean;
+  m.coverage = (f32)((f64)covered / n);
+  m.contrast = (f32)std::sqrt(std::max(sq / n - mean * mean, 0.0));
+  m.drift = (f32)(std::sqrt(change / n) / std::max(interval, 1));
+
+  if (maxV < 1e-3) m.outcome = SweepOutcome::Decayed;
+  else if (m.contrast < 1e-3f) m.outcome = SweepOutcome::Uniform;
+  else if (m.drift < 1e-6f) m.outcome = SweepOutcome::Steady;
+  else m.outcome = SweepOutcome::Dynamic;
+  return m;
+}
+
+namespace {
+
+constexpr i32 LANES = SweepSolver::LANES;
+
+// LANES runs per cell, each with its own F and F + k
+struct LaneParams {
+  alignas(32) f32 F[LANES];
+  alignas(32) f32 Fk[LANES];
+  f32 Du, Dv, dt;
+};
+
+// one grid row of a batch. the per-cell lane loop has a fixed trip count over
+// contiguous lanes, so the compiler turns it into one (AVX2) or two (SSE)
+// vector operations per term; the terms are the scalar kernel's, in its order
+[[gnu::always_inline]] inline void laneRow(
+    const f32* __restrict u, const f32* __restrict uUp, const f32* __restrict uDown,
+    const f32* __restrict v, const f32* __restrict vUp, const f32* __restrict vDown,
+    f32* __restrict dstU, f32* __restrict dstV, i32 size, const LaneParams& p
+) {
+  for (i32 x = 0; x < size; ++x) {
+    const usize c = (usize)x * LANES;
+    const usize l = (usize)(x == 0 ? size - 1 : x - 1) * LANES;
+    const usize r = (usize)(x == size - 1 ? 0 : x + 1) * LANES;
+
+    for (i32 i = 0; i < LANES; ++i) {
+      const f32 uu = u[c + i], vv = v[c + i];
+
+      const f32 uLapl = u[l + i] + u[r + i] + uDown[c + i] + uUp[c + i] - 4 * uu;
+      const f32 vLapl = v[l + i] + v[r + i] + vDown[c + i] + vUp[c + i] - 4 * vv;
+
+      const f32 du = -(uu * vv * vv) + p.F[i] * (1 - uu) + p.Du * uLapl;
+      const f32 dv = (uu * vv * vv) - p.Fk[i] * vv + p.Dv * vLapl;
+
+      dstU[c + i] = std::max(uu + du * p.dt, 0.0f);
+      dstV[c + i] = std::max(vv + dv * p.dt, 0.0f);
+    }
+  }
+}
+
+// n steps of one batch, ping-ponging between the two halves of its storage
+[[gnu::always_inline]] inline void laneSteps(
+    f32* u, f32* v, f32* nextU, f32* nextV, i32 size, i32 n, const LaneParams& p
+) {
+  const usize row = (usize)size * LANES;
+  for (i32 s = 0; s < n; ++s) {
+    for (i32 y = 0; y < size; ++y) {
+      const usize c = y * row;
+      const usize up = (y == size - 1 ? 0 : y + 1) * row;
+      const usize down = (y == 0 ? size - 1 : y - 1) * row;
+      laneRow(u + c, u + up, u + down, v + c, v + up, v + down, nextU + c, nextV + c, size, p);
+    }
+    std::swap(u, nextU);
+    std::swap(v, nextV);
+  }
+}
+
+void laneStepsDefault(f32* u, f32* v, f32* nu, f32* nv, i32 size, i32 n, const LaneParams& p) {
+  laneSteps(u, v, nu, nv, size, n, p);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) void laneStepsAVX2(
+    f32* u, f32* v, f32* nu, f32* nv, i32 size, i32 n, const LaneParams& p
+) {
+  laneSteps(u, v, nu, nv, size, n, p);
+}
+#endif
+
+using LaneStepsFn = void (*)(f32*, f32*, f32*, f32*, i32, i32, const LaneParams&);
+
+LaneStepsFn selectLaneSteps() {
+#if defined(__x86_64__) || defined(__i386__)
+  if (detectKernelIsa() >= KernelIsa::AVX2) return laneStepsAVX2;
+#endif
+  return laneStepsDefault;
+}
+
+// flush-to-zero and denormals-are-zero for the calling thread while alive.
+// decaying runs spend most of their time on subnormal v, and one such lane
+// stalls the whole vector, so a sweep over a wide (F, k) range slows down
+// several times without it
+class FlushDenormals {
+#if defined(__x86_64__) || defined(__i386__)
+  u32 m_saved;
+
+ public:
+  explicit FlushDenormals(bool enable) : m_saved(_mm_getcsr()) {
+    if (enable) _mm_setcsr(m_saved | 0x8040);  // FTZ | DAZ
+  }
+  ~FlushDenormals() { _mm_setcsr(m_saved); }
+#else
+ public:
+  explicit FlushDenormals(bool) {}
+#endif
+};
+
+}  // namespace
+
+SweepSolver::SweepSolver(i32 size, std::vector<SweepPoint> points, const GrayScottParams& shared)
+    : m_size(std::max(size, 1)), m_shared(shared), m_points(std::move(points)) {
+  m_batches = ((i32)m_points.size() + LANES - 1) / LANES;
+  m_storage.assign(m_batches, std::vector<f32>(4 * planeSize()));
+  m_flipped.assign(m_batches, false);
+  seed(1);
+}
+
+void SweepSolver::setThreadCount(i32 threads) {
+  threads = std::max(threads, 1);
+  if (threads == threadCount()) return;
+  m_pool = threads > 1 ? std::make_unique<ThreadPool>(threads) : nullptr;
+}
+
+void SweepSolver::seed(u32 seed) {
+  const usize cells = (usize)m_size * m_size;
+  std::vector<f32> u(cells, 1.0f), v(cells, 0.0f);
+  seedSquares(u.data(), v.data(), m_size, m_size, m_size, seed);
+
+  for (i32 b = 0; b < m_batches; ++b) {
+    f32* su = m_storage[b].data();
+    f32* sv = su + planeSize();
+    for (usize c = 0; c < cells; ++c) {
+      std::fill_n(su + c * LANES, LANES, u[c]);
+      std::fill_n(sv + c * LANES, LANES, v[c]);
+    }
+    m_flipped[b] = false;
+  }
+  m_step = 0;
+}
+
+void SweepSolver::stepBatch(i32 batch, i32 n) {
+  static const LaneStepsFn laneStepsFn = selectLaneSteps();
+
+  // lanes past the last point repeat it; their results are never read
+  LaneParams p;
+  for (i32 i = 0; i < LANES; ++i) {
+    const SweepPoint& point = m_points[std::min(batch * LANES + i, runCount() - 1)];
+    p.F[i] = point.F;
+    p.Fk[i] = point.F + point.k;
+  }
+  p.Du = m_shared.Du;
+  p.Dv = m_shared.Dv;
+  p.dt = m_shared.dt;
+
+  const usize plane = planeSize();
+  f32* base = m_storage[batch].data();
+  f32 *u = base, *v = base + plane, *nextU = base + 2 * plane, *nextV = base + 3 * plane;
+  if (m_flipped[batch]) {
+    std::swap(u, nextU);
+    std::swap(v, nextV);
+  }
+
+  FlushDenormals flush(m_flushDenormals);
+  laneStepsFn(u, v, nextU, nextV, m_size, n, p);
+  if (n % 2) m_flipped[batch] ^= 1;
+}
+
+void SweepSolver::step(i32 n) {
+  if (n <= 0 || m_points.empty()) return;
+
+  // whole batches per worker: a batch never needs data from another one
+  auto job = [&](i32 t, i32 threads) {
+    for (i32 b = t; b < m_batches; b += threads) stepBatch(b, n);
+  };
+
+  if (m_pool)
+    m_pool->run(job);
+  else
+    job(0, 1);
+  m_step += n;
+}
+
+void SweepSolver::copyRun(i32 run, f32* u, f32* v) const {
+  const i32 batch = run / LANES, lane = run % LANES;
+  const usize plane = planeSize();
+  const f32* su = m_storage[batch].data() + (m_flipped[batch] ? 2 * plane : 0);
+  const f32* sv = su + plane;
+
+  const usize cells = (usize)m_size * m_size;
+  for (usize c = 0; c < cells; ++c) {
+    u[c] = su[c * LANES + lane];
+    v[c] = sv[c * LANES + lane];
+  }
+}
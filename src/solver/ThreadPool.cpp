@@ -0,0 +1,84 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define CPU_RELAX() _mm_pause()
+#else
+#define CPU_RELAX() std::this_thread::yield()
+#endif
+
+void Barrier::arriveAndWait() {
+  u32 gen = m_generation.load(std::memory_order_acquire);
+
+  // last thread to arrive re-arms the barrier and releases everyone
+  if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    m_remaining.store(m_threads, std::memory_order_relaxed);
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_generation.notify_all();
+    return;
+  }
+
+  for (i32 i = 0; i < SPIN_ITERATIONS; ++i) {
+    if (m_generation.load(std::memory_order_acquire) != gen) return;
+    CPU_RELAX();
+  }
+
+  while (m_generation.load(std::memory_order_acquire) == gen) m_generation.wait(gen);
+}
+
+ThreadPool::ThreadPool(i32 threads)
+    : m_threadCount{std::max(threads, 1)}, m_barrier{std::max(threads, 1)} {
+  m_workers.reserve(m_threadCount - 1);
+  for (i32 t = 1; t < m_threadCount; ++t) m_workers.emplace_back(&ThreadPool::workerLoop, this, t);
+}
+
+ThreadPool::~ThreadPool() {
+  m_stop.store(true, std::memory_order_release);
+  m_jobGeneration.fetch_add(1, std::memory_order_release);
+  m_jobGeneration.notify_all();
+
+  for (auto& w : m_workers) w.join();
+}
+
+void ThreadPool::run(const Job& job) {
+  if (m_threadCount == 1) {
+    job(0, 1);
+    return;
+  }
+
+  m_job = &job;
+  m_pending.store(m_threadCount - 1, std::memory_order_relaxed);
+  m_jobGeneration.fetch_add(1, std::memory_order_release);
+  m_jobGeneration.notify_all();
+
+  job(0, m_threadCount);
+
+  // wait for the other workers to finish
+  for (i32 spin = 0; m_pending.load(std::memory_order_acquire) != 0; ++spin) {
+    if (spin < 4096) {
+      CPU_RELAX();
+    } else {
+      i32 pending = m_pending.load(std::memory_order_acquire);
+      if (pending != 0) m_pending.wait(pending);
+    }
+  }
+
+  m_job = nullptr;
+}
+
+void ThreadPool::workerLoop(i32 thread) {
+  u32 seen = 0;
+
+  while (true) {
+    m_jobGeneration.wait(seen, std::memory_order_acquire);
+    seen = m_jobGeneration.load(std::memory_order_acquire);
+
+    if (m_stop.load(std::memory_order_acquire)) return;
+
+    (*m_job)(thread, m_threadCount);
+
+    if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) m_pending.notify_one();
+  }
+}
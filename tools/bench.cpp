@@ -0,0 +1,410 @@
+// headless throughput benchmark over a matrix of backends, grid sizes,
+// steps-per-frame and presets. results go out as CSV or JSON.
+// usage: reaction_diffusion_bench [--sizes 256,1024] [--steps 1,16] [--presets Mazes|all]
+//                                 [--backends cpu,gpu-compute] [--warmup N] [--reps N]
+//                                 [--min-time S] [--format csv|json] [--out FILE]
+// GPU rows need an EGL driver and must be run from the repository root (shader paths).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AutoTuner.h"
+#include "GrayScottSolver.h"
+#include "Presets.h"
+#include "Seeding.h"
+#include "types.h"
+
+#ifdef RD_BENCH_GPU
+#include "GpuSolver.h"
+#include "OffscreenContext.h"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::vector<i32> sizes{256, 1024};
+  std::vector<i32> steps{1, 16};
+  std::vector<std::string> presets{"Mazes"};
+  std::vector<std::string> backends;  // substrings; empty = all
+  i32 warmup = 3;                     // frames
+  i32 reps = 5;
+  f64 minTime = 0.05;  // seconds per repetition
+  std::string format = "csv";
+  std::string out;
+};
+
+struct Backend {
+  std::string name;
+  bool gpu = false;
+
+  // CPU
+  KernelIsa isa = KernelIsa::Scalar;
+  i32 threads = 1;
+  i32 blockDepth = 1;
+  StoragePrecision precision = StoragePrecision::F32;
+  bool activityMask = false;  // both: skip resting tiles (threshold 1e-4)
+
+  // GPU
+  i32 gpuBackend = 0;  // GpuBackend
+  i32 fusedSteps = 1;
+};
+
+struct Result {
+  std::string backend, preset;
+  i32 width, height, stepsPerFrame, framesPerRep, reps;
+  f64 medianSeconds, minSeconds;
+  f64 cellsPerSecond, nsPerCellStep, bandwidthGBs;
+  f64 gpuNsPerCellStep = 0;  // GPU rows: execution time from GL timestamp queries
+};
+
+// one frame = steps-per-frame steps; returns once they are complete
+using FrameFn = std::function<void()>;
+
+static std::vector<std::string> split(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  for (std::string item; std::getline(ss, item, ',');)
+    if (!item.empty()) items.push_back(item);
+  return items;
+}
+
+static std::string lower(std::string s) {
+  for (char& c : s) c = (char)std::tolower((unsigned char)c);
+  return s;
+}
+
+// compulsory traffic of one cell update: read u, v and write u, v once
+static f64 bytesPerCellStep(const Backend& b) {
+  return 4.0 * (b.precision == StoragePrecision::F32 ? 4 : 2);
+}
+
+static std::vector<Backend> cpuBackends() {
+  std::vector<Backend> list;
+
+  const KernelIsa best = detectKernelIsa();
+  for (i32 i = 0; i <= (i32)best; ++i) {
+    Backend b;
+    b.isa = (KernelIsa)i;
+    b.name = "cpu-" + lower(kernelIsaName(b.isa));
+    list.push_back(b);
+  }
+
+  Backend mt;
+  mt.isa = best;
+  mt.threads = ThreadPool::hardwareThreads();
+  mt.name = "cpu-" + lower(kernelIsaName(best)) + "-mt" + std::to_string(mt.threads);
+  if (mt.threads > 1) list.push_back(mt);
+
+  Backend blocked = mt;
+  blocked.blockDepth = 8;
+  blocked.name += "-tb8";
+  list.push_back(blocked);
+
+  for (StoragePrecision p : {StoragePrecision::F16, StoragePrecision::BF16}) {
+    Backend packed = mt;
+    packed.precision = p;
+    packed.name += std::string("-") + storagePrecisionName(p);
+    list.push_back(packed);
+  }
+
+  Backend sparse = mt;
+  sparse.activityMask = true;
+  sparse.name += "-sparse";
+  list.push_back(sparse);
+
+  return list;
+}
+
+#ifdef RD_BENCH_GPU
+static std::vector<Backend> gpuBackends() {
+  std::vector<Backend> list;
+
+  Backend fragment;
+  fragment.gpu = true;
+  fragment.gpuBackend = (i32)GpuBackend::Fragment;
+  fragment.name = "gpu-fragment";
+  list.push_back(fragment);
+
+  Backend compute = fragment;
+  compute.gpuBackend = (i32)GpuBackend::Compute;
+  compute.name = "gpu-compute";
+  list.push_back(compute);
+
+  Backend fused = compute;
+  fused.fusedSteps = 4;
+  fused.name = "gpu-compute-fused4";
+  list.push_back(fused);
+
+  Backend half = compute;
+  half.precision = StoragePrecision::F16;
+  half.name = "gpu-compute-fp16";
+  list.push_back(half);
+
+  Backend sparse = compute;
+  sparse.activityMask = true;
+  sparse.name = "gpu-compute-sparse";
+  list.push_back(sparse);
+
+  return list;
+}
+#endif
+
+static Result measure(
+    const Backend& backend, const Options& opt, i32 size, i32 steps, const Preset& preset,
+    const FrameFn& frame
+) {
+  for (i32 i = 0; i < opt.warmup; ++i) frame();
+
+  // calibrate the repetition length from one timed frame
+  Clock::time_point t0 = Clock::now();
+  frame();
+  f64 frameSeconds = std::chrono::duration<f64>(Clock::now() - t0).count();
+  i32 frames = std::max(1, (i32)(opt.minTime / std::max(frameSeconds, 1e-9)));
+
+  std::vector<f64> seconds;
+  for (i32 r = 0; r < opt.reps; ++r) {
+    t0 = Clock::now();
+    for (i32 f = 0; f < frames; ++f) frame();
+    seconds.push_back(std::chrono::duration<f64>(Clock::now() - t0).count());
+  }
+  std::sort(seconds.begin(), seconds.end());
+
+  Result res;
+  res.backend = backend.name;
+  res.preset = preset.name;
+  res.width = res.height = size;
+  res.stepsPerFrame = steps;
+  res.framesPerRep = frames;
+  res.reps = opt.reps;
+  res.medianSeconds = seconds[seconds.size() / 2];
+  res.minSeconds = seconds.front();
+
+  const f64 cellSteps = (f64)size * size * steps * frames;
+  res.cellsPerSecond = cellSteps / res.medianSeconds;
+  res.nsPerCellStep = 1e9 / res.cellsPerSecond;
+  res.bandwidthGBs = res.cellsPerSecond * bytesPerCellStep(backend) / 1e9;
+  return res;
+}
+
+static Result runCpu(
+    const Backend& b, const Options& opt, i32 size, i32 steps, const Preset& preset
+) {
+  GrayScottSolver solver(size, size);
+  solver.setParams(preset.F, preset.k);
+  solver.setThreadCount(b.threads);
+  solver.setKernelIsa(b.isa);
+  solver.setTemporalBlocking(b.blockDepth);
+  solver.setStoragePrecision(b.precision);
+  solver.setActivityMask(b.activityMask);
+  seedSquares(solver, 1);
+
+  return measure(b, opt, size, steps, preset, [&] { solver.step(steps); });
+}
+
+#ifdef RD_BENCH_GPU
+static Result runGpu(
+    const Backend& b, const Options& opt, i32 size, i32 steps, const Preset& preset
+) {
+  GrayScottSolver seeded(size, size);
+  seedSquares(seeded, 1);
+  GrayScottState state = seeded.state();
+
+  GpuSolver solver(size, size);
+  solver.setParams(preset.F, preset.k);
+  solver.setBackend((GpuBackend)b.gpuBackend);
+  solver.setFusedSteps(b.fusedSteps);
+  solver.setStoragePrecision(b.precision);
+  solver.setActivityMask(b.activityMask);
+  solver.setState(state.u, state.v, state.stride);
+  glFinish();
+
+  // timestamp pairs rather than GL_TIME_ELAPSED, which some drivers (llvmpipe)
+  // do not apply to compute dispatches
+  GLuint queries[2];
+  glGenQueries(2, queries);
+  std::vector<f64> gpuNs;  // per frame
+
+  // glFinish per frame: the timing has to cover execution, not submission
+  Result r = measure(b, opt, size, steps, preset, [&] {
+    glQueryCounter(queries[0], GL_TIMESTAMP);
+    solver.step(steps);
+    glQueryCounter(queries[1], GL_TIMESTAMP);
+    glFinish();
+
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end);
+    gpuNs.push_back((f64)(end - begin));
+  });
+
+  glDeleteQueries(2, queries);
+
+  // median: robust to drivers whose first query result is garbage
+  std::nth_element(gpuNs.begin(), gpuNs.begin() + gpuNs.size() / 2, gpuNs.end());
+  r.gpuNsPerCellStep = gpuNs[gpuNs.size() / 2] / ((f64)size * size * steps);
+  return r;
+}
+#endif
+
+static void writeCsv(std::FILE* f, const std::vector<Result>& results) {
+  std::fprintf(
+      f,
+      "backend,width,height,steps_per_frame,preset,frames_per_rep,reps,median_s,min_s,"
+      "cells_per_s,ns_per_cell_step,bandwidth_gb_s,gpu_ns_per_cell_step\n"
+  );
+  for (const Result& r : results)
+    std::fprintf(
+        f, "%s,%d,%d,%d,%s,%d,%d,%.6f,%.6f,%.4e,%.4f,%.3f,%.4f\n", r.backend.c_str(), r.width,
+        r.height, r.stepsPerFrame, r.preset.c_str(), r.framesPerRep, r.reps, r.medianSeconds,
+        r.minSeconds, r.cellsPerSecond, r.nsPerCellStep, r.bandwidthGBs, r.gpuNsPerCellStep
+    );
+}
+
+static void writeJson(
+    std::FILE* f, const std::vector<Result>& results, const Options& opt,
+    const std::string& glRenderer
+) {
+  std::fprintf(f, "{\n  \"host\": {\n");
+  std::fprintf(f, "    \"cpu\": \"%s\",\n", cpuModelName().c_str());
+  std::fprintf(f, "    \"hardware_threads\": %d,\n", ThreadPool::hardwareThreads());
+  std::fprintf(f, "    \"best_kernel\": \"%s\",\n", kernelIsaName(detectKernelIsa()));
+  std::fprintf(f, "    \"gl_renderer\": \"%s\"\n  },\n", glRenderer.c_str());
+  std::fprintf(
+      f, "  \"config\": {\"warmup_frames\": %d, \"reps\": %d, \"min_rep_seconds\": %g},\n",
+      opt.warmup, opt.reps, opt.minTime
+  );
+  std::fprintf(f, "  \"results\": [\n");
+
+  for (usize i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    std::fprintf(
+        f,
+        "    {\"backend\": \"%s\", \"width\": %d, \"height\": %d, \"steps_per_frame\": %d, "
+        "\"preset\": \"%s\", \"frames_per_rep\": %d, \"reps\": %d, \"median_s\": %.6f, "
+        "\"min_s\": %.6f, \"cells_per_s\": %.4e, \"ns_per_cell_step\": %.4f, "
+        "\"bandwidth_gb_s\": %.3f, \"gpu_ns_per_cell_step\": %.4f}%s\n",
+        r.backend.c_str(), r.width, r.height, r.stepsPerFrame, r.preset.c_str(), r.framesPerRep,
+        r.reps, r.medianSeconds, r.minSeconds, r.cellsPerSecond, r.nsPerCellStep, r.bandwidthGBs,
+        r.gpuNsPerCellStep, i + 1 < results.size() ? "," : ""
+    );
+  }
+
+  std::fprintf(f, "  ]\n}\n");
+}
+
+static bool selected(const Backend& b, const Options& opt) {
+  if (opt.backends.empty()) return true;
+  for (const std::string& filter : opt.backends)
+    if (b.name.find(filter) != std::string::npos) return true;
+  return false;
+}
+
+int main(int argc, char** argv) {
+  Options opt;
+
+  for (i32 i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i], value = argv[i + 1];
+
+    if (key == "--sizes" || key == "--steps") {
+      std::vector<i32>& list = key == "--sizes" ? opt.sizes : opt.steps;
+      list.clear();
+      for (const std::string& item : split(value)) list.push_back(std::atoi(item.c_str()));
+    } else if (key == "--presets") {
+      opt.presets.clear();
+      if (value == "all")
+        for (const Preset& p : PRESETS) opt.presets.push_back(p.name);
+      else
+        opt.presets = split(value);
+    } else if (key == "--backends") {
+      opt.backends = split(value);
+    } else if (key == "--warmup") {
+      opt.warmup = std::atoi(value.c_str());
+    } else if (key == "--reps") {
+      opt.reps = std::max(1, std::atoi(value.c_str()));
+    } else if (key == "--min-time") {
+      opt.minTime = std::atof(value.c_str());
+    } else if (key == "--format") {
+      opt.format = value;
+    } else if (key == "--out") {
+      opt.out = value;
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", key.c_str());
+      return 1;
+    }
+  }
+
+  std::vector<Backend> backends = cpuBackends();
+  std::string glRenderer;
+
+#ifdef RD_BENCH_GPU
+  bool wantGpu = false;
+  for (const Backend& b : gpuBackends()) wantGpu |= selected(b, opt);
+
+  OffscreenContext context;
+  if (wantGpu) {
+    std::string error;
+    if (!context.create(&error)) {
+      std::fprintf(stderr, "%s, skipping GPU backends\n", error.c_str());
+    } else {
+      glRenderer = context.renderer();
+      std::vector<Backend> gpu = gpuBackends();
+      backends.insert(backends.end(), gpu.begin(), gpu.end());
+    }
+  }
+#endif
+
+  std::vector<Result> results;
+
+  for (const Backend& b : backends) {
+    if (!selected(b, opt)) continue;
+
+    for (i32 size : opt.sizes) {
+      for (i32 steps : opt.steps) {
+        for (const std::string& name : opt.presets) {
+          const Preset* preset = nullptr;
+          for (const Preset& p : PRESETS)
+            if (lower(p.name) == lower(name)) preset = &p;
+          if (!preset) {
+            std::fprintf(stderr, "unknown preset %s\n", name.c_str());
+            return 1;
+          }
+
+#ifdef RD_BENCH_GPU
+          Result r = b.gpu ? runGpu(b, opt, size, steps, *preset)
+                           : runCpu(b, opt, size, steps, *preset);
+#else
+          Result r = runCpu(b, opt, size, steps, *preset);
+#endif
+          std::fprintf(
+              stderr, "%-28s %5dx%-5d spf %-3d %-7s %8.3f ns/cell/step %8.2f GB/s\n",
+              r.backend.c_str(), size, size, steps, r.preset.c_str(), r.nsPerCellStep,
+              r.bandwidthGBs
+          );
+          results.push_back(r);
+        }
+      }
+    }
+  }
+
+  std::FILE* f = opt.out.empty() ? stdout : std::fopen(opt.out.c_str(), "w");
+  if (!f) {
+    std::fprintf(stderr, "cannot open %s\n", opt.out.c_str());
+    return 1;
+  }
+
+  if (opt.format == "json")
+    writeJson(f, results, opt, glRenderer);
+  else
+    writeCsv(f, results);
+
+  if (f != stdout) std::fclose(f);
+  return 0;
+}
@@ -0,0 +1,204 @@
+// runs the solver split across local worker processes, checks the result
+// against the single-process solver, and reports strong / weak scaling.
+// usage: reaction_diffusion_distributed [--size N] [--workers N] [--steps N]
+//            [--transport shm|socket] [--seed N] [--scaling 0|1] [--checkpoint FILE]
+//        reaction_diffusion_distributed --worker RANK --workers N --endpoints H:P,H:P,...
+// the second form starts one worker of a run spread over several machines; the
+// coordinator is then started with the same --endpoints (rank N, the last one).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Checkpoint.h"
+#include "DistributedSolver.h"
+#include "GrayScottSolver.h"
+#include "Seeding.h"
+#include "types.h"
+
+struct Options {
+  i32 size = 512, workers = ThreadPool::hardwareThreads(), steps = 1000;
+  TransportKind transport = TransportKind::SharedMemory;
+  u32 seed = 1;
+  bool scaling = true;
+  std::string checkpoint;
+  std::vector<std::string> endpoints;
+  i32 workerRank = -1;
+};
+
+static std::vector<std::string> splitList(const char* list) {
+  std::vector<std::string> items;
+  for (const char* p = list; *p;) {
+    const char* end = std::strchr(p, ',');
+    if (!end) end = p + std::strlen(p);
+    items.emplace_back(p, end);
+    p = *end ? end + 1 : end;
+  }
+  return items;
+}
+
+static f64 now() {
+  return std::chrono::duration<f64>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Timing {
+  f64 seconds = 0;
+  f64 waitShare = 0;  // of the slowest worker's time, blocked on halos
+};
+
+static std::unique_ptr<DistributedSolver> start(
+    const Options& o, i32 width, i32 height, i32 workers, u32 seed
+) {
+  std::string error;
+  auto solver = DistributedSolver::launch(
+      width, height, workers, GrayScottParams{}, o.transport, o.endpoints, &error
+  );
+  if (!solver) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return nullptr;
+  }
+
+  std::vector<f32> u((usize)width * height, 1.0f), v((usize)width * height, 0.0f);
+  seedSquares(u.data(), v.data(), width, height, width, seed);
+  if (!solver->scatter(u.data(), v.data(), width)) {
+    std::fprintf(stderr, "scatter failed\n");
+    return nullptr;
+  }
+  return solver;
+}
+
+static bool timeRun(const Options& o, i32 width, i32 height, i32 workers, Timing& timing) {
+  auto solver = start(o, width, height, workers, o.seed);
+  if (!solver || !solver->step(10)) return false;  // warm-up: page faults, first contact
+
+  const f64 t0 = now();
+  if (!solver->step(o.steps)) return false;
+  timing.seconds = now() - t0;
+
+  const DistributedStepStats& s = solver->lastStepStats();
+  timing.waitShare = s.waitSeconds / std::max(s.computeSeconds + s.waitSeconds, 1e-9);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  for (i32 i = 1; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--size")) o.size = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--workers")) o.workers = std::max(std::atoi(argv[i + 1]), 1);
+    else if (!std::strcmp(argv[i], "--steps")) o.steps = std::max(std::atoi(argv[i + 1]), 1);
+    else if (!std::strcmp(argv[i], "--seed")) o.seed = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--scaling")) o.scaling = std::atoi(argv[i + 1]) != 0;
+    else if (!std::strcmp(argv[i], "--checkpoint")) o.checkpoint = argv[i + 1];
+    else if (!std::strcmp(argv[i], "--endpoints")) o.endpoints = splitList(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--worker")) o.workerRank = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--transport")) {
+      o.transport = std::strcmp(argv[i + 1], "socket") ? TransportKind::SharedMemory
+                                                       : TransportKind::Socket;
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (!o.endpoints.empty()) o.transport = TransportKind::Socket;
+
+  // one worker of a multi-node run
+  if (o.workerRank >= 0) {
+    const i32 r = o.workerRank, n = o.workers;
+    const std::set<i32> peers = {(r + n - 1) % n, (r + 1) % n, n};
+    std::string error;
+    auto transport =
+        SocketTransport::connect(r, o.endpoints, {peers.begin(), peers.end()}, &error);
+    if (!transport) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    return runDistributedWorker(*transport, n);
+  }
+
+  // correctness: the distributed run against the single-process solver
+  {
+    GrayScottSolver ref(o.size, o.size);
+    ref.setThreadCount(1);
+    seedSquares(ref, o.seed);
+    ref.step(o.steps);
+    GrayScottState a = ref.state();
+
+    auto solver = start(o, o.size, o.size, o.workers, o.seed);
+    if (!solver || !solver->step(o.steps)) return 1;
+
+    std::vector<f32> u((usize)o.size * o.size), v((usize)o.size * o.size);
+    if (!solver->gather(u.data(), v.data(), o.size)) {
+      std::fprintf(stderr, "gather failed\n");
+      return 1;
+    }
+
+    usize mismatches = 0;
+    for (i32 y = 0; y < o.size; ++y) {
+      for (i32 x = 0; x < o.size; ++x) {
+        const usize i = (usize)y * o.size + x, j = (usize)y * a.stride + x;
+        mismatches += std::memcmp(&u[i], &a.u[j], 4) != 0 || std::memcmp(&v[i], &a.v[j], 4) != 0;
+      }
+    }
+    std::printf(
+        "%dx%d, %d workers over %s, %d steps: %s (%zu cells differ)\n", o.size, o.size,
+        o.workers, transportName(o.transport), o.steps,
+        mismatches ? "MISMATCH vs single process" : "bit-identical to single process", mismatches
+    );
+
+    if (!o.checkpoint.empty()) {
+      CheckpointState state;
+      state.params = solver->params();
+      state.step = solver->stepCount();
+      state.width = state.height = state.stride = o.size;
+      state.u = u.data();
+      state.v = v.data();
+
+      std::string error;
+      if (!saveCheckpoint(o.checkpoint.c_str(), state, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+      }
+      std::printf("gathered state written to %s\n", o.checkpoint.c_str());
+    }
+    if (mismatches) return 1;
+  }
+
+  if (!o.scaling || !o.endpoints.empty()) return 0;
+
+  // strong: the same grid over more workers. weak: each worker keeps a strip of
+  // size / 4 rows, so the grid grows with the worker count
+  const i32 weakRows = std::max(o.size / 4, 1);
+  std::printf(
+      "\n# Scaling over %s, %d steps (%d hardware threads)\n\n", transportName(o.transport),
+      o.steps, ThreadPool::hardwareThreads()
+  );
+  std::printf(
+      "| Workers | strong %dx%d steps/s | speedup | halo wait | weak %dx(%d/worker) steps/s | "
+      "efficiency | halo wait |\n",
+      o.size, o.size, o.size, weakRows
+  );
+  std::printf("|---:|---:|---:|---:|---:|---:|---:|\n");
+
+  Timing strong1, weak1;
+  for (i32 n = 1; n <= o.workers; ++n) {
+    Timing strong, weak;
+    if (!timeRun(o, o.size, o.size, n, strong) || !timeRun(o, o.size, weakRows * n, n, weak))
+      return 1;
+    if (n == 1) {
+      strong1 = strong;
+      weak1 = weak;
+    }
+
+    std::printf(
+        "| %d | %.0f | %.2fx | %.0f%% | %.0f | %.0f%% | %.0f%% |\n", n, o.steps / strong.seconds,
+        strong1.seconds / strong.seconds, 100.0 * strong.waitShare, o.steps / weak.seconds,
+        100.0 * weak1.seconds / weak.seconds, 100.0 * weak.waitShare
+    );
+  }
+  return 0;
+}
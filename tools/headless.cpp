@@ -0,0 +1,209 @@
+// runs the GPU solver without a window: an EGL context (surfaceless or pbuffer)
+// instead of GLFW, no ImGui, and the grid size given directly instead of being
+// derived from the window and cell size. meant for render farms and CI runners
+// that only have Mesa llvmpipe.
+// usage: reaction_diffusion_headless [--size N|WxH] [--steps N] [--frame-steps N]
+//                                    [--backend fragment|compute] [--preset NAME] [--seed N]
+//                                    [--precision f32|f16] [--image FILE.ppm] [--cell-size PX]
+//                                    [--checkpoint FILE]
+// --image renders the app's display pass (grid.frag) into an FBO, --cell-size
+// pixels per cell. must be run from the repository root (shader paths).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Checkpoint.h"
+#include "GpuSolver.h"
+#include "OffscreenContext.h"
+#include "Presets.h"
+#include "Quad.h"
+#include "Seeding.h"
+#include "Shader.h"
+#include "types.h"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr char VERTEX_SHADER_PATH[] = "shaders/passthrough.vert";
+static constexpr char DISPLAY_SHADER_PATH[] = "shaders/grid.frag";
+
+struct Options {
+  i32 width = 512, height = 512;
+  i32 steps = 10000, frameSteps = 10;
+  GpuBackend backend = GpuBackend::Fragment;
+  std::string preset = "Mazes";
+  u32 seed = 1;
+  StoragePrecision precision = StoragePrecision::F32;
+  std::string image, checkpoint;
+  i32 cellSize = 1;
+};
+
+static bool parseSize(const char* text, i32& width, i32& height) {
+  if (std::sscanf(text, "%dx%d", &width, &height) == 2) return width > 0 && height > 0;
+  width = height = std::atoi(text);
+  return width > 0;
+}
+
+// the display pass into an RGBA8 FBO of (width, height) * cellSize, written as a binary PPM
+static bool writeImage(const std::string& path, const GpuSolver& solver, i32 cellSize) {
+  const i32 w = solver.width() * cellSize, h = solver.height() * cellSize;
+
+  u32 texture, fbo;
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+  glTextureStorage2D(texture, 1, GL_RGBA8, w, h);
+  glCreateFramebuffers(1, &fbo);
+  glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, texture, 0);
+
+  u32 VAO, VBO, EBO;
+  glGenVertexArrays(1, &VAO);
+  glBindVertexArray(VAO);
+  glGenBuffers(1, &VBO);
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), QUAD_VERTICES, GL_STATIC_DRAW);
+  glGenBuffers(1, &EBO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(QUAD_INDICES), QUAD_INDICES, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(f32), (void*)0);
+  glEnableVertexAttribArray(0);
+
+  Shader display(VERTEX_SHADER_PATH, DISPLAY_SHADER_PATH);
+  display.use();
+  display.setVec2("viewOrigin", 0.0f, 0.0f);
+  display.setFloat("cellsPerPixel", 1.0f / cellSize);
+  display.setIVec2("gridSize", solver.width(), solver.height());
+  display.setInt("concentration", 0);
+  display.setIVec2("texelOrigin", 0, 0);
+  display.setIVec2("texelCount", solver.width(), solver.height());
+  display.setInt("level", 0);
+  display.setInt("vChannel", 1);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glViewport(0, 0, w, h);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, solver.texture());
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+  std::vector<u8> pixels((usize)w * h * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  glDeleteProgram(display.id());
+  glDeleteVertexArrays(1, &VAO);
+  glDeleteBuffers(1, &VBO);
+  glDeleteBuffers(1, &EBO);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteTextures(1, &texture);
+
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  std::fprintf(f, "P6\n%d %d\n255\n", w, h);
+  // GL rows are bottom-up
+  for (i32 y = h - 1; y >= 0; --y) std::fwrite(pixels.data() + (usize)y * w * 3, 1, (usize)w * 3, f);
+  return std::fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  for (i32 i = 1; i + 1 < argc; i += 2) {
+    const char* key = argv[i];
+    const char* value = argv[i + 1];
+    bool ok = true;
+
+    if (!std::strcmp(key, "--size")) ok = parseSize(value, o.width, o.height);
+    else if (!std::strcmp(key, "--steps")) o.steps = std::max(std::atoi(value), 0);
+    else if (!std::strcmp(key, "--frame-steps")) o.frameSteps = std::max(std::atoi(value), 1);
+    else if (!std::strcmp(key, "--backend"))
+      o.backend = !std::strcmp(value, "compute") ? GpuBackend::Compute : GpuBackend::Fragment;
+    else if (!std::strcmp(key, "--preset")) o.preset = value;
+    else if (!std::strcmp(key, "--seed")) o.seed = std::atoi(value);
+    else if (!std::strcmp(key, "--precision"))
+      o.precision = !std::strcmp(value, "f16") ? StoragePrecision::F16 : StoragePrecision::F32;
+    else if (!std::strcmp(key, "--image")) o.image = value;
+    else if (!std::strcmp(key, "--cell-size")) o.cellSize = std::clamp(std::atoi(value), 1, 20);
+    else if (!std::strcmp(key, "--checkpoint")) o.checkpoint = value;
+    else ok = false;
+
+    if (!ok) {
+      std::fprintf(stderr, "bad option %s %s\n", key, value);
+      return 1;
+    }
+  }
+
+  const Preset* preset = nullptr;
+  for (const Preset& p : PRESETS)
+    if (p.name == o.preset) preset = &p;
+  if (!preset) {
+    std::fprintf(stderr, "unknown preset %s\n", o.preset.c_str());
+    return 1;
+  }
+
+  OffscreenContext context;
+  std::string error;
+  if (!context.create(&error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  GrayScottSolver seeded(o.width, o.height);
+  seedSquares(seeded, o.seed);
+  GrayScottState state = seeded.state();
+
+  GpuSolver solver(o.width, o.height);
+  solver.setParams(preset->F, preset->k);
+  solver.setBackend(o.backend);
+  solver.setStoragePrecision(o.precision);
+  solver.setState(state.u, state.v, state.stride);
+  glFinish();
+
+  // frames of --frame-steps like the app's render loop, without the display pass
+  auto t0 = Clock::now();
+  for (i32 left = o.steps; left > 0; left -= o.frameSteps) solver.step(std::min(left, o.frameSteps));
+  glFinish();
+  const f64 seconds = std::chrono::duration<f64>(Clock::now() - t0).count();
+
+  std::printf(
+      "%dx%d %s, %s %s on %s\n", o.width, o.height, preset->name.c_str(),
+      GpuSolver::backendName(o.backend), storagePrecisionName(solver.storagePrecision()),
+      context.renderer().c_str()
+  );
+  std::printf(
+      "%d steps in %.3f s: %.1f steps/s, %.3g cell-steps/s\n", o.steps, seconds,
+      o.steps / std::max(seconds, 1e-9), (f64)o.width * o.height * o.steps / std::max(seconds, 1e-9)
+  );
+
+  if (!o.image.empty()) {
+    if (!writeImage(o.image, solver, o.cellSize)) {
+      std::fprintf(stderr, "cannot write %s\n", o.image.c_str());
+      return 1;
+    }
+    std::printf("wrote %s\n", o.image.c_str());
+  }
+
+  if (!o.checkpoint.empty()) {
+    std::vector<f32> planes(2 * (usize)o.width * o.height);
+    solver.getState(planes.data(), planes.data() + (usize)o.width * o.height, o.width);
+
+    CheckpointState cp;
+    cp.params = solver.params();
+    cp.step = solver.stepCount();
+    cp.width = o.width;
+    cp.height = o.height;
+    cp.stride = o.width;
+    cp.precision = solver.storagePrecision();
+    cp.u = planes.data();
+    cp.v = planes.data() + (usize)o.width * o.height;
+    if (!saveCheckpoint(o.checkpoint.c_str(), cp, &error)) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    std::printf("wrote %s\n", o.checkpoint.c_str());
+  }
+  return 0;
+}
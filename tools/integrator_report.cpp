@@ -0,0 +1,132 @@
+// simulated time per wall-second of each integrator and time step, and how far
+// each ends up from explicit Euler at dt = 1, per preset.
+// usage: reaction_diffusion_integrators [--size N] [--time T] [--seed N] [--threads N]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "GrayScottSolver.h"
+#include "Presets.h"
+#include "Seeding.h"
+#include "types.h"
+
+struct Run {
+  Integrator integrator;
+  f32 dt;
+};
+
+struct Divergence {
+  f64 maxAbs = 0, rms = 0;
+  f64 patternMatch = 0;  // fraction of cells on the same side of v = 0.2
+  bool finite = true;
+};
+
+static Divergence compare(GrayScottSolver& ref, GrayScottSolver& test) {
+  GrayScottState a = ref.state(), b = test.state();
+
+  Divergence d;
+  f64 sq = 0;
+  usize same = 0;
+
+  for (i32 y = 0; y < a.height; ++y) {
+    for (i32 x = 0; x < a.width; ++x) {
+      f32 va = a.v[y * a.stride + x], vb = b.v[y * b.stride + x];
+      d.finite &= std::isfinite(vb) && std::isfinite(b.u[y * b.stride + x]);
+      f64 diff = std::fabs((f64)va - vb);
+
+      d.maxAbs = std::max(d.maxAbs, diff);
+      sq += diff * diff;
+      same += (va > 0.2f) == (vb > 0.2f);
+    }
+  }
+
+  usize n = (usize)a.width * a.height;
+  d.rms = std::sqrt(sq / n);
+  d.patternMatch = (f64)same / n;
+  return d;
+}
+
+// advances to simulated time `time` and returns the wall-clock seconds it took
+static f64 advance(GrayScottSolver& solver, f32 time) {
+  const i32 steps = (i32)std::lround(time / solver.params().dt);
+
+  auto t0 = std::chrono::steady_clock::now();
+  solver.step(steps);
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<f64>(t1 - t0).count();
+}
+
+int main(int argc, char** argv) {
+  i32 size = 256, threads = ThreadPool::hardwareThreads();
+  f32 time = 2000;
+  u32 seed = 1;
+
+  for (i32 i = 1; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--size")) size = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--time")) time = (f32)std::atof(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--seed")) seed = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--threads")) threads = std::atoi(argv[i + 1]);
+  }
+
+  const GrayScottParams defaults;
+  const f32 explicitLimit = explicitStableTimeStep(defaults.Du, defaults.Dv);
+
+  // explicit Euler just past its diffusion limit shows what the others buy
+  const std::vector<Run> runs = {
+      {Integrator::Explicit, 1.0f}, {Integrator::Explicit, explicitLimit * 1.05f},
+      {Integrator::Imex, 1.0f},     {Integrator::Imex, 4.0f},
+      {Integrator::Imex, 8.0f},     {Integrator::Imex, 16.0f},
+      {Integrator::Etd, 1.0f},      {Integrator::Etd, 4.0f},
+      {Integrator::Etd, 8.0f},      {Integrator::Etd, 16.0f},
+  };
+
+  std::printf(
+      "# Integrators vs explicit Euler at dt = 1 (%dx%d grid, t = %g, seed %u, %d threads)\n\n",
+      size, size, time, seed, threads
+  );
+  std::printf("| Preset | Integrator | dt | sim time / s | max abs dV | RMS dV | pattern match |\n");
+  std::printf("|---|---|---:|---:|---:|---:|---:|\n");
+
+  for (const Preset& preset : PRESETS) {
+    GrayScottSolver ref(size, size);
+    ref.setParams(preset.F, preset.k);
+    ref.setThreadCount(threads);
+    seedSquares(ref, seed);
+    const f64 refSeconds = advance(ref, time);
+
+    for (const Run& run : runs) {
+      GrayScottSolver test(size, size);
+      test.setParams(preset.F, preset.k);
+      test.setThreadCount(threads);
+      test.setIntegrator(run.integrator);
+      test.setTimeStep(run.dt);
+      seedSquares(test, seed);
+
+      // the reference row is timed once; it matches itself exactly
+      const bool isRef = run.integrator == Integrator::Explicit && run.dt == 1.0f;
+      const f64 seconds = isRef ? refSeconds : advance(test, time);
+      if (isRef) advance(test, time);
+
+      Divergence d = compare(ref, test);
+      if (!d.finite || d.maxAbs > 1.0) {
+        std::printf(
+            "| %s | %s | %.2f | %.0f | unstable | | |\n", preset.name.c_str(),
+            integratorName(run.integrator), run.dt, time / seconds
+        );
+        continue;
+      }
+      std::printf(
+          "| %s | %s | %.2f | %.0f | %.2e | %.2e | %.2f%% |\n", preset.name.c_str(),
+          integratorName(run.integrator), run.dt, time / seconds, d.maxAbs, d.rms,
+          100.0 * d.patternMatch
+      );
+    }
+  }
+
+  return 0;
+}
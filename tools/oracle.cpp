@@ -0,0 +1,566 @@
+// cross-backend oracle: runs two backends from the same seeded state and
+// compares U and V after every step (or every --every steps). each compared
+// step reports max and RMS divergence; the run fails if the max exceeds the
+// tolerance of the pair, which is set by the less precise backend:
+//   exact   0      CPU fp32 explicit Euler (every ISA, threads, temporal blocking,
+//                  the batched sweep, multi-process, out-of-core); all claim
+//                  bit-identity
+//   fp32    1e-4   GPU fp32 and the CPU activity mask (which leaves cells within
+//                  its 1e-4 threshold of rest alone)
+//   fp16    5e-2   fp16 storage, CPU or GPU
+//   bf16    2.5e-1 bf16 storage
+// reduced-precision tolerances hold for a few hundred steps; afterwards the
+// patterns themselves drift apart (see reaction_diffusion_precision).
+// --stroke 1 draws the same brush strokes (a fast line, square dots, an eraser
+// pass) into both backends halfway, which checks that the two stamp the same
+// cells and that sparse backends wake the resting tiles a stroke lands on; only
+// the CPU and GPU solvers take brush input.
+// usage: reaction_diffusion_oracle --a BACKEND --b BACKEND [--size N] [--steps N] [--every N]
+//                                  [--preset NAME] [--seed N] [--tolerance X] [--csv FILE]
+//                                  [--stroke 0|1]
+//        reaction_diffusion_oracle --list
+// exits 1 when the tolerance is exceeded or a backend fails, and 77 (skipped,
+// for ctest) when this machine lacks a backend's ISA or an EGL driver. GPU
+// backends must be run from the repository root (shader paths).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "BrushStamps.h"
+#include "DistributedSolver.h"
+#include "GrayScottSolver.h"
+#include "OutOfCoreSolver.h"
+#include "Presets.h"
+#include "Seeding.h"
+#include "SweepSolver.h"
+#include "types.h"
+
+#ifdef RD_ORACLE_GPU
+#include "GpuSolver.h"
+#include "OffscreenContext.h"
+#endif
+
+static constexpr int EXIT_SKIP = 77;
+
+enum class Tolerance : i32 { Exact = 0, F32, F16, BF16 };
+
+static f64 toleranceValue(Tolerance t) {
+  static constexpr f64 VALUES[] = {0.0, 1e-4, 5e-2, 2.5e-1};
+  return VALUES[(i32)t];
+}
+
+static const char* toleranceName(Tolerance t) {
+  static constexpr const char* NAMES[] = {"exact", "fp32", "fp16", "bf16"};
+  return NAMES[(i32)t];
+}
+
+static Tolerance storageTolerance(StoragePrecision p) {
+  return p == StoragePrecision::F16 ? Tolerance::F16
+       : p == StoragePrecision::BF16 ? Tolerance::BF16
+                                     : Tolerance::Exact;
+}
+
+// one solver behind a common face: starts from the given row-major planes,
+// steps, and copies its state back out row-major
+class Backend {
+ public:
+  virtual ~Backend() = default;
+  virtual void step(i32 n) = 0;
+  virtual void read(f32* u, f32* v) = 0;
+  virtual Tolerance tolerance() const = 0;
+  virtual std::string describe() const = 0;
+  // false if the backend takes no brush input
+  virtual bool applyStamps(const std::vector<BrushStamp>&) { return false; }
+};
+
+class CpuBackend : public Backend {
+ private:
+  GrayScottSolver m_solver;
+  Tolerance m_tolerance;
+
+ public:
+  CpuBackend(
+      i32 size, const Preset& preset, const f32* u, const f32* v, KernelIsa isa, i32 threads,
+      i32 blockDepth, StoragePrecision precision, bool activityMask
+  )
+      : m_solver(size, size) {
+    m_solver.setParams(preset.F, preset.k);
+    m_solver.setKernelIsa(isa);
+    m_solver.setThreadCount(threads);
+    m_solver.setTemporalBlocking(blockDepth);
+    m_solver.setStoragePrecision(precision);
+    m_solver.setActivityMask(activityMask);
+    m_solver.importState(StoragePrecision::F32, u, v);
+
+    m_tolerance = storageTolerance(precision);
+    if (activityMask) m_tolerance = std::max(m_tolerance, Tolerance::F32);
+  }
+
+  void step(i32 n) override { m_solver.step(n); }
+  void read(f32* u, f32* v) override { m_solver.exportState(StoragePrecision::F32, u, v); }
+  Tolerance tolerance() const override { return m_tolerance; }
+  bool applyStamps(const std::vector<BrushStamp>& stamps) override {
+    m_solver.applyStamps(stamps);
+    return true;
+  }
+
+  std::string describe() const override {
+    std::string s = std::string("GrayScottSolver ") + kernelIsaName(m_solver.kernelIsa()) + ", " +
+                    std::to_string(m_solver.threadCount()) + " threads";
+    if (m_solver.temporalBlockDepth() > 1)
+      s += ", blocked x" + std::to_string(m_solver.temporalBlockDepth());
+    if (m_solver.activityMask()) s += ", activity mask";
+    return s + ", " + storagePrecisionName(m_solver.storagePrecision());
+  }
+};
+
+// a one-point SweepSolver; its seed() builds the same field as seedSquares()
+class SweepBackend : public Backend {
+ private:
+  SweepSolver m_sweep;
+
+ public:
+  SweepBackend(i32 size, const Preset& preset, u32 seed)
+      : m_sweep(size, {SweepPoint{preset.F, preset.k}}) {
+    m_sweep.setFlushDenormals(false);
+    m_sweep.seed(seed);
+  }
+
+  void step(i32 n) override { m_sweep.step(n); }
+  void read(f32* u, f32* v) override { m_sweep.copyRun(0, u, v); }
+  Tolerance tolerance() const override { return Tolerance::Exact; }
+  std::string describe() const override {
+    return "SweepSolver, " + std::to_string(SweepSolver::LANES) + " lanes";
+  }
+};
+
+class DistributedBackend : public Backend {
+ private:
+  std::unique_ptr<DistributedSolver> m_solver;
+  i32 m_size;
+
+ public:
+  DistributedBackend(
+      i32 size, const Preset& preset, const f32* u, const f32* v, i32 workers, TransportKind kind,
+      std::string* error
+  )
+      : m_size(size) {
+    GrayScottParams params;
+    params.F = preset.F;
+    params.k = preset.k;
+    m_solver = DistributedSolver::launch(size, size, workers, params, kind, {}, error);
+    if (m_solver && !m_solver->scatter(u, v, size)) {
+      if (error) *error = "scatter failed";
+      m_solver.reset();
+    }
+  }
+
+  bool valid() const { return m_solver != nullptr; }
+  void step(i32 n) override { m_solver->step(n); }
+  void read(f32* u, f32* v) override { m_solver->gather(u, v, m_size); }
+  Tolerance tolerance() const override { return Tolerance::Exact; }
+  std::string describe() const override {
+    return "DistributedSolver, " + std::to_string(m_solver->workerCount()) + " workers over " +
+           transportName(m_solver->transportKind());
+  }
+};
+
+// state in an unlinked temporary file, streamed in tiles far smaller than the
+// grid so the prefetch / write-behind window moves several times per step
+class OutOfCoreBackend : public Backend {
+ private:
+  std::unique_ptr<OutOfCoreSolver> m_solver;
+
+ public:
+  OutOfCoreBackend(i32 size, const Preset& preset, const f32* u, const f32* v, std::string* error) {
+    GrayScottParams params;
+    params.F = preset.F;
+    params.k = preset.k;
+    OutOfCoreOptions options;
+    options.bandRows = 8;
+    options.readAhead = options.writeBehind = 1;
+
+    const std::string path = "rd_oracle_" + std::to_string(::getpid()) + ".grid";
+    m_solver = OutOfCoreSolver::create(path.c_str(), size, size, params, options, error);
+    if (!m_solver) return;
+
+    f32 *dstU = m_solver->u(), *dstV = m_solver->v();
+    for (i32 y = 0; y < size; ++y) {
+      std::copy_n(u + (usize)y * size, size, dstU + (usize)y * m_solver->stride());
+      std::copy_n(v + (usize)y * size, size, dstV + (usize)y * m_solver->stride());
+    }
+  }
+
+  bool valid() const { return m_solver != nullptr; }
+  void step(i32 n) override { m_solver->step(n); }
+  void read(f32* u, f32* v) override {
+    const GrayScottState s = m_solver->state();
+    for (i32 y = 0; y < s.height; ++y) {
+      std::copy_n(s.u + (usize)y * s.stride, s.width, u + (usize)y * s.width);
+      std::copy_n(s.v + (usize)y * s.stride, s.width, v + (usize)y * s.width);
+    }
+  }
+  Tolerance tolerance() const override { return Tolerance::Exact; }
+  std::string describe() const override {
+    return std::string("OutOfCoreSolver ") + kernelIsaName(m_solver->kernelIsa()) + ", " +
+           std::to_string(m_solver->options().bandRows) + "-row tiles";
+  }
+};
+
+#ifdef RD_ORACLE_GPU
+static bool usesGpu(const std::string& name) { return name.rfind("gpu", 0) == 0; }
+
+class GpuSolverBackend : public Backend {
+ private:
+  GpuSolver m_solver;
+  i32 m_size;
+
+ public:
+  GpuSolverBackend(
+      i32 size, const Preset& preset, const f32* u, const f32* v, GpuBackend backend,
+      i32 fusedSteps, StoragePrecision precision, bool activityMask
+  )
+      : m_solver(size, size), m_size(size) {
+    m_solver.setParams(preset.F, preset.k);
+    m_solver.setBackend(backend);
+    m_solver.setFusedSteps(fusedSteps);
+    m_solver.setStoragePrecision(precision);
+    m_solver.setActivityMask(activityMask);
+    m_solver.setState(u, v, size);
+  }
+
+  void step(i32 n) override { m_solver.step(n); }
+  void read(f32* u, f32* v) override { m_solver.getState(u, v, m_size); }
+  Tolerance tolerance() const override {
+    return std::max(storageTolerance(m_solver.storagePrecision()), Tolerance::F32);
+  }
+  bool applyStamps(const std::vector<BrushStamp>& stamps) override {
+    m_solver.applyStamps(stamps);
+    return true;
+  }
+  std::string describe() const override {
+    std::string s = std::string("GpuSolver ") + GpuSolver::backendName(m_solver.backend());
+    if (m_solver.fusedSteps() > 1) s += ", fused x" + std::to_string(m_solver.fusedSteps());
+    if (m_solver.activityMask()) s += ", activity mask";
+    return s + ", " + storagePrecisionName(m_solver.storagePrecision());
+  }
+};
+#endif
+
+static constexpr const char* BACKEND_NAMES[] = {
+    "cpu", "cpu-scalar", "cpu-sse", "cpu-avx2", "cpu-avx512", "cpu-mt", "cpu-blocked",
+    "cpu-sparse", "cpu-fp16", "cpu-bf16", "sweep", "distributed-shm", "distributed-socket",
+    "out-of-core",
+#ifdef RD_ORACLE_GPU
+    "gpu-fragment", "gpu-fragment-fp16", "gpu-compute", "gpu-compute-fused4", "gpu-compute-sparse",
+    "gpu-compute-fp16",
+#endif
+};
+
+struct Options {
+  std::string a = "cpu-scalar", b = "cpu";
+  i32 size = 128, steps = 500, every = 1;
+  std::string preset = "Mazes";
+  u32 seed = 1;
+  f64 tolerance = -1;  // < 0: from the pair
+  std::string csv;
+  bool stroke = false;
+};
+
+// null with `error` set on failure; `unavailable` is set when the machine
+// simply cannot run the backend
+static std::unique_ptr<Backend> makeBackend(
+    const std::string& name, const Options& o, const Preset& preset, const f32* u, const f32* v,
+    std::string* error, bool* unavailable
+) {
+  const i32 threads = std::max(ThreadPool::hardwareThreads(), 2);
+  const KernelIsa best = detectKernelIsa();
+  const auto F32 = StoragePrecision::F32;
+
+  auto cpu = [&](KernelIsa isa, i32 t, i32 depth, StoragePrecision p, bool mask) {
+    return std::make_unique<CpuBackend>(o.size, preset, u, v, isa, t, depth, p, mask);
+  };
+  // an ISA the CPU lacks would silently fall back and compare a kernel with itself
+  auto isa = [&](KernelIsa want) -> std::unique_ptr<Backend> {
+    if (want > best) {
+      if (error) *error = name + " is not supported by this CPU";
+      *unavailable = true;
+      return nullptr;
+    }
+    return cpu(want, 1, 1, F32, false);
+  };
+
+  if (name == "cpu") return cpu(best, 1, 1, F32, false);
+  if (name == "cpu-scalar") return isa(KernelIsa::Scalar);
+  if (name == "cpu-sse") return isa(KernelIsa::SSE);
+  if (name == "cpu-avx2") return isa(KernelIsa::AVX2);
+  if (name == "cpu-avx512") return isa(KernelIsa::AVX512);
+  if (name == "cpu-mt") return cpu(best, threads, 1, F32, false);
+  if (name == "cpu-blocked") return cpu(best, threads, 4, F32, false);
+  if (name == "cpu-sparse") return cpu(best, 1, 1, F32, true);
+  if (name == "cpu-fp16") return cpu(best, 1, 1, StoragePrecision::F16, false);
+  if (name == "cpu-bf16") return cpu(best, 1, 1, StoragePrecision::BF16, false);
+  if (name == "sweep") return std::make_unique<SweepBackend>(o.size, preset, o.seed);
+
+  if (name == "distributed-shm" || name == "distributed-socket") {
+    const TransportKind kind = name == "distributed-shm" ? TransportKind::SharedMemory : TransportKind::Socket;
+    auto d = std::make_unique<DistributedBackend>(o.size, preset, u, v, 3, kind, error);
+    if (!d->valid()) return nullptr;
+    return d;
+  }
+
+  if (name == "out-of-core") {
+    auto b = std::make_unique<OutOfCoreBackend>(o.size, preset, u, v, error);
+    if (!b->valid()) return nullptr;
+    return b;
+  }
+
+#ifdef RD_ORACLE_GPU
+  auto gpu = [&](GpuBackend backend, i32 fused, StoragePrecision p, bool mask) {
+    return std::make_unique<GpuSolverBackend>(o.size, preset, u, v, backend, fused, p, mask);
+  };
+  if (name == "gpu-fragment") return gpu(GpuBackend::Fragment, 1, F32, false);
+  if (name == "gpu-fragment-fp16") return gpu(GpuBackend::Fragment, 1, StoragePrecision::F16, false);
+  if (name == "gpu-compute") return gpu(GpuBackend::Compute, 1, F32, false);
+  if (name == "gpu-compute-fused4") return gpu(GpuBackend::Compute, 4, F32, false);
+  if (name == "gpu-compute-sparse") return gpu(GpuBackend::Compute, 1, F32, true);
+  if (name == "gpu-compute-fp16") return gpu(GpuBackend::Compute, 1, StoragePrecision::F16, false);
+#endif
+
+  if (error) *error = "unknown backend " + name;
+  return nullptr;
+}
+
+// strokes through BrushQueue the way the app records them: one sample per
+// cursor event, far apart so the line interpolation has gaps to fill
+static std::vector<BrushStamp> strokeStamps(i32 size) {
+  const f32 s = (f32)size;
+  BrushQueue queue;
+  BrushEvent e;
+  e.radius = std::max(s / 24, 1.5f);
+
+  for (f32 t : {0.1f, 0.35f, 0.6f, 0.85f}) {
+    e.x = s * t;
+    e.y = s * (0.2f + 0.5f * t);
+    queue.push(e);
+  }
+  queue.endStroke();
+
+  e.shape = BrushShape::Square;
+  for (f32 t : {0.8f, 0.45f}) {
+    e.x = s * t;
+    e.y = s * (1.0f - t);
+    queue.push(e);
+  }
+  queue.endStroke();
+
+  e.shape = BrushShape::Disc;
+  e.u = 1.0f;
+  e.v = 0.0f;
+  for (f32 t : {0.1f, 0.8f}) {
+    e.x = s * (0.25f + 0.1f * t);
+    e.y = s * t;
+    queue.push(e);
+  }
+  return queue.takeFrame();
+}
+
+struct Divergence {
+  f64 maxAbs = 0, rms = 0;
+  i32 worstX = 0, worstY = 0;
+};
+
+// over U and V together
+static Divergence compare(
+    const std::vector<f32>& ua, const std::vector<f32>& va, const std::vector<f32>& ub,
+    const std::vector<f32>& vb, i32 size
+) {
+  Divergence d;
+  f64 sq = 0;
+  usize worst = 0;
+  bool finite = true;
+
+  for (usize i = 0; i < ua.size(); ++i) {
+    const f64 du = std::fabs((f64)ua[i] - ub[i]), dv = std::fabs((f64)va[i] - vb[i]);
+    finite &= std::isfinite(du) && std::isfinite(dv);
+    sq += du * du + dv * dv;
+    if (std::max(du, dv) > d.maxAbs) {
+      d.maxAbs = std::max(du, dv);
+      worst = i;
+    }
+  }
+
+  d.rms = std::sqrt(sq / (2 * ua.size()));
+  d.worstX = (i32)(worst % size);
+  d.worstY = (i32)(worst / size);
+  if (!finite) d.maxAbs = d.rms = INFINITY;
+  return d;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  for (i32 i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--list")) {
+      for (const char* name : BACKEND_NAMES) std::printf("%s\n", name);
+      return 0;
+    }
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "missing value for %s\n", argv[i]);
+      return 1;
+    }
+
+    const char* key = argv[i];
+    const char* value = argv[++i];
+    if (!std::strcmp(key, "--a")) o.a = value;
+    else if (!std::strcmp(key, "--b")) o.b = value;
+    else if (!std::strcmp(key, "--size")) o.size = std::max(std::atoi(value), 8);
+    else if (!std::strcmp(key, "--steps")) o.steps = std::max(std::atoi(value), 1);
+    else if (!std::strcmp(key, "--every")) o.every = std::max(std::atoi(value), 1);
+    else if (!std::strcmp(key, "--preset")) o.preset = value;
+    else if (!std::strcmp(key, "--seed")) o.seed = std::atoi(value);
+    else if (!std::strcmp(key, "--tolerance")) o.tolerance = std::atof(value);
+    else if (!std::strcmp(key, "--csv")) o.csv = value;
+    else if (!std::strcmp(key, "--stroke")) o.stroke = std::atoi(value) != 0;
+    else {
+      std::fprintf(stderr, "unknown option %s\n", key);
+      return 1;
+    }
+  }
+
+  const Preset* preset = nullptr;
+  for (const Preset& p : PRESETS)
+    if (p.name == o.preset) preset = &p;
+  if (!preset) {
+    std::fprintf(stderr, "unknown preset %s\n", o.preset.c_str());
+    return 1;
+  }
+
+#ifdef RD_ORACLE_GPU
+  OffscreenContext context;
+  if (usesGpu(o.a) || usesGpu(o.b)) {
+    std::string error;
+    if (!context.create(&error)) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return EXIT_SKIP;
+    }
+  }
+#endif
+
+  // both start from exactly these planes
+  const usize cells = (usize)o.size * o.size;
+  std::vector<f32> u(cells, 1.0f), v(cells, 0.0f);
+  seedSquares(u.data(), v.data(), o.size, o.size, o.size, o.seed);
+
+  std::string error;
+  bool unavailable = false;
+  std::unique_ptr<Backend> a = makeBackend(o.a, o, *preset, u.data(), v.data(), &error, &unavailable);
+  std::unique_ptr<Backend> b =
+      a ? makeBackend(o.b, o, *preset, u.data(), v.data(), &error, &unavailable) : nullptr;
+  if (!a || !b) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return unavailable ? EXIT_SKIP : 1;
+  }
+
+  const std::vector<BrushStamp> stroke = o.stroke ? strokeStamps(o.size) : std::vector<BrushStamp>{};
+  auto applyStroke = [&] {
+    for (auto [name, backend] : {std::pair{&o.a, a.get()}, std::pair{&o.b, b.get()}}) {
+      if (!backend->applyStamps(stroke)) {
+        std::fprintf(stderr, "%s takes no brush input\n", name->c_str());
+        return false;
+      }
+    }
+    return true;
+  };
+
+  const Tolerance tolerance = std::max(a->tolerance(), b->tolerance());
+  const f64 limit = o.tolerance >= 0 ? o.tolerance : toleranceValue(tolerance);
+
+  std::printf("a: %-18s %s\n", o.a.c_str(), a->describe().c_str());
+  std::printf("b: %-18s %s\n", o.b.c_str(), b->describe().c_str());
+#ifdef RD_ORACLE_GPU
+  if (context.valid()) std::printf("GL renderer: %s\n", context.renderer().c_str());
+#endif
+  std::printf(
+      "%s %dx%d, seed %u, %d steps, compared every %d; tolerance %.3g (%s)\n",
+      preset->name.c_str(), o.size, o.size, o.seed, o.steps, o.every, limit,
+      o.tolerance >= 0 ? "given" : toleranceName(tolerance)
+  );
+  if (o.stroke) std::printf("brush strokes at step %d\n", o.steps / 2);
+
+  std::FILE* csv = nullptr;
+  if (!o.csv.empty()) {
+    csv = std::fopen(o.csv.c_str(), "w");
+    if (!csv) {
+      std::fprintf(stderr, "cannot write %s\n", o.csv.c_str());
+      return 1;
+    }
+    std::fprintf(csv, "step,max_abs,rms\n");
+  }
+
+  std::vector<f32> ua(cells), va(cells), ub(cells), vb(cells);
+  Divergence worst;
+  i32 worstStep = 0, firstFailure = 0;
+
+  // prints a row on the first divergence, on failure and at powers of two
+  i32 nextReport = 1;
+  bool diverged = false;
+  std::printf("%8s %12s %12s\n", "step", "max abs", "RMS");
+
+  const i32 strokeStep = o.steps / 2;
+  for (i32 s = 0; s < o.steps;) {
+    if (o.stroke && s == strokeStep && !applyStroke()) return 1;
+
+    i32 n = std::min(o.every, o.steps - s);
+    if (o.stroke && s < strokeStep) n = std::min(n, strokeStep - s);
+    a->step(n);
+    b->step(n);
+    s += n;
+
+    a->read(ua.data(), va.data());
+    b->read(ub.data(), vb.data());
+    const Divergence d = compare(ua, va, ub, vb, o.size);
+    if (csv) std::fprintf(csv, "%d,%.6e,%.6e\n", s, d.maxAbs, d.rms);
+
+    const bool failed = !(d.maxAbs <= limit);
+    const bool first = d.maxAbs > 0 && !diverged;
+    if (failed && !firstFailure) firstFailure = s;
+    diverged |= d.maxAbs > 0;
+
+    if (s >= nextReport || first || (failed && firstFailure == s) || s == o.steps) {
+      std::printf(
+          "%8d %12.4e %12.4e%s%s\n", s, d.maxAbs, d.rms, first ? "  first divergence" : "",
+          failed && firstFailure == s ? "  EXCEEDS TOLERANCE" : ""
+      );
+      while (nextReport <= s) nextReport *= 2;
+    }
+
+    if (!(d.maxAbs <= worst.maxAbs)) {
+      worst = d;
+      worstStep = s;
+    }
+  }
+  if (csv) std::fclose(csv);
+
+  if (!diverged) {
+    std::printf("PASS: bit-identical for all %d steps\n", o.steps);
+    return 0;
+  }
+  std::printf(
+      "worst: step %d, max abs %.4e at (%d, %d), RMS %.4e\n", worstStep, worst.maxAbs, worst.worstX,
+      worst.worstY, worst.rms
+  );
+  if (firstFailure) {
+    std::printf("FAIL: tolerance %.3g first exceeded at step %d\n", limit, firstFailure);
+    return 1;
+  }
+  std::printf("PASS: within tolerance %.3g\n", limit);
+  return 0;
+}
@@ -0,0 +1,183 @@
+// runs the out-of-core solver (state in a memory-mapped file, streamed in row
+// tiles) against the in-memory one: checks that they agree bit for bit, then
+// reports throughput for each grid size and how much of the file stayed resident.
+// usage: reaction_diffusion_outofcore [--sizes N,N,...] [--steps N] [--file PATH]
+//            [--band-rows N] [--read-ahead N] [--write-behind N] [--threads N] [--seed N]
+// the file is created at --file (default: rd_outofcore.grid in the working
+// directory) and unlinked right away; it needs 16 bytes per cell of disk.
+// in-memory runs are skipped for grids whose 16 bytes per cell exceed the
+// memory currently available.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "GrayScottSolver.h"
+#include "OutOfCoreSolver.h"
+#include "Seeding.h"
+#include "types.h"
+
+struct Options {
+  std::vector<i32> sizes = {1024, 4096};
+  i32 steps = 20, threads = 1;
+  std::string file = "rd_outofcore.grid";
+  OutOfCoreOptions tiles;
+  u32 seed = 1;
+};
+
+static std::vector<i32> parseSizes(const char* list) {
+  std::vector<i32> sizes;
+  for (const char* p = list; *p;) {
+    sizes.push_back(std::max(std::atoi(p), 1));
+    const char* comma = std::strchr(p, ',');
+    if (!comma) break;
+    p = comma + 1;
+  }
+  return sizes;
+}
+
+static f64 now() {
+  return std::chrono::duration<f64>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// MemAvailable counts the page cache the kernel can reclaim, which the
+// out-of-core runs fill; free pages alone would understate it
+static f64 availableBytes() {
+  if (FILE* f = std::fopen("/proc/meminfo", "r")) {
+    char line[128];
+    long long kb = -1;
+    while (kb < 0 && std::fgets(line, sizeof(line), f))
+      std::sscanf(line, "MemAvailable: %lld", &kb);
+    std::fclose(f);
+    if (kb >= 0) return 1024.0 * kb;
+  }
+  return (f64)::sysconf(_SC_AVPHYS_PAGES) * (f64)::sysconf(_SC_PAGESIZE);
+}
+
+static std::unique_ptr<OutOfCoreSolver> start(const Options& o, i32 size) {
+  std::string error;
+  auto solver = OutOfCoreSolver::create(o.file.c_str(), size, size, {}, o.tiles, &error);
+  if (!solver) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return nullptr;
+  }
+  solver->setThreadCount(o.threads);
+  seedSquares(solver->u(), solver->v(), size, size, solver->stride(), o.seed);
+  return solver;
+}
+
+static std::string megabytes(f64 bytes) {
+  constexpr f64 MiB = 1024.0 * 1024, GiB = 1024 * MiB;
+  char s[32];
+  if (bytes < GiB)
+    std::snprintf(s, sizeof(s), "%.0f MiB", bytes / MiB);
+  else
+    std::snprintf(s, sizeof(s), "%.1f GiB", bytes / GiB);
+  return s;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  for (i32 i = 1; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--sizes")) o.sizes = parseSizes(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--steps")) o.steps = std::max(std::atoi(argv[i + 1]), 1);
+    else if (!std::strcmp(argv[i], "--file")) o.file = argv[i + 1];
+    else if (!std::strcmp(argv[i], "--band-rows")) o.tiles.bandRows = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--read-ahead")) o.tiles.readAhead = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--write-behind")) o.tiles.writeBehind = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--threads")) o.threads = std::max(std::atoi(argv[i + 1]), 1);
+    else if (!std::strcmp(argv[i], "--seed")) o.seed = std::atoi(argv[i + 1]);
+    else {
+      std::fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  // correctness: a grid of several tiles against the in-memory solver
+  {
+    const i32 size = 256, steps = 100;
+    GrayScottSolver ref(size, size);
+    ref.setThreadCount(o.threads);
+    seedSquares(ref, o.seed);
+    ref.step(steps);
+    GrayScottState a = ref.state();
+
+    Options small = o;
+    small.tiles.bandRows = std::min(o.tiles.bandRows, size / 4);
+    auto solver = start(small, size);
+    if (!solver) return 1;
+    solver->step(steps);
+    GrayScottState b = solver->state();
+
+    usize mismatches = 0;
+    for (i32 y = 0; y < size; ++y) {
+      const usize i = (usize)y * a.stride, j = (usize)y * b.stride;
+      mismatches += std::memcmp(a.u + i, b.u + j, size * sizeof(f32)) != 0 ||
+                    std::memcmp(a.v + i, b.v + j, size * sizeof(f32)) != 0;
+    }
+    std::printf(
+        "%dx%d, %d-row tiles, %d steps: %s (%zu rows differ)\n", size, size,
+        small.tiles.bandRows, steps,
+        mismatches ? "MISMATCH vs in-memory" : "bit-identical to in-memory", mismatches
+    );
+    if (mismatches) return 1;
+  }
+
+  std::printf(
+      "\n# Out-of-core vs in-memory, %d steps, %d-row tiles, read-ahead %d, write-behind %d, "
+      "%d threads\n\n",
+      o.steps, o.tiles.bandRows, o.tiles.readAhead, o.tiles.writeBehind, o.threads
+  );
+  std::printf(
+      "| Grid | file | in-memory steps/s | out-of-core steps/s | vs in-memory | resident | "
+      "I/O MB/s | writeback wait |\n"
+  );
+  std::printf("|---|---:|---:|---:|---:|---:|---:|---:|\n");
+
+  for (i32 size : o.sizes) {
+    auto solver = start(o, size);
+    if (!solver) return 1;
+    solver->step(1);  // warm-up: the seeded pages, first contact with the file
+
+    const f64 t0 = now();
+    solver->step(o.steps);
+    const f64 outOfCore = now() - t0;
+    const OutOfCoreStats s = solver->lastStepStats();  // outlives the solver
+    const f64 io = (f64)(s.bytesPrefetched + s.bytesWritten);
+    const std::string file = megabytes((f64)solver->fileBytes());
+    const std::string resident = megabytes((f64)s.peakResidentBytes);
+    solver.reset();
+
+    std::string inMemory = "does not fit", ratio = "-";
+    if (16.0 * size * size < 0.8 * availableBytes()) {
+      GrayScottSolver ref(size, size);
+      ref.setThreadCount(o.threads);
+      seedSquares(ref, o.seed);
+      ref.step(1);
+
+      const f64 t1 = now();
+      ref.step(o.steps);
+      const f64 seconds = now() - t1;
+
+      char buf[32];
+      std::snprintf(buf, sizeof(buf), "%.2f", o.steps / seconds);
+      inMemory = buf;
+      std::snprintf(buf, sizeof(buf), "%.2fx", seconds / outOfCore);
+      ratio = buf;
+    }
+
+    std::printf(
+        "| %dx%d | %s | %s | %.2f | %s | %s | %.0f | %.0f%% |\n", size, size, file.c_str(),
+        inMemory.c_str(), o.steps / outOfCore, ratio.c_str(), resident.c_str(),
+        io / outOfCore / 1e6, 100.0 * s.evictSeconds / outOfCore
+    );
+    std::fflush(stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+// accuracy of reduced-precision storage against the fp32 solver, per preset.
+// usage: reaction_diffusion_precision [--size N] [--steps N] [--seed N]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "GrayScottSolver.h"
+#include "Presets.h"
+#include "Seeding.h"
+#include "types.h"
+
+struct Divergence {
+  f64 maxAbs = 0, rms = 0;
+  f64 patternMatch = 0;  // fraction of cells on the same side of v = 0.2
+};
+
+static Divergence compare(GrayScottSolver& ref, GrayScottSolver& test) {
+  GrayScottState a = ref.state(), b = test.state();
+
+  Divergence d;
+  f64 sq = 0;
+  usize same = 0;
+
+  for (i32 y = 0; y < a.height; ++y) {
+    for (i32 x = 0; x < a.width; ++x) {
+      f32 va = a.v[y * a.stride + x], vb = b.v[y * b.stride + x];
+      f64 diff = std::fabs((f64)va - vb);
+
+      d.maxAbs = std::max(d.maxAbs, diff);
+      sq += diff * diff;
+      same += (va > 0.2f) == (vb > 0.2f);
+    }
+  }
+
+  usize n = (usize)a.width * a.height;
+  d.rms = std::sqrt(sq / n);
+  d.patternMatch = (f64)same / n;
+  return d;
+}
+
+int main(int argc, char** argv) {
+  i32 size = 256, steps = 5000;
+  u32 seed = 1;
+
+  for (i32 i = 1; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--size")) size = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--steps")) steps = std::atoi(argv[i + 1]);
+    else if (!std::strcmp(argv[i], "--seed")) seed = std::atoi(argv[i + 1]);
+  }
+
+  const i32 checkpoints[] = {steps / 10, steps / 2, steps};
+
+  std::printf("# Storage precision vs fp32 (%dx%d grid, seed %u)\n\n", size, size, seed);
+  std::printf("| Preset | Storage | Steps | max abs dV | RMS dV | pattern match |\n");
+  std::printf("|---|---|---:|---:|---:|---:|\n");
+
+  for (const Preset& preset : PRESETS) {
+    for (StoragePrecision p : {StoragePrecision::F16, StoragePrecision::BF16}) {
+      GrayScottSolver ref(size, size), test(size, size);
+      test.setStoragePrecision(p);
+
+      for (GrayScottSolver* s : {&ref, &test}) {
+        s->setParams(preset.F, preset.k);
+        s->setThreadCount(ThreadPool::hardwareThreads());
+        seedSquares(*s, seed);
+      }
+
+      i32 done = 0;
+      for (i32 checkpoint : checkpoints) {
+        ref.step(checkpoint - done);
+        test.step(checkpoint - done);
+        done = checkpoint;
+
+        Divergence d = compare(ref, test);
+        std::printf(
+            "| %s | %s | %d | %.2e | %.2e | %.2f%% |\n", preset.name.c_str(),
+            storagePrecisionName(p), checkpoint, d.maxAbs, d.rms, 100.0 * d.patternMatch
+        );
+      }
+    }
+  }
+
+  return 0;
+}
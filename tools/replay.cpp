@@ -0,0 +1,81 @@
+// plays back a field recording: lists its frames and optionally writes V of
+// each one as a PGM image (upscaled to the full size for downsampled frames).
+// usage: reaction_diffusion_replay FILE [--pgm DIR] [--every N]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "FieldRecorder.h"
+#include "types.h"
+
+static bool writePgm(const std::string& path, const RecordedFrame& frame, i32 width, i32 height) {
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+
+  std::fprintf(f, "P5\n%d %d\n255\n", width, height);
+
+  // rows top-down, the grid is stored bottom-up; nearest for half-size frames
+  const i32 shift = frame.downsampled ? 1 : 0;
+  std::vector<u8> row(width);
+  for (i32 y = height - 1; y >= 0; --y) {
+    const f32* src = frame.v.data() + (usize)(y >> shift) * frame.width;
+    for (i32 x = 0; x < width; ++x)
+      row[x] = (u8)(std::clamp(src[x >> shift], 0.0f, 1.0f) * 255.0f + 0.5f);
+    std::fwrite(row.data(), 1, row.size(), f);
+  }
+
+  return std::fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s FILE [--pgm DIR] [--every N]\n", argv[0]);
+    return 1;
+  }
+
+  std::string pgmDir;
+  i32 every = 1;
+  for (i32 i = 2; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--pgm")) pgmDir = argv[i + 1];
+    else if (!std::strcmp(argv[i], "--every")) every = std::max(std::atoi(argv[i + 1]), 1);
+  }
+
+  std::string error;
+  auto reader = FieldReader::open(argv[1], &error);
+  if (!reader) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  const RecordingHeader& h = reader->header();
+  std::printf(
+      "%dx%d, %d-bit, %s, a frame every %d steps\n", h.width, h.height, h.bits,
+      h.fields == 2 ? "V + U" : "V", h.interval
+  );
+
+  RecordedFrame frame;
+  i32 frames = 0, keys = 0, downsampled = 0;
+  for (; reader->next(frame); ++frames) {
+    keys += frame.key;
+    downsampled += frame.downsampled;
+
+    if (!pgmDir.empty() && frames % every == 0) {
+      char name[64];
+      std::snprintf(name, sizeof(name), "/frame_%06d.pgm", frames);
+      if (!writePgm(pgmDir + name, frame, h.width, h.height)) {
+        std::fprintf(stderr, "cannot write %s%s\n", pgmDir.c_str(), name);
+        return 1;
+      }
+    }
+  }
+
+  std::printf(
+      "%d frames (%d key, %d downsampled), last step %llu\n", frames, keys, downsampled,
+      (unsigned long long)frame.step
+  );
+  return 0;
+}
@@ -0,0 +1,253 @@
+// maps the (F, k) plane: runs a grid of small simulations as one batch, then
+// writes a thumbnail sheet of their V fields and a CSV of per-run metrics.
+// usage: reaction_diffusion_sweep [--f MIN,MAX,N] [--k MIN,MAX,N] [--size N] [--steps N]
+//                                 [--interval N] [--seed N] [--threads N] [--backend cpu|gpu]
+//                                 [--flush-denormals 0|1] [--out PREFIX] [--verify 0|1]
+// writes PREFIX.pgm (F grows to the right, k downwards) and PREFIX.csv.
+// the GPU backend needs an EGL driver and must be run from the repository root.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "GrayScottSolver.h"
+#include "Seeding.h"
+#include "SweepSolver.h"
+#include "types.h"
+
+#ifdef RD_SWEEP_GPU
+#include "GpuSweep.h"
+#include "OffscreenContext.h"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+struct Axis {
+  f32 min, max;
+  i32 count;
+};
+
+struct Options {
+  Axis f{0.010f, 0.070f, 16};
+  Axis k{0.040f, 0.070f, 16};
+  i32 size = 128, steps = 5000, interval = 100;
+  u32 seed = 1;
+  i32 threads = ThreadPool::hardwareThreads();
+  bool gpu = false;
+  bool verify = true;
+  bool flushDenormals = true;
+  std::string out = "sweep";
+};
+
+static bool parseAxis(const char* text, Axis& axis) {
+  return std::sscanf(text, "%f,%f,%d", &axis.min, &axis.max, &axis.count) == 3 && axis.count > 0;
+}
+
+// V of every run after `steps` and `interval` steps earlier, row-major
+struct SweepResult {
+  std::vector<std::vector<f32>> v, earlierV;
+  f64 seconds = 0;
+};
+
+// runs all points through `sim` (SweepSolver or GpuSweep); `finish` waits for
+// queued work so the clock covers it
+template <typename Sim, typename Finish>
+static void advance(Sim& sim, const Options& o, i32 first, SweepResult& result, Finish finish) {
+  const usize cells = (usize)o.size * o.size;
+  std::vector<f32> u(cells);
+  const i32 interval = std::min(o.interval, o.steps);
+
+  sim.seed(o.seed);
+  auto t0 = Clock::now();
+  sim.step(o.steps - interval);
+  finish();
+  result.seconds += std::chrono::duration<f64>(Clock::now() - t0).count();
+
+  for (i32 r = 0; r < sim.runCount(); ++r)
+    sim.copyRun(r, u.data(), result.earlierV[first + r].data());
+
+  t0 = Clock::now();
+  sim.step(interval);
+  finish();
+  result.seconds += std::chrono::duration<f64>(Clock::now() - t0).count();
+
+  for (i32 r = 0; r < sim.runCount(); ++r) sim.copyRun(r, u.data(), result.v[first + r].data());
+}
+
+static bool writeSheet(const std::string& path, const Options& o, const SweepResult& result) {
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+
+  // one pixel of background between thumbnails
+  const i32 pitch = o.size + 1;
+  const i32 width = o.f.count * pitch - 1, height = o.k.count * pitch - 1;
+  std::fprintf(f, "P5\n%d %d\n255\n", width, height);
+
+  std::vector<u8> row(width);
+  for (i32 py = 0; py < height; ++py) {
+    std::fill(row.begin(), row.end(), 64);
+    const i32 tileY = py / pitch, y = o.size - 1 - py % pitch;  // grid rows are bottom-up
+    if (py % pitch < o.size) {
+      for (i32 tileX = 0; tileX < o.f.count; ++tileX) {
+        const f32* v = result.v[tileY * o.f.count + tileX].data() + (usize)y * o.size;
+        u8* dst = row.data() + tileX * pitch;
+        for (i32 x = 0; x < o.size; ++x) {
+          const f32 value = std::isfinite(v[x]) ? std::clamp(v[x] * 2.5f, 0.0f, 1.0f) : 0.0f;
+          dst[x] = (u8)(value * 255.0f + 0.5f);
+        }
+      }
+    }
+    std::fwrite(row.data(), 1, row.size(), f);
+  }
+  return std::fclose(f) == 0;
+}
+
+static bool writeCsv(
+    const std::string& path, const std::vector<SweepPoint>& points,
+    const std::vector<SweepMetrics>& metrics
+) {
+  std::FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) return false;
+
+  std::fprintf(f, "F,k,outcome,mean_v,coverage,contrast,drift\n");
+  for (usize i = 0; i < points.size(); ++i) {
+    const SweepMetrics& m = metrics[i];
+    std::fprintf(
+        f, "%.5f,%.5f,%s,%.6f,%.6f,%.6f,%.3e\n", points[i].F, points[i].k,
+        sweepOutcomeName(m.outcome), m.meanV, m.coverage, m.contrast, m.drift
+    );
+  }
+  return std::fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  for (i32 i = 1; i + 1 < argc; i += 2) {
+    const char* key = argv[i];
+    const char* value = argv[i + 1];
+    bool ok = true;
+
+    if (!std::strcmp(key, "--f")) ok = parseAxis(value, o.f);
+    else if (!std::strcmp(key, "--k")) ok = parseAxis(value, o.k);
+    else if (!std::strcmp(key, "--size")) o.size = std::max(std::atoi(value), 4);
+    else if (!std::strcmp(key, "--steps")) o.steps = std::max(std::atoi(value), 1);
+    else if (!std::strcmp(key, "--interval")) o.interval = std::max(std::atoi(value), 1);
+    else if (!std::strcmp(key, "--seed")) o.seed = std::atoi(value);
+    else if (!std::strcmp(key, "--threads")) o.threads = std::max(std::atoi(value), 1);
+    else if (!std::strcmp(key, "--backend")) o.gpu = !std::strcmp(value, "gpu");
+    else if (!std::strcmp(key, "--out")) o.out = value;
+    else if (!std::strcmp(key, "--verify")) o.verify = std::atoi(value) != 0;
+    else if (!std::strcmp(key, "--flush-denormals")) o.flushDenormals = std::atoi(value) != 0;
+    else ok = false;
+
+    if (!ok) {
+      std::fprintf(stderr, "bad option %s %s\n", key, value);
+      return 1;
+    }
+  }
+
+  const std::vector<SweepPoint> points =
+      sweepGrid(o.f.min, o.f.max, o.f.count, o.k.min, o.k.max, o.k.count);
+  const i32 runs = (i32)points.size();
+  const usize cells = (usize)o.size * o.size;
+
+  SweepResult result;
+  result.v.assign(runs, std::vector<f32>(cells));
+  result.earlierV.assign(runs, std::vector<f32>(cells));
+  std::string backend;
+
+  if (!o.gpu) {
+    SweepSolver sweep(o.size, points);
+    sweep.setThreadCount(o.threads);
+    sweep.setFlushDenormals(o.flushDenormals);
+    advance(sweep, o, 0, result, [] {});
+    backend = "CPU, " + std::to_string(SweepSolver::LANES) + " lanes, " +
+              std::to_string(o.threads) + " threads" +
+              (o.flushDenormals ? ", denormals flushed" : "");
+  } else {
+#ifdef RD_SWEEP_GPU
+    OffscreenContext context;
+    std::string error;
+    if (!context.create(&error)) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+
+    // as many layers per texture array as the driver allows
+    for (i32 first = 0; first < runs; first += GpuSweep::maxLayers()) {
+      const i32 count = std::min(runs - first, GpuSweep::maxLayers());
+      std::vector<SweepPoint> chunk(points.begin() + first, points.begin() + first + count);
+      GpuSweep sweep(o.size, chunk);
+      advance(sweep, o, first, result, [] { glFinish(); });
+    }
+    backend = "GPU, " + context.renderer();
+#else
+    std::fprintf(stderr, "built without GPU support\n");
+    return 1;
+#endif
+  }
+
+  std::vector<SweepMetrics> metrics(runs);
+  i32 outcomes[(i32)SweepOutcome::Count] = {};
+  for (i32 r = 0; r < runs; ++r) {
+    metrics[r] = measureSweepRun(
+        result.v[r].data(), result.earlierV[r].data(), o.size, std::min(o.interval, o.steps)
+    );
+    ++outcomes[(i32)metrics[r].outcome];
+  }
+
+  std::printf(
+      "%d runs (%d F x %d k) of %dx%d, %d steps on %s\n", runs, o.f.count, o.k.count, o.size,
+      o.size, o.steps, backend.c_str()
+  );
+  std::printf(
+      "%.2f s: %.0f simulations/hour, %.3g cell-steps/s\n", result.seconds,
+      runs / result.seconds * 3600.0, (f64)runs * cells * o.steps / result.seconds
+  );
+  for (i32 i = 0; i < (i32)SweepOutcome::Count; ++i)
+    if (outcomes[i]) std::printf("  %-9s %d\n", sweepOutcomeName((SweepOutcome)i), outcomes[i]);
+
+  // first and last run against the single-grid solver, which also times what
+  // the sweep would cost one simulation at a time (on the same threads)
+  if (o.verify) {
+    f64 refSeconds = 0;
+    for (i32 r : {0, runs - 1}) {
+      GrayScottSolver ref(o.size, o.size);
+      ref.setParams(points[r].F, points[r].k);
+      ref.setThreadCount(o.threads);
+      seedSquares(ref, o.seed);
+
+      auto t0 = Clock::now();
+      ref.step(o.steps);
+      refSeconds += std::chrono::duration<f64>(Clock::now() - t0).count();
+      GrayScottState s = ref.state();
+
+      f64 maxDiff = 0;
+      for (i32 y = 0; y < o.size; ++y) {
+        for (i32 x = 0; x < o.size; ++x) {
+          const f32 a = s.v[y * s.stride + x], b = result.v[r][(usize)y * o.size + x];
+          maxDiff = std::max(maxDiff, (f64)std::fabs(a - b));
+        }
+      }
+      std::printf(
+          "run %d (F %.4f, k %.4f) vs GrayScottSolver: max abs dV %.3g%s\n", r, points[r].F,
+          points[r].k, maxDiff, maxDiff == 0 ? " (bit-identical)" : ""
+      );
+    }
+    std::printf(
+        "one at a time with GrayScottSolver: %.0f simulations/hour\n", 2 / refSeconds * 3600.0
+    );
+  }
+
+  if (!writeSheet(o.out + ".pgm", o, result) || !writeCsv(o.out + ".csv", points, metrics)) {
+    std::fprintf(stderr, "cannot write %s.pgm / %s.csv\n", o.out.c_str(), o.out.c_str());
+    return 1;
+  }
+  std::printf("wrote %s.pgm and %s.csv\n", o.out.c_str(), o.out.c_str());
+  return 0;
+}
@@ -0,0 +1,114 @@
+// the app's startup auto-tuner from the command line: times every candidate
+// on the given grid, prints them fastest first and stores the winner in the
+// tuning cache the app reads at startup.
+// usage: reaction_diffusion_tune [--size N|WxH] [--frame-steps N] [--seconds S]
+//                                [--reduced-precision 0|1] [--cache FILE] [--cpu-only 1]
+// the GPU candidates need an EGL driver and must be run from the repository
+// root (shader paths). without them the key's renderer is "none", which the
+// app never looks up, so a CPU-only run does not shadow a GPU result.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AutoTuner.h"
+#include "types.h"
+
+#ifdef RD_TUNE_GPU
+#include "GpuTuner.h"
+#include "OffscreenContext.h"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static bool parseSize(const char* text, i32& width, i32& height) {
+  if (std::sscanf(text, "%dx%d", &width, &height) == 2) return width > 0 && height > 0;
+  width = height = std::atoi(text);
+  return width > 0;
+}
+
+int main(int argc, char** argv) {
+  // the app's default grid: a 1920x1080 window at cell size 10
+  i32 width = 192, height = 108;
+  TuningOptions options;
+  std::string cache = defaultTuningCachePath();
+  bool cpuOnly = false;
+
+  for (i32 i = 1; i + 1 < argc; i += 2) {
+    const char* key = argv[i];
+    const char* value = argv[i + 1];
+    bool ok = true;
+
+    if (!std::strcmp(key, "--size")) ok = parseSize(value, width, height);
+    else if (!std::strcmp(key, "--frame-steps"))
+      options.stepsPerFrame = std::max(std::atoi(value), 1);
+    else if (!std::strcmp(key, "--seconds"))
+      options.secondsPerCandidate = std::max(std::atof(value), 0.0);
+    else if (!std::strcmp(key, "--reduced-precision"))
+      options.allowReducedPrecision = std::atoi(value) != 0;
+    else if (!std::strcmp(key, "--cache")) cache = value;
+    else if (!std::strcmp(key, "--cpu-only")) cpuOnly = std::atoi(value) != 0;
+    else ok = false;
+
+    if (!ok) {
+      std::fprintf(stderr, "bad option %s %s\n", key, value);
+      return 1;
+    }
+  }
+
+  TuningKey key{cpuModelName(), "none", width, height};
+  const auto t0 = Clock::now();
+  const std::vector<f32> state = tuningState(width, height, options);
+  std::vector<TuningCandidate> candidates = tuneCpu(width, height, state, options);
+
+#ifdef RD_TUNE_GPU
+  OffscreenContext context;
+  std::string contextError;
+  if (!cpuOnly && context.create(&contextError)) {
+    key.glRenderer = glRendererName();
+    const std::vector<TuningCandidate> gpu = tuneGpu(width, height, state, options);
+    candidates.insert(candidates.end(), gpu.begin(), gpu.end());
+  } else if (!cpuOnly) {
+    std::fprintf(stderr, "no GPU candidates: %s\n", contextError.c_str());
+  }
+#else
+  (void)cpuOnly;
+#endif
+
+  const f64 seconds = std::chrono::duration<f64>(Clock::now() - t0).count();
+  std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+    return a.config.stepsPerSecond > b.config.stepsPerSecond;
+  });
+
+  std::printf("%dx%d on %s / %s\n", width, height, key.cpu.c_str(), key.glRenderer.c_str());
+  for (const TuningCandidate& c : candidates)
+    std::printf("  %10.1f steps/s  %s\n", c.config.stepsPerSecond, c.name.c_str());
+
+  const TunedConfig best = pickTunedConfig(candidates);
+  std::printf(
+      "%zu candidates in %.2f s; %d steps per frame keeps %.0f fps\n", candidates.size(), seconds,
+      best.stepsPerFrame, TUNING_TARGET_FPS
+  );
+
+  std::string error;
+  if (!saveTunedConfig(cache.c_str(), key, best, &error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  // what the app pays at startup once the entry exists
+  TunedConfig loaded;
+  const auto l0 = Clock::now();
+  const bool found = loadTunedConfig(cache.c_str(), key, loaded);
+  const f64 loadMs = std::chrono::duration<f64, std::milli>(Clock::now() - l0).count();
+  if (!found) {
+    std::fprintf(stderr, "cannot read back %s\n", cache.c_str());
+    return 1;
+  }
+  std::printf("wrote %s (reloads in %.3f ms)\n", cache.c_str(), loadMs);
+  return 0;
+}